@@ -0,0 +1,127 @@
+/**
+ * Exports columnar record logs (see `common/columnar_log.hpp`) after a run.
+ *
+ *     main.opt.exe csv <log>                  writes one log to stdout, with a header row
+ *     main.opt.exe sqlite <database> <log>... writes each log to a table of its own
+ *
+ * Times and durations come out as integer nanoseconds, as `sqlite_record_logger` writes them.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "common/columnar_log.hpp"
+#include "../runtime/sqlite3pp/sqlite3pp.hpp"
+
+using namespace ILLIXR;
+using columnar_log_format::column_type;
+
+static void write_csv(const columnar_log_reader& log, std::ostream& out) {
+	const auto& columns = log.columns();
+	for (std::size_t i = 0; i < columns.size(); ++i) {
+		out << (i ? "," : "") << columns[i].name;
+	}
+	out << '\n' << std::setprecision(std::numeric_limits<double>::max_digits10);
+	for (std::size_t row = 0; row < log.rows(); ++row) {
+		for (std::size_t i = 0; i < columns.size(); ++i) {
+			const std::uint64_t bits = columns[i].bits[row];
+			out << (i ? "," : "");
+			switch (columns[i].type) {
+			case column_type::u64:
+				out << bits;
+				break;
+			case column_type::i64:
+				out << static_cast<std::int64_t>(bits);
+				break;
+			case column_type::f64: {
+				double value;
+				std::memcpy(&value, &bits, sizeof(value));
+				out << value;
+				break;
+			}
+			case column_type::boolean:
+				out << (bits ? "true" : "false");
+				break;
+			case column_type::string: {
+				// Quoted as RFC 4180 has it
+				const std::string& value = log.strings()[bits];
+				out << '"';
+				for (char c : value) {
+					out << (c == '"' ? "\"\"" : std::string(1, c));
+				}
+				out << '"';
+				break;
+			}
+			}
+		}
+		out << '\n';
+	}
+}
+
+static void write_sqlite(const columnar_log_reader& log, sqlite3pp::database& db) {
+	const auto& columns = log.columns();
+	const std::string drop = "DROP TABLE IF EXISTS " + log.name() + ";";
+	std::string create = "CREATE TABLE " + log.name() + "(";
+	std::string insert = "INSERT INTO " + log.name() + " VALUES (";
+	for (std::size_t i = 0; i < columns.size(); ++i) {
+		create += (i ? ", " : "") + columns[i].name + (columns[i].type == column_type::f64 ? " REAL" : columns[i].type == column_type::string ? " TEXT" : " INTEGER");
+		insert += (i ? ", ?" : "?") + std::to_string(i + 1);
+	}
+	create += ");";
+	insert += ");";
+	db.execute(drop.c_str());
+	db.execute(create.c_str());
+
+	sqlite3pp::transaction xct {db};
+	sqlite3pp::command cmd {db, insert.c_str()};
+	for (std::size_t row = 0; row < log.rows(); ++row) {
+		for (std::size_t i = 0; i < columns.size(); ++i) {
+			const std::uint64_t bits = columns[i].bits[row];
+			const int parameter = static_cast<int>(i + 1);
+			switch (columns[i].type) {
+			case column_type::u64:
+			case column_type::i64:
+			case column_type::boolean:
+				cmd.bind(parameter, static_cast<long long>(bits));
+				break;
+			case column_type::f64: {
+				double value;
+				std::memcpy(&value, &bits, sizeof(value));
+				cmd.bind(parameter, value);
+				break;
+			}
+			case column_type::string:
+				// The reader outlives the statement.
+				cmd.bind(parameter, log.strings()[bits].c_str(), sqlite3pp::nocopy);
+				break;
+			}
+		}
+		cmd.execute();
+		cmd.reset();
+	}
+	xct.commit();
+}
+
+int main(int argc, char** argv) {
+	const std::vector<std::string> args {argv + 1, argv + argc};
+	if (args.size() == 2 && args[0] == "csv") {
+		write_csv(columnar_log_reader{args[1]}, std::cout);
+		return 0;
+	}
+	if (args.size() >= 3 && args[0] == "sqlite") {
+		sqlite3pp::database db {args[1].c_str()};
+		for (std::size_t i = 2; i < args.size(); ++i) {
+			columnar_log_reader log {args[i]};
+			write_sqlite(log, db);
+			std::cerr << args[i] << ": " << log.rows() << " rows into " << log.name() << std::endl;
+		}
+		return 0;
+	}
+	std::cerr << "Usage: " << argv[0] << " csv <log>" << std::endl
+			  << "       " << argv[0] << " sqlite <database> <log>..." << std::endl;
+	return 1;
+}
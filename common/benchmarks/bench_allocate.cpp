@@ -0,0 +1,110 @@
+/**
+ * Compares `switchboard::writer::allocate` (pooled) against the plain heap path, `switchboard::make_ptr`.
+ *
+ * Prints one CSV row per (scenario, allocator) with events/sec and heap allocations per event.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <thread>
+#include "../switchboard.hpp"
+
+static std::atomic<std::size_t> heap_allocations {0};
+
+void* operator new(std::size_t size) {
+	heap_allocations++;
+	if (void* p = std::malloc(size)) {
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+namespace ILLIXR {
+
+/// Roughly the size of an IMU sample plus its timestamps.
+class imu_like : public switchboard::event {
+public:
+	imu_like(std::uint64_t i) { data.fill(static_cast<double>(i)); }
+	std::array<double, 8> data;
+};
+
+static constexpr std::size_t ITERATIONS = 2'000'000;
+
+static void report(const char* scenario, const char* allocator, std::chrono::duration<double> elapsed, std::size_t allocations) {
+	std::cout << scenario << ',' << allocator << ','
+			  << static_cast<std::size_t>(ITERATIONS / elapsed.count()) << ','
+			  << static_cast<double>(allocations) / ITERATIONS << '\n';
+}
+
+/// Allocate and drop on the same thread.
+template <typename Allocate>
+static void same_thread(const char* allocator, Allocate allocate) {
+	std::size_t allocations_before = heap_allocations;
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < ITERATIONS; ++i) {
+		switchboard::ptr<imu_like> ev = allocate(i);
+		asm volatile ("" : : "r"(ev.get()) : "memory");
+	}
+	report("same_thread", allocator, std::chrono::steady_clock::now() - start, heap_allocations - allocations_before);
+}
+
+/// Allocate on a producer, drop on a consumer (the publish/subscribe pattern).
+/// At most MAX_IN_FLIGHT events are queued, as in a pipeline where the consumer keeps up.
+template <typename Allocate>
+static void cross_thread(const char* allocator, Allocate allocate) {
+	static constexpr std::size_t MAX_IN_FLIGHT = 64;
+	moodycamel::BlockingConcurrentQueue<switchboard::ptr<imu_like>> queue;
+	std::atomic<std::size_t> in_flight {0};
+	std::size_t allocations_before = heap_allocations;
+	auto start = std::chrono::steady_clock::now();
+	std::thread consumer {[&] {
+		switchboard::ptr<imu_like> ev;
+		for (std::size_t i = 0; i < ITERATIONS; ++i) {
+			queue.wait_dequeue(ev);
+			ev.reset();
+			in_flight--;
+		}
+	}};
+	for (std::size_t i = 0; i < ITERATIONS; ++i) {
+		while (in_flight.load() >= MAX_IN_FLIGHT) {
+			std::this_thread::yield();
+		}
+		in_flight++;
+		queue.enqueue(allocate(i));
+	}
+	consumer.join();
+	report("cross_thread", allocator, std::chrono::steady_clock::now() - start, heap_allocations - allocations_before);
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<imu_like>("imu");
+	auto heap = [](std::size_t i) { return switchboard::make_ptr<imu_like>(i); };
+	auto pooled = [&writer](std::size_t i) { return writer.allocate<imu_like>(i); };
+
+	std::cout << "scenario,allocator,events_per_sec,heap_allocations_per_event\n";
+	same_thread("make_ptr", heap);
+	same_thread("pool", pooled);
+	cross_thread("make_ptr", heap);
+	cross_thread("pool", pooled);
+
+	switchboard::pool_stats stats = writer.get_pool_stats();
+	std::cerr << "pool: block_size=" << stats.block_size << " hits=" << stats.hits
+			  << " misses=" << stats.misses << " free_blocks=" << stats.free_blocks << std::endl;
+	return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * Compares thread-per-subscription against the shared `work_stealing_executor`.
+ *
+ * - saturated: publishers put as fast as they can; reports callbacks/sec.
+ * - paced: publishers put at a fixed rate; reports publish-to-callback latency percentiles.
+ *
+ * Run it with `taskset -c 0-N` to emulate 2-, 4- and 8-core machines.
+ * Prints one CSV row per (scenario, executor threads); 0 threads means thread-per-subscription.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class stamped : public switchboard::event {
+public:
+	stamped(std::chrono::steady_clock::time_point published_) : published{published_} { }
+	std::chrono::steady_clock::time_point published;
+};
+
+static constexpr std::size_t TOPICS = 6;
+static constexpr std::size_t SUBSCRIPTIONS_PER_TOPIC = 4;
+static constexpr std::chrono::microseconds CALLBACK_WORK {5};
+
+static void spin_for(std::chrono::microseconds work) {
+	auto until = std::chrono::steady_clock::now() + work;
+	while (std::chrono::steady_clock::now() < until) { }
+}
+
+static void run(const char* scenario, std::size_t executor_threads, std::size_t events_per_topic, std::chrono::microseconds period) {
+	std::vector<std::chrono::nanoseconds> latencies;
+	latencies.reserve(TOPICS * SUBSCRIPTIONS_PER_TOPIC * events_per_topic);
+	std::mutex latencies_lock;
+	std::atomic<std::size_t> callbacks {0};
+
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed;
+	{
+		switchboard sb {nullptr, executor_threads};
+		for (std::size_t t = 0; t < TOPICS; ++t) {
+			for (std::size_t s = 0; s < SUBSCRIPTIONS_PER_TOPIC; ++s) {
+				sb.schedule<stamped>(s, "topic" + std::to_string(t), [&](switchboard::ptr<const stamped>&& ev, std::size_t) {
+					auto latency = std::chrono::steady_clock::now() - ev->published;
+					spin_for(CALLBACK_WORK);
+					{
+						std::lock_guard<std::mutex> lock {latencies_lock};
+						latencies.push_back(latency);
+					}
+					callbacks++;
+				});
+			}
+		}
+
+		std::vector<std::thread> publishers;
+		for (std::size_t t = 0; t < TOPICS; ++t) {
+			publishers.emplace_back([&sb, t, events_per_topic, period] {
+				auto writer = sb.get_writer<stamped>("topic" + std::to_string(t));
+				auto next = std::chrono::steady_clock::now();
+				for (std::size_t i = 0; i < events_per_topic; ++i) {
+					if (period.count()) {
+						next += period;
+						std::this_thread::sleep_until(next);
+					}
+					writer.put(writer.allocate(std::chrono::steady_clock::now()));
+				}
+			});
+		}
+		for (std::thread& p : publishers) {
+			p.join();
+		}
+		while (callbacks.load() != TOPICS * SUBSCRIPTIONS_PER_TOPIC * events_per_topic) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+		// Shutdown cost is not part of throughput.
+		elapsed = std::chrono::steady_clock::now() - start;
+		sb.stop();
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	auto pct = [&](double p) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]).count();
+	};
+	std::cout << scenario << ',' << executor_threads << ',' << TOPICS * SUBSCRIPTIONS_PER_TOPIC << ','
+			  << static_cast<std::size_t>(callbacks.load() / elapsed.count()) << ','
+			  << pct(0.5) << ',' << pct(0.99) << ',' << pct(0.999) << '\n';
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "scenario,executor_threads,subscriptions,callbacks_per_sec,p50_us,p99_us,p999_us\n";
+	for (std::size_t threads : {0, 2, 4, 8}) {
+		run("saturated", threads, 2000, std::chrono::microseconds{0});
+	}
+	for (std::size_t threads : {0, 2, 4, 8}) {
+		// 500 Hz per topic, IMU-like
+		run("paced", threads, 500, std::chrono::microseconds{2000});
+	}
+	return 0;
+}
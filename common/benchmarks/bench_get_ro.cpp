@@ -0,0 +1,93 @@
+/**
+ * Measures `reader::get_ro_nullable()` throughput with several readers polling one topic, as pose
+ * prediction, timewarp and the apps all poll the pose topics.
+ *
+ * - dynamic_cast: the load followed by `dynamic_pointer_cast`, as the reader used to do
+ * - static_cast: `get_ro_nullable()` as is; the type was checked when the reader was made
+ *
+ * A writer publishes at 1 kHz throughout. Each reader polls for DURATION; reports reads/sec over all
+ * readers.
+ *
+ * Prints CSV.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class sample : public switchboard::event {
+public:
+	sample(std::uint64_t value_) : value{value_} { }
+	std::uint64_t value;
+};
+
+static constexpr switchboard::topic_descriptor<sample> samples {"samples"};
+static constexpr std::chrono::milliseconds DURATION {500};
+
+/// What get_ro_nullable() did before: load, then an RTTI lookup
+static switchboard::ptr<const sample> dynamic_get_ro(const switchboard::reader<sample>& reader) {
+	switchboard::ptr<const switchboard::event> this_event = reader.get_ro_nullable();
+	return switchboard::dynamic_pointer_cast<const sample>(this_event);
+}
+
+template <typename GetRo>
+static void run(const char* implementation, std::size_t readers, GetRo get_ro) {
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer(samples);
+	writer.put(writer.allocate(0));
+
+	std::atomic<bool> done {false};
+	std::thread producer {[&] {
+		for (std::uint64_t i = 1; !done.load(); ++i) {
+			writer.put(writer.allocate(i));
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+	}};
+
+	std::atomic<std::size_t> reads {0};
+	std::atomic<std::uint64_t> checksum {0};
+	std::vector<std::thread> threads;
+	for (std::size_t r = 0; r < readers; ++r) {
+		threads.emplace_back([&] {
+			auto reader = sb.get_reader(samples);
+			std::size_t my_reads = 0;
+			std::uint64_t my_checksum = 0;
+			const auto end = std::chrono::steady_clock::now() + DURATION;
+			while (std::chrono::steady_clock::now() < end) {
+				for (std::size_t i = 0; i < 1000; ++i) {
+					my_checksum += get_ro(reader)->value;
+				}
+				my_reads += 1000;
+			}
+			reads += my_reads;
+			checksum += my_checksum;
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	done = true;
+	producer.join();
+
+	const double seconds = std::chrono::duration<double>{DURATION}.count();
+	std::cout << implementation << ',' << readers << ',' << static_cast<std::size_t>(reads.load() / seconds) << ',' << checksum.load() << std::endl;
+	sb.stop();
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "implementation,readers,reads_per_sec,checksum" << std::endl;
+	for (std::size_t readers : {1, 2, 4, 8}) {
+		run("dynamic_cast", readers, dynamic_get_ro);
+		run("static_cast", readers, [](const switchboard::reader<sample>& reader) { return reader.get_ro_nullable(); });
+	}
+	return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * Counts the bytes which `reader::get_rw()` copies on an image topic, compared with the deep copy
+ * it used to make on every call.
+ *
+ * The event carries two owning 752x480 grayscale images (`imu_cam_type` holds `cv::Mat`s, whose
+ * copies are shallow, so a plugin wanting to modify the pixels has to clone them anyway). Three
+ * access patterns:
+ *
+ * - inspect: get_rw() and only read (e.g. a debug view)
+ * - mutate_latest: modify the frame while it is still the topic's latest; this must copy
+ * - mutate_previous: modify a frame after the next one was published (a consumer running one frame
+ *   behind); nobody else holds it, so copy-on-write takes it over
+ *
+ * Prints CSV.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+static constexpr std::size_t WIDTH = 752;
+static constexpr std::size_t HEIGHT = 480;
+static constexpr std::size_t FRAMES = 1000;
+
+class camera_frame : public switchboard::event {
+public:
+	camera_frame()
+		: img0(WIDTH * HEIGHT)
+		, img1(WIDTH * HEIGHT)
+	{ }
+
+	camera_frame(const camera_frame& other)
+		: img0{other.img0}
+		, img1{other.img1}
+	{
+		bytes_copied += img0.size() + img1.size();
+	}
+
+	std::vector<std::uint8_t> img0;
+	std::vector<std::uint8_t> img1;
+
+	static inline std::atomic<std::size_t> bytes_copied {0};
+};
+
+/// What get_rw() did before: a deep copy on every call
+static switchboard::ptr<camera_frame> eager_get_rw(const switchboard::reader<camera_frame>& reader) {
+	return switchboard::make_ptr<camera_frame>(*reader.get_ro());
+}
+
+enum class pattern {
+	inspect,
+	mutate_latest,
+	mutate_previous,
+};
+
+static const char* pattern_name(pattern p) {
+	switch (p) {
+	case pattern::inspect:
+		return "inspect";
+	case pattern::mutate_latest:
+		return "mutate_latest";
+	default:
+		return "mutate_previous";
+	}
+}
+
+template <typename GetRw>
+static void run(pattern p, const char* implementation, GetRw get_rw) {
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<camera_frame>("cam");
+	auto reader = sb.get_reader<camera_frame>("cam");
+	camera_frame::bytes_copied = 0;
+	std::size_t checksum = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	writer.put(writer.allocate());
+	auto held = get_rw(reader);
+	for (std::size_t i = 0; i < FRAMES; ++i) {
+		if (p == pattern::inspect) {
+			auto frame = get_rw(reader);
+			checksum += std::as_const(frame)->img0[i];
+			writer.put(writer.allocate());
+		} else if (p == pattern::mutate_latest) {
+			auto frame = get_rw(reader);
+			(*frame).img0[i] = 1;
+			checksum += frame->img0[i];
+			writer.put(writer.allocate());
+		} else {
+			writer.put(writer.allocate());
+			(*held).img0[i] = 1;
+			checksum += held->img0[i];
+			held = get_rw(reader);
+		}
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << pattern_name(p) << ',' << implementation << ',' << FRAMES << ',' << camera_frame::bytes_copied.load() << ','
+			  << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / FRAMES << ',' << checksum << std::endl;
+	sb.stop();
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "pattern,implementation,frames,bytes_copied,ns_per_frame,checksum" << std::endl;
+	for (pattern p : {pattern::inspect, pattern::mutate_latest, pattern::mutate_previous}) {
+		run(p, "eager_copy", eager_get_rw);
+		run(p, "copy_on_write", [](const switchboard::reader<camera_frame>& reader) { return reader.get_rw(); });
+	}
+	return 0;
+}
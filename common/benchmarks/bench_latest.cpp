@@ -0,0 +1,96 @@
+/**
+ * Measures the latency of reading a topic's latest value while writers publish as fast as they can.
+ *
+ * Compares switchboard's `latest_slot` (through `reader::get_ro_nullable`) with the 256-entry ring
+ * which switchboard used before. Prints one CSV row per implementation with latency percentiles.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class datum : public switchboard::event {
+public:
+	datum(std::uint64_t value_) : value{value_} { }
+	std::uint64_t value;
+};
+
+/// The previous implementation of topic::get/put, kept for comparison. Racy by design.
+class legacy_ring {
+public:
+	switchboard::ptr<const switchboard::event> get() const {
+		return _m_buffer[_m_index.load() % _s_size];
+	}
+	void put(switchboard::ptr<const switchboard::event> ev) {
+		_m_buffer[(_m_index.load() + 1) % _s_size] = ev;
+		_m_index++;
+	}
+private:
+	static constexpr std::size_t _s_size = 256;
+	std::atomic<std::size_t> _m_index {0};
+	std::array<switchboard::ptr<const switchboard::event>, _s_size> _m_buffer;
+};
+
+static constexpr std::size_t READS = 1'000'000;
+// One writer: the legacy ring is not safe with concurrent writers at all.
+static constexpr std::size_t WRITERS = 1;
+
+template <typename Get, typename Put>
+static void run(const char* implementation, Get get, Put put) {
+	std::atomic<bool> done {false};
+	std::vector<std::thread> writers;
+	for (std::size_t w = 0; w < WRITERS; ++w) {
+		writers.emplace_back([&] {
+			for (std::uint64_t i = 0; !done.load(std::memory_order_relaxed); ++i) {
+				put(i);
+			}
+		});
+	}
+
+	std::vector<std::chrono::nanoseconds> latencies;
+	latencies.reserve(READS);
+	std::size_t sum = 0;
+	for (std::size_t i = 0; i < READS; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		auto ev = get();
+		latencies.push_back(std::chrono::steady_clock::now() - start);
+		sum += ev ? 1 : 0;
+	}
+	done = true;
+	for (std::thread& t : writers) {
+		t.join();
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+	auto pct = [&](double p) { return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))].count(); };
+	std::cout << implementation << ',' << WRITERS << ',' << pct(0.5) << ',' << pct(0.9) << ','
+			  << pct(0.99) << ',' << pct(0.999) << ',' << latencies.back().count() << ',' << sum << '\n';
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "implementation,writers,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,nonnull_reads\n";
+
+	legacy_ring ring;
+	run("legacy_ring",
+		[&ring] { return ring.get(); },
+		[&ring](std::uint64_t i) { ring.put(switchboard::make_ptr<datum>(i)); });
+
+	switchboard sb {nullptr};
+	auto reader = sb.get_reader<datum>("latest");
+	auto writer = sb.get_writer<datum>("latest");
+	run("latest_slot",
+		[&reader] { return reader.get_ro_nullable(); },
+		[&writer](std::uint64_t i) { writer.put(writer.allocate(i)); });
+	return 0;
+}
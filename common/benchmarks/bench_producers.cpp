@@ -0,0 +1,87 @@
+/**
+ * Measures publish throughput when several producers write the same topic (e.g. one camera driver
+ * per sensor feeding one topic), which fans out to a few subscribers.
+ *
+ * - lock_free: `writer::put` as is; the fan-out reads an RCU snapshot of the subscribers.
+ * - exclusive: every put also holds one topic-wide mutex, as `topic::put` used to.
+ *
+ * Each producer puts EVENTS_PER_PRODUCER events as fast as it can; the subscribers only count.
+ * Reports puts/sec (the time until the last put returns; the queues absorb the rest).
+ *
+ * Run it with `taskset -c 0-N` to emulate machines with fewer cores.
+ * Prints CSV.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class sample : public switchboard::event {
+public:
+	sample(std::uint64_t value_) : value{value_} { }
+	std::uint64_t value;
+};
+
+static constexpr std::size_t SUBSCRIBERS = 4;
+static constexpr std::size_t EVENTS_PER_PRODUCER = 100'000;
+
+static void run(const char* implementation, std::size_t producers, bool exclusive) {
+	switchboard sb {nullptr};
+	std::atomic<std::size_t> received {0};
+	for (std::size_t i = 0; i < SUBSCRIBERS; ++i) {
+		sb.schedule<sample>(0, "samples", [&](switchboard::ptr<const sample>&&, std::size_t) {
+			received.fetch_add(1, std::memory_order_relaxed);
+		});
+	}
+
+	std::mutex topic_lock;
+	std::atomic<bool> go {false};
+	std::vector<std::thread> threads;
+	for (std::size_t p = 0; p < producers; ++p) {
+		threads.emplace_back([&] {
+			auto writer = sb.get_writer<sample>("samples");
+			while (!go.load()) { }
+			for (std::uint64_t i = 0; i < EVENTS_PER_PRODUCER; ++i) {
+				if (exclusive) {
+					const std::lock_guard<std::mutex> lock {topic_lock};
+					writer.put(writer.allocate(i));
+				} else {
+					writer.put(writer.allocate(i));
+				}
+			}
+		});
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	go = true;
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	auto elapsed = std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+
+	const std::size_t puts = producers * EVENTS_PER_PRODUCER;
+	while (received.load() != puts * SUBSCRIBERS) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+	std::cout << implementation << ',' << producers << ',' << SUBSCRIBERS << ',' << static_cast<std::size_t>(puts / elapsed) << std::endl;
+	sb.stop();
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "implementation,producers,subscribers,puts_per_sec" << std::endl;
+	for (std::size_t producers : {1, 2, 4, 8}) {
+		run("exclusive", producers, true);
+		run("lock_free", producers, false);
+	}
+	return 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * Measures what logging costs per iteration, as `threadloop` and switchboard callbacks log.
+ *
+ * - record: a `record` of boxed values, buffered by `record_coalescer`, as iterations were
+ *   logged before `typed_record_coalescer`.
+ * - typed: the same values given to `typed_record_coalescer`, which flushes from the logging thread.
+ * - flushed: the same, with a `record_flusher`, so the logging thread only pushes into a ring and
+ *   the logger runs on the flusher's thread.
+ *
+ * - clocks_only: the clock reads which go into the record, and no logging.
+ *
+ * Each is run against three loggers: `discard` keeps nothing but is enabled (as
+ * `noop_record_logger` used to be), `disabled` is not enabled (as `noop_record_logger` is now), and
+ * `columnar` writes a columnar log (as `columnar_record_logger` does).
+ *
+ * The timing covers building and logging the record only; the iteration's own clock reads are
+ * included when the logger is enabled, since a disabled logger skips them. Records are flushed
+ * every second (or as a flusher's ring fills), as in a run. The flusher's ring is large enough that
+ * none are dropped. A first pass warms up the buffers; of the passes after it, the fastest
+ * is reported as ns per iteration, along with their heap allocations per iteration.
+ *
+ * Prints CSV.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include "../columnar_log.hpp"
+#include "../cpu_timer.hpp"
+#include "../record_logger.hpp"
+
+static std::atomic<std::size_t> heap_allocations {0};
+
+void* operator new(std::size_t size) {
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size)) {
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+namespace ILLIXR {
+
+static constexpr std::size_t ITERATIONS = 2000000;
+
+const typed_record_header<
+	std::size_t,
+	std::string,
+	std::size_t,
+	std::chrono::nanoseconds,
+	std::chrono::nanoseconds,
+	std::chrono::high_resolution_clock::time_point,
+	std::chrono::high_resolution_clock::time_point,
+	std::size_t
+> callback_header {"bench_switchboard_callback", {
+	"plugin_id",
+	"topic_name",
+	"iteration_no",
+	"cpu_time_start",
+	"cpu_time_stop",
+	"wall_time_start",
+	"wall_time_stop",
+	"batch_size",
+}};
+
+class discard_logger : public record_logger {
+public:
+	explicit discard_logger(bool enabled_)
+		: _m_enabled{enabled_}
+	{ }
+
+	virtual void log(const record& r) override {
+		r.mark_used();
+	}
+
+	virtual void log(const record_batch&) override { }
+
+	virtual bool enabled() const override {
+		return _m_enabled;
+	}
+
+private:
+	const bool _m_enabled;
+};
+
+class columnar_logger : public record_logger {
+public:
+	explicit columnar_logger(const std::string& path)
+		: _m_writer{path, callback_header}
+	{ }
+
+	virtual void log(const record& r) override {
+		_m_writer.append(r);
+	}
+
+	virtual void log(const std::vector<record>& rs) override {
+		_m_writer.append(rs);
+	}
+
+	virtual void log(const record_batch& batch) override {
+		// Not the log_ring records of the flusher
+		if (batch.header == callback_header) {
+			_m_writer.append(batch);
+		}
+	}
+
+private:
+	columnar_log_writer _m_writer;
+};
+
+// A topic name too long for a short string, as many are
+static const std::string topic_name = "imu_integrator_input";
+
+static constexpr int PASSES = 4;
+
+/**
+ * @brief Reports the fastest of the passes of @p iterate after the first, which warms up.
+ */
+template <typename Iterate>
+static void measure(const char* implementation, const char* logger, Iterate&& iterate) {
+	iterate();
+	std::chrono::steady_clock::duration fastest = std::chrono::steady_clock::duration::max();
+	std::size_t allocations = 0;
+	for (int pass = 1; pass < PASSES; ++pass) {
+		const std::size_t allocations_before = heap_allocations.load();
+		const auto start = std::chrono::steady_clock::now();
+		iterate();
+		fastest = std::min(fastest, std::chrono::steady_clock::now() - start);
+		allocations += heap_allocations.load() - allocations_before;
+	}
+	std::cout << implementation << ',' << logger << ',' << std::chrono::duration<double, std::nano>{fastest}.count() / ITERATIONS
+			  << ',' << static_cast<double>(allocations) / ((PASSES - 1) * ITERATIONS) << std::endl;
+}
+
+/// What an iteration costs without logging: only the clock reads
+static void clocks_only() {
+	std::chrono::nanoseconds checksum {};
+	measure("clocks_only", "none", [&] {
+		for (std::size_t i = 0; i < ITERATIONS; ++i) {
+			auto cpu_start = thread_cpu_time();
+			auto wall_start = std::chrono::high_resolution_clock::now();
+			checksum += thread_cpu_time() - cpu_start + (std::chrono::high_resolution_clock::now() - wall_start);
+		}
+	});
+	std::cerr << "checksum " << checksum.count() << std::endl;
+}
+
+static void with_record(const char* name, const std::shared_ptr<record_logger>& logger) {
+	record_coalescer log {logger};
+	measure("record", name, [&] {
+		for (std::size_t i = 0; i < ITERATIONS; ++i) {
+			auto cpu_start = thread_cpu_time();
+			auto wall_start = std::chrono::high_resolution_clock::now();
+			log.log(record{callback_header, {
+				{std::size_t{1}},
+				{topic_name},
+				{i},
+				{cpu_start},
+				{thread_cpu_time()},
+				{wall_start},
+				{std::chrono::high_resolution_clock::now()},
+				{std::size_t{1}},
+			}});
+		}
+	});
+}
+
+static void with_coalescer(const char* implementation, const char* name, const std::shared_ptr<record_logger>& logger, std::shared_ptr<record_flusher> flusher) {
+	decltype(callback_header)::coalescer log {logger, callback_header, flusher};
+	measure(implementation, name, [&] {
+		for (std::size_t i = 0; i < ITERATIONS; ++i) {
+			std::chrono::nanoseconds cpu_start {};
+			std::chrono::high_resolution_clock::time_point wall_start;
+			if (log) {
+				cpu_start = thread_cpu_time();
+				wall_start = std::chrono::high_resolution_clock::now();
+			}
+			if (log) {
+				log.log(std::size_t{1}, topic_name, i, cpu_start, thread_cpu_time(), wall_start, std::chrono::high_resolution_clock::now(), std::size_t{1});
+			}
+		}
+	});
+	if (log.dropped()) {
+		std::cerr << "dropped " << log.dropped() << std::endl;
+	}
+}
+
+static void with_typed_record(const char* name, const std::shared_ptr<record_logger>& logger) {
+	with_coalescer("typed", name, logger, nullptr);
+}
+
+static void with_flushed_record(const char* name, const std::shared_ptr<record_logger>& logger) {
+	with_coalescer("flushed", name, logger, std::make_shared<record_flusher>(1 << 16, log_overflow::drop));
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	const std::string path = "/tmp/illixr_bench_records_" + std::to_string(getpid());
+	std::cout << "implementation,logger,ns_per_iteration,heap_allocations_per_iteration" << std::endl;
+	clocks_only();
+	for (auto run : {&with_record, &with_typed_record, &with_flushed_record}) {
+		run("discard", std::make_shared<discard_logger>(true));
+		run("disabled", std::make_shared<discard_logger>(false));
+		run("columnar", std::make_shared<columnar_logger>(path));
+		std::remove(path.c_str());
+	}
+	return 0;
+}
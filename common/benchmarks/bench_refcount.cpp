@@ -0,0 +1,136 @@
+/**
+ * Measures what event handles cost at IMU rates, where the events are small and many.
+ *
+ * - handle: T threads copy and drop handles on one IMU-sized event, as pose readers do with the
+ *   latest value; `std::shared_ptr` (what `switchboard::ptr` used to be) against `switchboard::ptr`.
+ *   Reports ns per copy-and-drop on each thread.
+ * - fan_out: one writer puts IMU-sized events to S subscribers which run inline, so the timing
+ *   covers `allocate()` and `put()` and nothing else. Each subscriber keeps its event until the
+ *   next one, as a queued subscriber would. Reports ns and heap allocations per put. Most of the
+ *   time per subscriber goes to the callback's own timing (see `topic_subscription::process()`).
+ *
+ * Atomic operations on the reference count in one put, with S subscribers: `std::shared_ptr` was
+ * copied for the latest value and for each subscriber, then the writer's handle was dropped, which
+ * is S + 2. `switchboard::ptr` counts the latest value's and all but one subscriber's references
+ * in one add, and hands the writer's reference to the last subscriber, which is 1. Either way,
+ * each holder drops its reference later.
+ *
+ * Prints CSV.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include "../switchboard.hpp"
+
+static std::atomic<std::size_t> heap_allocations {0};
+
+void* operator new(std::size_t size) {
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size)) {
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+namespace ILLIXR {
+
+/// The size of `imu_type`: a timestamp and two 3-vectors
+class imu_sample : public switchboard::event {
+public:
+	imu_sample(std::uint64_t i) { data.fill(static_cast<double>(i)); }
+	std::array<double, 6> data;
+};
+
+static constexpr std::size_t HANDLE_ITERATIONS = 2000000;
+static constexpr std::size_t FAN_OUT_ITERATIONS = 1000000;
+
+template <typename pointer>
+static void handle(const char* implementation, const pointer& shared, std::size_t threads) {
+	std::atomic<double> checksum {0};
+	std::vector<double> ns_per_copy(threads);
+	const std::size_t allocations_before = heap_allocations.load();
+	std::vector<std::thread> copiers;
+	for (std::size_t t = 0; t < threads; ++t) {
+		copiers.emplace_back([&, t] {
+			double my_checksum = 0;
+			const auto start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < HANDLE_ITERATIONS; ++i) {
+				pointer copy = shared;
+				my_checksum += copy->data[0];
+			}
+			const auto elapsed = std::chrono::steady_clock::now() - start;
+			ns_per_copy[t] = std::chrono::duration<double, std::nano>{elapsed}.count() / HANDLE_ITERATIONS;
+			checksum.store(checksum.load() + my_checksum);
+		});
+	}
+	double total = 0;
+	for (std::size_t t = 0; t < threads; ++t) {
+		copiers[t].join();
+		total += ns_per_copy[t];
+	}
+	// The threads themselves allocate a little
+	const double allocations = static_cast<double>(heap_allocations.load() - allocations_before) / (threads * HANDLE_ITERATIONS);
+	std::cout << "handle," << implementation << ',' << threads << ',' << total / threads << ',' << allocations << ',' << checksum.load() << std::endl;
+}
+
+static void fan_out(std::size_t subscribers) {
+	switchboard sb {nullptr};
+	std::vector<switchboard::ptr<const imu_sample>> kept(subscribers);
+	for (std::size_t s = 0; s < subscribers; ++s) {
+		sb.schedule<imu_sample>(0, "imu", [&kept, s](switchboard::ptr<const imu_sample>&& datum, std::size_t) {
+			kept[s] = std::move(datum);
+		}, switchboard::qos{0, switchboard::overflow_policy::block, std::chrono::microseconds{0}, switchboard::dispatch::inline_publisher});
+	}
+
+	auto writer = sb.get_writer<imu_sample>("imu");
+	// Warms up the pool
+	for (std::size_t i = 0; i < 1000; ++i) {
+		writer.put(writer.allocate(i));
+	}
+
+	const std::size_t allocations_before = heap_allocations.load();
+	const auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < FAN_OUT_ITERATIONS; ++i) {
+		writer.put(writer.allocate(i));
+	}
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	const std::size_t allocations = heap_allocations.load() - allocations_before;
+
+	std::cout << "fan_out,switchboard::ptr," << subscribers << ',' << std::chrono::duration<double, std::nano>{elapsed}.count() / FAN_OUT_ITERATIONS
+			  << ',' << static_cast<double>(allocations) / FAN_OUT_ITERATIONS << ',' << (kept.empty() ? 0 : kept.back()->data[0]) << std::endl;
+	sb.stop();
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "scenario,implementation,threads_or_subscribers,ns_per_op,heap_allocations_per_op,checksum" << std::endl;
+	const auto shared = std::make_shared<imu_sample>(1);
+	const auto intrusive = switchboard::make_ptr<imu_sample>(1);
+	std::cerr << "handle bytes: std::shared_ptr=" << sizeof(shared) << " switchboard::ptr=" << sizeof(intrusive) << std::endl;
+	for (std::size_t threads : {1, 2, 4, 8}) {
+		handle("std::shared_ptr", shared, threads);
+		handle("switchboard::ptr", intrusive, threads);
+	}
+	for (std::size_t subscribers : {0, 1, 2, 4, 8}) {
+		fan_out(subscribers);
+	}
+	return 0;
+}
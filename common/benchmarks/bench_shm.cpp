@@ -0,0 +1,247 @@
+/**
+ * Compares ways of delivering a topic to a subscriber: in the same process, through `shm_export` /
+ * `shm_importer` to a forked process, and serialized over a Unix socket to a forked process (the
+ * copy-per-hop shape of the eCAL/protobuf offload path, without needing eCAL installed).
+ *
+ * A publisher puts one frame per millisecond; reports publish-to-callback latency percentiles for a
+ * small message and a EuRoC-sized grayscale image. The subscriber reads the last byte, so the
+ * payload has to be reachable.
+ *
+ * Prints CSV.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../shm_transport.hpp"
+
+namespace ILLIXR {
+
+class frame : public switchboard::event {
+public:
+	frame(std::int64_t published_, std::size_t size_)
+		: published{published_}
+		, owned(size_)
+		, data{owned.data()}
+		, size{size_}
+	{ }
+
+	frame(std::int64_t published_, const std::byte* data_, std::size_t size_)
+		: published{published_}
+		, data{data_}
+		, size{size_}
+	{ }
+
+	std::int64_t published;
+	std::vector<std::byte> owned;
+	const std::byte* data;
+	std::size_t size;
+};
+
+template <>
+struct shm_codec<frame> {
+	static std::size_t size(const frame& this_event) {
+		return sizeof(std::int64_t) + this_event.size;
+	}
+
+	static void write(const frame& this_event, std::byte* dst, const RelativeClock&) {
+		std::memcpy(dst, &this_event.published, sizeof(std::int64_t));
+		std::memcpy(dst + sizeof(std::int64_t), this_event.data, this_event.size);
+	}
+
+	static switchboard::ptr<frame> read(const std::byte* src, std::size_t size, const RelativeClock&, std::shared_ptr<const void>&& pin) {
+		std::int64_t published;
+		std::memcpy(&published, src, sizeof(std::int64_t));
+		return switchboard::make_ptr<shm_pinned<frame>>(std::move(pin), published, src + sizeof(std::int64_t), size - sizeof(std::int64_t));
+	}
+};
+
+static constexpr std::size_t EVENTS = 1000;
+static constexpr std::chrono::microseconds PERIOD {1000};
+static constexpr std::size_t SLOTS = 16;
+
+static std::int64_t now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Collects latencies in a subscriber and prints a row once every event has arrived.
+class latency_sink {
+public:
+	void record(const frame& this_event) {
+		volatile std::byte last = this_event.data[this_event.size - 1];
+		(void) last;
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		_m_latencies.push_back(std::chrono::nanoseconds{now_ns() - this_event.published});
+	}
+
+	void print_when_done(const char* transport, std::size_t size) {
+		while (true) {
+			{
+				const std::lock_guard<std::mutex> lock {_m_lock};
+				if (_m_latencies.size() == EVENTS) {
+					break;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+		std::sort(_m_latencies.begin(), _m_latencies.end());
+		auto pct = [&](double p) {
+			return std::chrono::duration_cast<std::chrono::microseconds>(_m_latencies[static_cast<std::size_t>(p * (_m_latencies.size() - 1))]).count();
+		};
+		std::cout << transport << ',' << size << ',' << pct(0.5) << ',' << pct(0.99) << ',' << pct(0.999) << ','
+				  << std::chrono::duration_cast<std::chrono::microseconds>(_m_latencies.back()).count() << std::endl;
+	}
+
+private:
+	std::mutex _m_lock;
+	std::vector<std::chrono::nanoseconds> _m_latencies;
+};
+
+static void publish(switchboard& sb, const std::string& topic_name, std::size_t size) {
+	auto writer = sb.get_writer<frame>(topic_name);
+	auto next = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < EVENTS; ++i) {
+		next += PERIOD;
+		std::this_thread::sleep_until(next);
+		switchboard::ptr<frame> this_event = writer.allocate(0, size);
+		this_event->published = now_ns();
+		writer.put(std::move(this_event));
+	}
+}
+
+static void in_process(std::size_t size) {
+	latency_sink sink;
+	switchboard sb {nullptr};
+	sb.schedule<frame>(0, "frames", [&](switchboard::ptr<const frame>&& this_event, std::size_t) {
+		sink.record(*this_event);
+	});
+	publish(sb, "frames", size);
+	sink.print_when_done("in_process", size);
+	sb.stop();
+}
+
+static void shm(std::size_t size) {
+	auto clock = std::make_shared<RelativeClock>();
+	clock->start();
+	const std::string topic_name = "bench_frames_" + std::to_string(getpid());
+	pid_t child = fork();
+	if (child == 0) {
+		latency_sink sink;
+		auto sb = std::make_shared<switchboard>(nullptr);
+		sb->schedule<frame>(0, topic_name, [&](switchboard::ptr<const frame>&& this_event, std::size_t) {
+			sink.record(*this_event);
+		});
+		{
+			shm_importer<frame> importer {sb, clock, topic_name};
+			sink.print_when_done("shm", size);
+		}
+		sb->stop();
+		_exit(0);
+	}
+	{
+		switchboard sb {nullptr};
+		shm_export<frame>(sb, clock, 0, topic_name, SLOTS, sizeof(std::int64_t) + size);
+		// Let the child attach.
+		std::this_thread::sleep_for(std::chrono::milliseconds{100});
+		publish(sb, topic_name, size);
+		waitpid(child, nullptr, 0);
+		sb.stop();
+	}
+}
+
+static bool read_fully(int fd, void* dst, std::size_t size) {
+	auto* bytes = static_cast<char*>(dst);
+	while (size) {
+		ssize_t got = read(fd, bytes, size);
+		if (got <= 0) {
+			return false;
+		}
+		bytes += got;
+		size -= static_cast<std::size_t>(got);
+	}
+	return true;
+}
+
+static void write_fully(int fd, const void* src, std::size_t size) {
+	auto* bytes = static_cast<const char*>(src);
+	while (size) {
+		ssize_t put = write(fd, bytes, size);
+		if (put <= 0) {
+			return;
+		}
+		bytes += put;
+		size -= static_cast<std::size_t>(put);
+	}
+}
+
+static void socket(std::size_t size) {
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+		std::cerr << "socketpair: " << strerror(errno) << std::endl;
+		return;
+	}
+	pid_t child = fork();
+	if (child == 0) {
+		close(fds[0]);
+		latency_sink sink;
+		switchboard sb {nullptr};
+		sb.schedule<frame>(0, "frames", [&](switchboard::ptr<const frame>&& this_event, std::size_t) {
+			sink.record(*this_event);
+		});
+		// Receive thread: deserialize into a fresh event, like an eCAL subscriber callback.
+		std::thread receiver {[&] {
+			auto writer = sb.get_writer<frame>("frames");
+			std::int64_t header[2];
+			while (read_fully(fds[1], header, sizeof(header))) {
+				switchboard::ptr<frame> this_event = writer.allocate(header[0], static_cast<std::size_t>(header[1]));
+				read_fully(fds[1], this_event->owned.data(), this_event->size);
+				writer.put(std::move(this_event));
+			}
+		}};
+		sink.print_when_done("socket", size);
+		// Unlike close(), this wakes the blocked read.
+		shutdown(fds[1], SHUT_RDWR);
+		receiver.join();
+		close(fds[1]);
+		sb.stop();
+		_exit(0);
+	}
+	close(fds[1]);
+	{
+		switchboard sb {nullptr};
+		sb.schedule<frame>(0, "frames", [&](switchboard::ptr<const frame>&& this_event, std::size_t) {
+			// Serialize: one copy into the message, one through the kernel.
+			std::vector<std::byte> message (2 * sizeof(std::int64_t) + this_event->size);
+			std::int64_t header[2] = {this_event->published, static_cast<std::int64_t>(this_event->size)};
+			std::memcpy(message.data(), header, sizeof(header));
+			std::memcpy(message.data() + sizeof(header), this_event->data, this_event->size);
+			write_fully(fds[0], message.data(), message.size());
+		});
+		publish(sb, "frames", size);
+		waitpid(child, nullptr, 0);
+		sb.stop();
+	}
+	close(fds[0]);
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "transport,bytes,p50_us,p99_us,p999_us,max_us" << std::endl;
+	// An IMU-sized message, and one 752x480 grayscale camera frame
+	for (std::size_t size : {64, 752 * 480}) {
+		in_process(size);
+		shm(size);
+		socket(size);
+	}
+	return 0;
+}
@@ -0,0 +1,455 @@
+/**
+ * The switchboard regression suite: one program covering the paths which ILLIXR's plugins lean on,
+ * with payloads the size of ILLIXR's own events:
+ *
+ * - imu: one IMU sample (`imu_type`: a timestamp and two 3-vectors)
+ * - pose: one pose (`pose_type`: timestamps, a position and an orientation)
+ * - stereo: a pair of 752x480 grayscale images (`imu_cam_type` from the EuRoC dataset), on the heap
+ *
+ * Scenarios:
+ *
+ * - throughput: P producers publish as fast as they can to C subscribers of one topic; reports
+ *   puts/sec until the last put returns and deliveries/sec until the last callback returns.
+ * - latency: one producer publishes every millisecond to C subscribers; reports publish-to-callback
+ *   latency percentiles.
+ * - get_ro: R threads poll `reader::get_ro()` while a producer publishes every millisecond; reports
+ *   reads/sec over all readers.
+ * - memory: a subscriber is held up while events queue for it; reports the heap bytes (and
+ *   allocations) each queued event costs, with and without the payload itself.
+ * - topics: one producer publishes round-robin to T topics with one subscriber each, with a thread
+ *   per subscription and with an executor; reports deliveries/sec.
+ *
+ * Usage: `bench_switchboard [--baseline <csv>] [--tolerance <fraction>] [<scenario>...]`
+ *
+ * Prints one CSV row per measurement. The key columns (everything before `value`) stay the same
+ * from run to run, so the output can be kept and diffed. With `--baseline`, rows are also compared
+ * with an earlier run's output; any which got worse by more than the tolerance (0.25 by default;
+ * timing on a shared machine is noisy) are reported on stderr, and the exit status is 1. Lines with
+ * other than 10 columns (the executor announcing its threads) are not measurements.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <malloc.h>
+#include "../switchboard.hpp"
+
+static std::atomic<std::size_t> heap_allocations {0};
+static std::atomic<std::size_t> heap_bytes {0};
+
+void* operator new(std::size_t size) {
+	if (void* p = std::malloc(size)) {
+		heap_allocations.fetch_add(1, std::memory_order_relaxed);
+		heap_bytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+	if (p) {
+		heap_bytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+	}
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+namespace ILLIXR {
+
+using steady = std::chrono::steady_clock;
+
+/**
+ * An event with @p inline_bytes of data in the event itself and @p heap_bytes_ in a separately
+ * allocated buffer, stamped with the time it was published.
+ */
+template <std::size_t inline_bytes, std::size_t heap_bytes_>
+class payload : public switchboard::event {
+public:
+	payload(steady::time_point published_)
+		: published{published_}
+		, heap_data(heap_bytes_)
+	{
+		inline_data.fill(1);
+		// Touch every page, as a camera driver writing the image would.
+		for (std::size_t i = 0; i < heap_data.size(); i += 4096) {
+			heap_data[i] = 1;
+		}
+	}
+
+	static constexpr std::size_t bytes = sizeof(steady::time_point) + inline_bytes + heap_bytes_;
+
+	steady::time_point published;
+	std::array<std::uint8_t, inline_bytes> inline_data;
+	std::vector<std::uint8_t> heap_data;
+};
+
+struct imu : payload<48, 0> {
+	using payload::payload;
+	static constexpr const char* name = "imu";
+	static constexpr std::size_t throughput_events = 100'000;
+	static constexpr std::size_t memory_events = 10'000;
+};
+
+struct pose : payload<72, 0> {
+	using payload::payload;
+	static constexpr const char* name = "pose";
+	static constexpr std::size_t throughput_events = 100'000;
+	static constexpr std::size_t memory_events = 10'000;
+};
+
+struct stereo : payload<0, 2 * 752 * 480> {
+	using payload::payload;
+	static constexpr const char* name = "stereo";
+	static constexpr std::size_t throughput_events = 500;
+	static constexpr std::size_t memory_events = 100;
+};
+
+static constexpr std::size_t LATENCY_EVENTS = 1000;
+static constexpr std::chrono::microseconds PERIOD {1000};
+static constexpr std::chrono::milliseconds GET_RO_DURATION {250};
+static constexpr std::size_t TOPICS_EVENTS = 100'000;
+
+/// The columns which identify a measurement
+using key = std::tuple<std::string, std::string, std::size_t, std::size_t, std::size_t, std::size_t, std::string>;
+
+struct row {
+	key k;
+	double value;
+	std::string unit;
+	/// "higher" or "lower": which direction is an improvement
+	std::string better;
+};
+
+static std::vector<row> results;
+
+static void report(const char* scenario, const char* payload_name, std::size_t producers, std::size_t consumers,
+				   std::size_t topics, std::size_t executor_threads, const char* metric, double value, const char* unit, const char* better) {
+	results.push_back(row{key{scenario, payload_name, producers, consumers, topics, executor_threads, metric}, value, unit, better});
+	std::cout << scenario << ',' << payload_name << ',' << producers << ',' << consumers << ',' << topics << ','
+			  << executor_threads << ',' << metric << ',' << static_cast<std::uint64_t>(value) << ',' << unit << ',' << better << std::endl;
+}
+
+static double seconds_since(steady::time_point start) {
+	return std::chrono::duration<double>{steady::now() - start}.count();
+}
+
+template <typename event_type>
+static void throughput(std::size_t producers, std::size_t consumers) {
+	switchboard sb {nullptr};
+	std::atomic<std::size_t> received {0};
+	for (std::size_t c = 0; c < consumers; ++c) {
+		sb.schedule<event_type>(c, "throughput", [&](switchboard::ptr<const event_type>&&, std::size_t) {
+			received.fetch_add(1, std::memory_order_relaxed);
+		});
+	}
+
+	std::atomic<bool> go {false};
+	std::vector<std::thread> threads;
+	for (std::size_t p = 0; p < producers; ++p) {
+		threads.emplace_back([&] {
+			auto writer = sb.get_writer<event_type>("throughput");
+			while (!go.load()) { }
+			for (std::size_t i = 0; i < event_type::throughput_events; ++i) {
+				writer.put(writer.allocate(steady::now()));
+			}
+		});
+	}
+
+	const auto start = steady::now();
+	go = true;
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	const double put_seconds = seconds_since(start);
+	const std::size_t puts = producers * event_type::throughput_events;
+	while (received.load() != puts * consumers) {
+		std::this_thread::yield();
+	}
+	const double delivery_seconds = seconds_since(start);
+	sb.stop();
+
+	report("throughput", event_type::name, producers, consumers, 1, 0, "puts_per_sec", puts / put_seconds, "1/s", "higher");
+	report("throughput", event_type::name, producers, consumers, 1, 0, "deliveries_per_sec", puts * consumers / delivery_seconds, "1/s", "higher");
+}
+
+template <typename event_type>
+static void latency(std::size_t consumers) {
+	std::vector<std::vector<std::chrono::nanoseconds>> latencies (consumers);
+	std::atomic<std::size_t> received {0};
+	switchboard sb {nullptr};
+	for (std::size_t c = 0; c < consumers; ++c) {
+		latencies[c].reserve(LATENCY_EVENTS);
+		// Each subscription's callbacks are serialized, so each can have its own vector.
+		sb.schedule<event_type>(c, "latency", [&, c](switchboard::ptr<const event_type>&& datum, std::size_t) {
+			latencies[c].push_back(steady::now() - datum->published);
+			received.fetch_add(1);
+		});
+	}
+
+	auto writer = sb.get_writer<event_type>("latency");
+	auto next = steady::now();
+	for (std::size_t i = 0; i < LATENCY_EVENTS; ++i) {
+		next += PERIOD;
+		std::this_thread::sleep_until(next);
+		writer.put(writer.allocate(steady::now()));
+	}
+	while (received.load() != LATENCY_EVENTS * consumers) {
+		std::this_thread::yield();
+	}
+	sb.stop();
+
+	std::vector<std::chrono::nanoseconds> all;
+	for (const auto& l : latencies) {
+		all.insert(all.end(), l.begin(), l.end());
+	}
+	std::sort(all.begin(), all.end());
+	for (auto [metric, p] : {std::pair{"p50_ns", 0.5}, {"p99_ns", 0.99}, {"p999_ns", 0.999}}) {
+		report("latency", event_type::name, 1, consumers, 1, 0, metric, all[static_cast<std::size_t>(p * (all.size() - 1))].count(), "ns", "lower");
+	}
+}
+
+template <typename event_type>
+static void get_ro(std::size_t readers) {
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<event_type>("get_ro");
+	writer.put(writer.allocate(steady::now()));
+
+	std::atomic<bool> done {false};
+	std::thread producer {[&] {
+		auto next = steady::now();
+		while (!done.load()) {
+			next += PERIOD;
+			std::this_thread::sleep_until(next);
+			writer.put(writer.allocate(steady::now()));
+		}
+	}};
+
+	std::atomic<std::size_t> reads {0};
+	std::atomic<std::size_t> checksum {0};
+	std::vector<std::thread> threads;
+	for (std::size_t r = 0; r < readers; ++r) {
+		threads.emplace_back([&] {
+			auto reader = sb.get_reader<event_type>("get_ro");
+			std::size_t my_reads = 0;
+			std::size_t my_checksum = 0;
+			const auto end = steady::now() + GET_RO_DURATION;
+			while (steady::now() < end) {
+				for (std::size_t i = 0; i < 1000; ++i) {
+					my_checksum += reader.get_ro()->published.time_since_epoch().count() & 1;
+				}
+				my_reads += 1000;
+			}
+			reads += my_reads;
+			checksum += my_checksum;
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	done = true;
+	producer.join();
+	sb.stop();
+
+	const double seconds = std::chrono::duration<double>{GET_RO_DURATION}.count();
+	report("get_ro", event_type::name, 1, readers, 1, 0, "reads_per_sec", reads.load() / seconds, "1/s", "higher");
+}
+
+template <typename event_type>
+static void memory() {
+	switchboard sb {nullptr};
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::promise<void> blocked;
+	std::atomic<std::size_t> received {0};
+	sb.schedule<event_type>(0, "memory", [&](switchboard::ptr<const event_type>&&, std::size_t) {
+		if (received.load() == 0) {
+			blocked.set_value();
+			released.wait();
+		}
+		received.fetch_add(1);
+	});
+
+	// The first event holds the subscriber up; the rest queue behind it.
+	auto writer = sb.get_writer<event_type>("memory");
+	writer.put(writer.allocate(steady::now()));
+	blocked.get_future().wait();
+
+	const std::size_t bytes_before = heap_bytes.load();
+	const std::size_t allocations_before = heap_allocations.load();
+	for (std::size_t i = 0; i < event_type::memory_events; ++i) {
+		writer.put(writer.allocate(steady::now()));
+	}
+	const double bytes = static_cast<double>(heap_bytes.load() - bytes_before) / event_type::memory_events;
+	const double allocations = static_cast<double>(heap_allocations.load() - allocations_before) / event_type::memory_events;
+
+	release.set_value();
+	while (received.load() != event_type::memory_events + 1) {
+		std::this_thread::yield();
+	}
+	sb.stop();
+
+	report("memory", event_type::name, 1, 1, 1, 0, "payload_bytes", event_type::bytes, "B", "lower");
+	report("memory", event_type::name, 1, 1, 1, 0, "bytes_per_queued_event", bytes, "B", "lower");
+	report("memory", event_type::name, 1, 1, 1, 0, "overhead_bytes_per_queued_event", bytes - event_type::bytes, "B", "lower");
+	// Scaled by 1000, as values are printed as integers
+	report("memory", event_type::name, 1, 1, 1, 0, "allocations_per_1000_events", allocations * 1000, "1", "lower");
+}
+
+static void topics(std::size_t topic_count, std::size_t executor_threads) {
+	switchboard sb {nullptr, executor_threads};
+	std::atomic<std::size_t> received {0};
+	std::vector<switchboard::writer<imu>> writers;
+	for (std::size_t t = 0; t < topic_count; ++t) {
+		const std::string name = "topic" + std::to_string(t);
+		sb.schedule<imu>(t, name, [&](switchboard::ptr<const imu>&&, std::size_t) {
+			received.fetch_add(1, std::memory_order_relaxed);
+		});
+		writers.push_back(sb.get_writer<imu>(name));
+	}
+
+	const auto start = steady::now();
+	for (std::size_t i = 0; i < TOPICS_EVENTS; ++i) {
+		switchboard::writer<imu>& writer = writers[i % topic_count];
+		writer.put(writer.allocate(steady::now()));
+	}
+	while (received.load() != TOPICS_EVENTS) {
+		std::this_thread::yield();
+	}
+	const double seconds = seconds_since(start);
+	sb.stop();
+
+	report("topics", imu::name, 1, topic_count, topic_count, executor_threads, "deliveries_per_sec", TOPICS_EVENTS / seconds, "1/s", "higher");
+}
+
+template <typename event_type>
+static void run_payload(const std::vector<std::string>& scenarios) {
+	auto selected = [&](const std::string& scenario) {
+		return scenarios.empty() || std::find(scenarios.begin(), scenarios.end(), scenario) != scenarios.end();
+	};
+	if (selected("throughput")) {
+		for (std::size_t producers : {1, 2, 4}) {
+			for (std::size_t consumers : {1, 4}) {
+				throughput<event_type>(producers, consumers);
+			}
+		}
+	}
+	if (selected("latency")) {
+		for (std::size_t consumers : {1, 4}) {
+			latency<event_type>(consumers);
+		}
+	}
+	if (selected("get_ro")) {
+		for (std::size_t readers : {1, 2, 4, 8}) {
+			get_ro<event_type>(readers);
+		}
+	}
+	if (selected("memory")) {
+		memory<event_type>();
+	}
+}
+
+static std::vector<row> read_csv(const std::string& path) {
+	std::ifstream file {path};
+	if (!file) {
+		throw std::runtime_error{"cannot open " + path};
+	}
+	std::vector<row> rows;
+	std::string line;
+	std::getline(file, line);
+	while (std::getline(file, line)) {
+		std::vector<std::string> fields;
+		std::stringstream stream {line};
+		std::string field;
+		while (std::getline(stream, field, ',')) {
+			fields.push_back(field);
+		}
+		// Skips the executor's `thread,...` announcements
+		if (fields.size() != 10) {
+			continue;
+		}
+		rows.push_back(row{
+			key{fields[0], fields[1], std::stoul(fields[2]), std::stoul(fields[3]), std::stoul(fields[4]), std::stoul(fields[5]), fields[6]},
+			std::stod(fields[7]), fields[8], fields[9],
+		});
+	}
+	return rows;
+}
+
+/// @return the number of rows in #results which are worse than in @p baseline by more than @p tolerance
+static std::size_t compare(const std::vector<row>& baseline, double tolerance) {
+	std::map<key, const row*> current;
+	for (const row& r : results) {
+		current[r.k] = &r;
+	}
+	std::size_t regressions = 0;
+	for (const row& old : baseline) {
+		auto found = current.find(old.k);
+		if (found == current.end() || old.value == 0) {
+			continue;
+		}
+		const double ratio = found->second->value / old.value;
+		const bool worse = old.better == "higher" ? ratio < 1 - tolerance : ratio > 1 + tolerance;
+		if (worse) {
+			const auto& [scenario, payload_name, producers, consumers, topic_count, executor_threads, metric] = old.k;
+			std::cerr << "regression: " << scenario << ' ' << payload_name << " producers=" << producers << " consumers=" << consumers
+					  << " topics=" << topic_count << " executor_threads=" << executor_threads << ' ' << metric << ": "
+					  << static_cast<std::uint64_t>(old.value) << " -> " << static_cast<std::uint64_t>(found->second->value) << ' ' << old.unit << std::endl;
+			++regressions;
+		}
+	}
+	return regressions;
+}
+
+}
+
+int main(int argc, char** argv) {
+	using namespace ILLIXR;
+	std::string baseline;
+	double tolerance = 0.25;
+	std::vector<std::string> scenarios;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg {argv[i]};
+		if (arg == "--baseline" && i + 1 < argc) {
+			baseline = argv[++i];
+		} else if (arg == "--tolerance" && i + 1 < argc) {
+			tolerance = std::stod(argv[++i]);
+		} else {
+			scenarios.push_back(arg);
+		}
+	}
+
+	std::cout << "scenario,payload,producers,consumers,topics,executor_threads,metric,value,unit,better" << std::endl;
+	run_payload<imu>(scenarios);
+	run_payload<pose>(scenarios);
+	run_payload<stereo>(scenarios);
+	if (scenarios.empty() || std::find(scenarios.begin(), scenarios.end(), "topics") != scenarios.end()) {
+		for (std::size_t executor_threads : {0, 4}) {
+			for (std::size_t topic_count : {1, 8, 64, 256}) {
+				topics(topic_count, executor_threads);
+			}
+		}
+	}
+
+	if (!baseline.empty()) {
+		const std::size_t regressions = compare(read_csv(baseline), tolerance);
+		std::cerr << regressions << " regression(s) against " << baseline << std::endl;
+		return regressions ? 1 : 0;
+	}
+	return 0;
+}
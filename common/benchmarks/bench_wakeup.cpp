@@ -0,0 +1,96 @@
+/**
+ * Measures how quickly an idle subscription wakes up, and how long `switchboard::stop()` takes.
+ *
+ * - wakeup: a publisher puts one event every millisecond to a single subscription, which is idle
+ *   in between; reports publish-to-callback latency percentiles.
+ * - inline: the same, with an inline subscription (`dispatch::inline_publisher`), which has no
+ *   thread to wake up.
+ * - stop: reports the time `stop()` takes with idle thread-per-subscription subscriptions.
+ *
+ * Prints CSV; 0 executor threads means thread-per-subscription.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class stamped : public switchboard::event {
+public:
+	stamped(std::chrono::steady_clock::time_point published_) : published{published_} { }
+	std::chrono::steady_clock::time_point published;
+};
+
+static constexpr std::size_t EVENTS = 2000;
+static constexpr std::chrono::microseconds PERIOD {1000};
+static constexpr std::size_t STOP_SUBSCRIPTIONS = 24;
+
+static void wakeup(const char* scenario, std::size_t executor_threads, switchboard::dispatch dispatch_mode) {
+	std::vector<std::chrono::nanoseconds> latencies;
+	latencies.reserve(EVENTS);
+	std::mutex latencies_lock;
+
+	switchboard sb {nullptr, executor_threads};
+	switchboard::qos qos_;
+	qos_.dispatch_mode = dispatch_mode;
+	sb.schedule<stamped>(0, "wakeup", [&](switchboard::ptr<const stamped>&& ev, std::size_t) {
+		auto latency = std::chrono::steady_clock::now() - ev->published;
+		const std::lock_guard<std::mutex> lock {latencies_lock};
+		latencies.push_back(latency);
+	}, qos_);
+
+	auto writer = sb.get_writer<stamped>("wakeup");
+	auto next = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < EVENTS; ++i) {
+		next += PERIOD;
+		std::this_thread::sleep_until(next);
+		writer.put(writer.allocate(std::chrono::steady_clock::now()));
+	}
+	while (true) {
+		const std::lock_guard<std::mutex> lock {latencies_lock};
+		if (latencies.size() == EVENTS) {
+			break;
+		}
+	}
+	sb.stop();
+
+	std::sort(latencies.begin(), latencies.end());
+	auto pct = [&](double p) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]).count();
+	};
+	std::cout << scenario << ',' << executor_threads << ',' << pct(0.5) << ',' << pct(0.99) << ',' << pct(0.999) << ','
+			  << std::chrono::duration_cast<std::chrono::microseconds>(latencies.back()).count() << ",\n";
+}
+
+static void stop() {
+	switchboard sb {nullptr};
+	for (std::size_t s = 0; s < STOP_SUBSCRIPTIONS; ++s) {
+		sb.schedule<stamped>(s, "topic" + std::to_string(s % 6), [](switchboard::ptr<const stamped>&&, std::size_t) { });
+	}
+	// Let the threads settle into waiting.
+	std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+	auto start = std::chrono::steady_clock::now();
+	sb.stop();
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "stop,0,,,,," << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << '\n';
+}
+
+}
+
+int main() {
+	using namespace ILLIXR;
+	std::cout << "scenario,executor_threads,p50_us,p99_us,p999_us,max_us,stop_us\n";
+	for (std::size_t threads : {0, 2}) {
+		wakeup("wakeup", threads, switchboard::dispatch::queued);
+	}
+	wakeup("inline", 0, switchboard::dispatch::inline_publisher);
+	stop();
+	return 0;
+}
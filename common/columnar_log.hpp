@@ -0,0 +1,603 @@
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "record_logger.hpp"
+#include "relative_clock.hpp"
+
+namespace ILLIXR {
+
+/**
+ * @brief On-disk layout of a columnar record log, which holds the records of one `record_header`.
+ *
+ * A file header, the table name, and one `column_header` and name per column, then blocks, each
+ * 8-byte aligned and starting with a `block_header`:
+ *
+ * - A chunk holds up to `capacity` rows, column after column, 8 bytes per value. Its `count` is
+ *   the rows written so far, and is stored after each row, so a chunk is readable while (and after)
+ *   it is being filled.
+ * - A string block holds the characters of the next string id. String columns hold ids, so every
+ *   value has the same width, and a name logged on each iteration is stored once.
+ *
+ * The zero-filled tail of a log whose writer was killed reads as its end.
+ */
+namespace columnar_log_format {
+	constexpr std::uint64_t magic = 0x4c43525849584c49; // "ILLIXRCL"
+	constexpr std::uint32_t version = 1;
+
+	enum class column_type : std::uint32_t {
+		// std::size_t
+		u64 = 1,
+		// Durations and time points, in nanoseconds
+		i64 = 2,
+		f64 = 3,
+		boolean = 4,
+		// An id of a string block
+		string = 5,
+	};
+
+	enum class block_kind : std::uint32_t {
+		end = 0,
+		chunk = 1,
+		string = 2,
+	};
+
+	struct file_header {
+		std::uint64_t magic;
+		std::uint32_t version;
+		std::uint32_t columns;
+		std::uint32_t name_size;
+		std::uint32_t reserved;
+	};
+
+	struct column_header {
+		column_type type;
+		std::uint32_t name_size;
+	};
+
+	struct block_header {
+		block_kind kind;
+		// Rows in a chunk, or bytes in a string
+		std::uint32_t count;
+		// Rows a chunk has room for
+		std::uint32_t capacity;
+		std::uint32_t reserved;
+	};
+
+	inline std::size_t aligned(std::size_t size) {
+		return (size + 7) / 8 * 8;
+	}
+
+	inline const char* type_name(column_type type) {
+		switch (type) {
+		case column_type::u64:
+			return "u64";
+		case column_type::i64:
+			return "i64";
+		case column_type::f64:
+			return "f64";
+		case column_type::boolean:
+			return "boolean";
+		case column_type::string:
+			return "string";
+		}
+		return "unknown";
+	}
+}
+
+/**
+ * @brief Appends the records of one `record_header` to an mmap-backed columnar log.
+ *
+ * Thread-safe. Appending a record stores each of its values into the current chunk; the file (and
+ * mapping) grows geometrically. When this is destroyed, the last chunk is
+ * shrunk to its rows and the file is truncated to its contents.
+ */
+class columnar_log_writer {
+public:
+	columnar_log_writer(const std::string& path, const record_header& rh, std::uint32_t chunk_rows = 4096)
+		: _m_path{path}
+		, _m_rh{rh}
+		, _m_chunk_rows{chunk_rows}
+	{
+		assert(chunk_rows > 0);
+		for (unsigned i = 0; i < rh.get_columns(); ++i) {
+			_m_values.push_back(value_of(rh.get_column_type(i)));
+		}
+		_m_string_ids.resize(_m_values.size());
+
+		_m_fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+		if (_m_fd == -1) {
+			throw std::runtime_error{"open " + path + ": " + strerror(errno)};
+		}
+		reserve(_s_initial_capacity);
+
+		columnar_log_format::file_header header {
+			columnar_log_format::magic,
+			columnar_log_format::version,
+			rh.get_columns(),
+			static_cast<std::uint32_t>(rh.get_name().size()),
+			0,
+		};
+		append_bytes(&header, sizeof(header), rh.get_name());
+		for (unsigned i = 0; i < rh.get_columns(); ++i) {
+			columnar_log_format::column_header column {
+				type_of(_m_values[i]),
+				static_cast<std::uint32_t>(rh.get_column_name(i).size()),
+			};
+			append_bytes(&column, sizeof(column), rh.get_column_name(i));
+		}
+	}
+
+	columnar_log_writer(const columnar_log_writer&) = delete;
+	columnar_log_writer& operator=(const columnar_log_writer&) = delete;
+
+	~columnar_log_writer() {
+		shrink_last_chunk();
+		munmap(_m_data, _m_capacity);
+		if (ftruncate(_m_fd, static_cast<off_t>(_m_size)) == -1) {
+			std::cerr << "columnar_log_writer: ftruncate " << _m_path << ": " << strerror(errno) << std::endl;
+		}
+		close(_m_fd);
+	}
+
+	/**
+	 * @brief Appends @p r, which must have been made with this log's `record_header`.
+	 */
+	void append(const record& r) {
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		append_locked(r);
+	}
+
+	/**
+	 * @brief Appends each of @p rs under one lock.
+	 */
+	void append(const std::vector<record>& rs) {
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		for (const record& r : rs) {
+			append_locked(r);
+		}
+	}
+
+	/**
+	 * @brief Appends the rows of @p batch under one lock, without unboxing anything.
+	 */
+	void append(const record_batch& batch) {
+		assert(batch.header == _m_rh);
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		for (std::size_t row = 0; row < batch.rows; ++row) {
+			append_locked(batch_row{batch, row});
+		}
+	}
+
+	/// Bytes written so far
+	std::size_t size() {
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		return _m_size;
+	}
+
+private:
+	/// The C++ types a column can have, each with a `record::get_value` of its own
+	enum class value {
+		size,
+		boolean,
+		real,
+		nanoseconds,
+		system_time_point,
+		time_point,
+		string,
+	};
+
+	static value value_of(const std::type_info& type) {
+		if (false) {
+		} else if (type == typeid(std::size_t)) {
+			return value::size;
+		} else if (type == typeid(bool)) {
+			return value::boolean;
+		} else if (type == typeid(double)) {
+			return value::real;
+		} else if (type == typeid(std::chrono::nanoseconds)) {
+			return value::nanoseconds;
+		} else if (type == typeid(duration)) {
+			return value::nanoseconds;
+		} else if (type == typeid(std::chrono::high_resolution_clock::time_point)) {
+			return value::system_time_point;
+		} else if (type == typeid(time_point)) {
+			return value::time_point;
+		} else if (type == typeid(std::string)) {
+			return value::string;
+		}
+		throw std::runtime_error{std::string{"type "} + type.name() + " not implemented"};
+	}
+
+	static columnar_log_format::column_type type_of(value v) {
+		switch (v) {
+		case value::size:
+			return columnar_log_format::column_type::u64;
+		case value::boolean:
+			return columnar_log_format::column_type::boolean;
+		case value::real:
+			return columnar_log_format::column_type::f64;
+		case value::nanoseconds:
+		case value::system_time_point:
+		case value::time_point:
+			return columnar_log_format::column_type::i64;
+		case value::string:
+			return columnar_log_format::column_type::string;
+		}
+		return columnar_log_format::column_type::u64;
+	}
+
+	static constexpr std::size_t _s_initial_capacity = 1024 * 1024;
+
+	const std::string _m_path;
+	const record_header& _m_rh;
+	const std::uint32_t _m_chunk_rows;
+	std::vector<value> _m_values;
+	int _m_fd {-1};
+	std::byte* _m_data {nullptr};
+	std::size_t _m_capacity {0};
+	std::size_t _m_size {0};
+	// Offset of the chunk being filled, or 0 before the first
+	std::size_t _m_chunk {0};
+	std::uint32_t _m_chunk_count {0};
+	std::unordered_map<std::string, std::uint64_t> _m_strings;
+	// String ids of the record being appended, by column
+	std::vector<std::uint64_t> _m_string_ids;
+	std::mutex _m_lock;
+
+	void reserve(std::size_t capacity) {
+		if (ftruncate(_m_fd, static_cast<off_t>(capacity)) == -1) {
+			throw std::runtime_error{"ftruncate " + _m_path + ": " + strerror(errno)};
+		}
+		void* data = _m_data
+			? mremap(_m_data, _m_capacity, capacity, MREMAP_MAYMOVE)
+			: mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _m_fd, 0);
+		if (data == MAP_FAILED) {
+			throw std::runtime_error{"mmap " + _m_path + ": " + strerror(errno)};
+		}
+		_m_data = static_cast<std::byte*>(data);
+		_m_capacity = capacity;
+	}
+
+	/// Returns the offset of @p size new bytes at the end of the log.
+	std::size_t extend(std::size_t size) {
+		size = columnar_log_format::aligned(size);
+		if (_m_size + size > _m_capacity) {
+			std::size_t capacity = _m_capacity;
+			while (_m_size + size > capacity) {
+				capacity *= 2;
+			}
+			reserve(capacity);
+		}
+		std::size_t offset = _m_size;
+		_m_size += size;
+		return offset;
+	}
+
+	void append_bytes(const void* header, std::size_t header_size, const std::string& payload) {
+		std::size_t offset = extend(header_size + payload.size());
+		std::memcpy(_m_data + offset, header, header_size);
+		std::memcpy(_m_data + offset + header_size, payload.data(), payload.size());
+	}
+
+	void store(std::size_t column, std::uint64_t bits) {
+		std::byte* chunk_data = _m_data + _m_chunk + sizeof(columnar_log_format::block_header);
+		std::memcpy(chunk_data + (column * _m_chunk_rows + _m_chunk_count) * sizeof(bits), &bits, sizeof(bits));
+	}
+
+	template <typename T>
+	static std::uint64_t bits_of(T v) {
+		static_assert(sizeof(T) == sizeof(std::uint64_t));
+		std::uint64_t bits;
+		std::memcpy(&bits, &v, sizeof(bits));
+		return bits;
+	}
+
+	std::uint64_t intern(const std::string& s) {
+		auto found = _m_strings.find(s);
+		if (found != _m_strings.end()) {
+			return found->second;
+		}
+		assert(s.size() <= UINT32_MAX);
+		columnar_log_format::block_header header {columnar_log_format::block_kind::string, static_cast<std::uint32_t>(s.size()), 0, 0};
+		append_bytes(&header, sizeof(header), s);
+		return _m_strings.emplace(s, _m_strings.size()).first->second;
+	}
+
+	/// A row of a batch, read like a `record`
+	struct batch_row {
+		const record_batch& batch;
+		std::size_t row;
+
+		template <typename T>
+		const T& get_value(unsigned column) const {
+			return batch.column<T>(column)[row];
+		}
+	};
+
+	void append_locked(const record& r) {
+		assert(r.get_record_header() == _m_rh);
+		append_values(r);
+	}
+
+	void append_locked(const batch_row& r) {
+		append_values(r);
+	}
+
+	template <typename Row>
+	void append_values(const Row& r) {
+		// Strings go into blocks of their own, which may move the mapping, so they come first.
+		for (std::size_t i = 0; i < _m_values.size(); ++i) {
+			if (_m_values[i] == value::string) {
+				_m_string_ids[i] = intern(r.template get_value<std::string>(i));
+			}
+		}
+		if (_m_chunk == 0 || _m_chunk_count == _m_chunk_rows) {
+			_m_chunk = extend(sizeof(columnar_log_format::block_header) + _m_values.size() * _m_chunk_rows * sizeof(std::uint64_t));
+			_m_chunk_count = 0;
+			columnar_log_format::block_header header {columnar_log_format::block_kind::chunk, 0, _m_chunk_rows, 0};
+			std::memcpy(_m_data + _m_chunk, &header, sizeof(header));
+		}
+		for (std::size_t i = 0; i < _m_values.size(); ++i) {
+			switch (_m_values[i]) {
+			case value::size:
+				store(i, r.template get_value<std::size_t>(i));
+				break;
+			case value::boolean:
+				store(i, r.template get_value<bool>(i));
+				break;
+			case value::real:
+				store(i, bits_of(r.template get_value<double>(i)));
+				break;
+			case value::nanoseconds:
+				store(i, bits_of<std::int64_t>(r.template get_value<std::chrono::nanoseconds>(i).count()));
+				break;
+			case value::system_time_point:
+				store(i, bits_of<std::int64_t>(std::chrono::nanoseconds{r.template get_value<std::chrono::high_resolution_clock::time_point>(i).time_since_epoch()}.count()));
+				break;
+			case value::time_point:
+				store(i, bits_of<std::int64_t>(r.template get_value<time_point>(i).time_since_epoch().count()));
+				break;
+			case value::string:
+				store(i, _m_string_ids[i]);
+				break;
+			}
+		}
+		++_m_chunk_count;
+		std::memcpy(_m_data + _m_chunk + offsetof(columnar_log_format::block_header, count), &_m_chunk_count, sizeof(_m_chunk_count));
+	}
+
+	/// If nothing follows the last chunk, moves its columns together, so the file ends at its rows.
+	void shrink_last_chunk() {
+		const std::size_t row_bytes = _m_values.size() * sizeof(std::uint64_t);
+		const std::size_t header_size = sizeof(columnar_log_format::block_header);
+		if (_m_chunk == 0 || _m_chunk + header_size + row_bytes * _m_chunk_rows != _m_size) {
+			return;
+		}
+		std::byte* chunk_data = _m_data + _m_chunk + header_size;
+		for (std::size_t i = 1; i < _m_values.size(); ++i) {
+			std::memmove(chunk_data + i * _m_chunk_count * sizeof(std::uint64_t), chunk_data + i * _m_chunk_rows * sizeof(std::uint64_t), _m_chunk_count * sizeof(std::uint64_t));
+		}
+		std::memcpy(_m_data + _m_chunk + offsetof(columnar_log_format::block_header, capacity), &_m_chunk_count, sizeof(_m_chunk_count));
+		_m_size = _m_chunk + header_size + row_bytes * _m_chunk_count;
+		// Clears what was left, in case the truncation fails.
+		std::memset(_m_data + _m_size, 0, _m_capacity - _m_size);
+	}
+};
+
+/**
+ * @brief Loads a whole columnar log into one vector per column.
+ *
+ * Reads logs which are still being written, and logs whose writer was killed, up to their last
+ * complete row.
+ */
+class columnar_log_reader {
+public:
+	struct column {
+		std::string name;
+		columnar_log_format::column_type type;
+		// Each value's 8 bytes; string ids index `strings()`
+		std::vector<std::uint64_t> bits;
+	};
+
+	explicit columnar_log_reader(const std::string& path) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			throw std::runtime_error{"open " + path + ": " + strerror(errno)};
+		}
+		struct stat st;
+		if (fstat(fd, &st) == -1) {
+			close(fd);
+			throw std::runtime_error{"fstat " + path + ": " + strerror(errno)};
+		}
+		const std::size_t size = static_cast<std::size_t>(st.st_size);
+		const std::byte* data = nullptr;
+		if (size > 0) {
+			void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+			if (mapping == MAP_FAILED) {
+				close(fd);
+				throw std::runtime_error{"mmap " + path + ": " + strerror(errno)};
+			}
+			data = static_cast<const std::byte*>(mapping);
+		}
+		close(fd);
+		try {
+			load(path, data, size);
+		} catch (...) {
+			if (data) {
+				munmap(const_cast<std::byte*>(data), size);
+			}
+			throw;
+		}
+		if (data) {
+			munmap(const_cast<std::byte*>(data), size);
+		}
+	}
+
+	/// The `record_header` name
+	const std::string& name() const {
+		return _m_name;
+	}
+
+	const std::vector<column>& columns() const {
+		return _m_columns;
+	}
+
+	const std::vector<std::string>& strings() const {
+		return _m_strings;
+	}
+
+	std::size_t rows() const {
+		return _m_columns.empty() ? 0 : _m_columns[0].bits.size();
+	}
+
+	/**
+	 * @brief The values of column @p name, as `std::uint64_t`, `std::int64_t`, `double`, `bool` or
+	 * `std::string`, according to its type.
+	 */
+	template <typename T>
+	std::vector<T> get(const std::string& name) const {
+		const column& c = find(name);
+		check<T>(c);
+		std::vector<T> values;
+		values.reserve(c.bits.size());
+		for (std::uint64_t bits : c.bits) {
+			if constexpr (std::is_same_v<T, std::string>) {
+				values.push_back(_m_strings.at(bits));
+			} else if constexpr (std::is_same_v<T, bool>) {
+				values.push_back(bits != 0);
+			} else {
+				T value;
+				std::memcpy(&value, &bits, sizeof(value));
+				values.push_back(value);
+			}
+		}
+		return values;
+	}
+
+private:
+	std::string _m_name;
+	std::vector<column> _m_columns;
+	std::vector<std::string> _m_strings;
+
+	const column& find(const std::string& name) const {
+		for (const column& c : _m_columns) {
+			if (c.name == name) {
+				return c;
+			}
+		}
+		throw std::runtime_error{_m_name + " has no column " + name};
+	}
+
+	template <typename T>
+	void check(const column& c) const {
+		using columnar_log_format::column_type;
+		const bool matches =
+			   (std::is_same_v<T, std::uint64_t> && c.type == column_type::u64)
+			|| (std::is_same_v<T, std::int64_t> && c.type == column_type::i64)
+			|| (std::is_same_v<T, double> && c.type == column_type::f64)
+			|| (std::is_same_v<T, bool> && c.type == column_type::boolean)
+			|| (std::is_same_v<T, std::string> && c.type == column_type::string);
+		if (!matches) {
+			throw std::runtime_error{"column " + c.name + " of " + _m_name + " holds " + columnar_log_format::type_name(c.type)
+				+ ", not " + typeid(T).name()};
+		}
+	}
+
+	void load(const std::string& path, const std::byte* data, std::size_t size) {
+		columnar_log_format::file_header header {};
+		if (size >= sizeof(header)) {
+			std::memcpy(&header, data, sizeof(header));
+		}
+		if (header.magic != columnar_log_format::magic || header.version != columnar_log_format::version) {
+			throw std::runtime_error{path + " is not a version " + std::to_string(columnar_log_format::version) + " columnar log"};
+		}
+		const auto truncated = [&] {
+			return std::runtime_error{path + ": truncated schema"};
+		};
+		std::size_t offset = columnar_log_format::aligned(sizeof(header) + header.name_size);
+		if (offset > size) {
+			throw truncated();
+		}
+		_m_name.assign(reinterpret_cast<const char*>(data) + sizeof(header), header.name_size);
+		for (std::uint32_t i = 0; i < header.columns; ++i) {
+			columnar_log_format::column_header column_header;
+			if (offset + sizeof(column_header) > size) {
+				throw truncated();
+			}
+			std::memcpy(&column_header, data + offset, sizeof(column_header));
+			const std::size_t column_size = columnar_log_format::aligned(sizeof(column_header) + column_header.name_size);
+			if (offset + column_size > size) {
+				throw truncated();
+			}
+			_m_columns.push_back(column{
+				std::string{reinterpret_cast<const char*>(data) + offset + sizeof(column_header), column_header.name_size},
+				column_header.type,
+				{},
+			});
+			offset += column_size;
+		}
+
+		while (offset + sizeof(columnar_log_format::block_header) <= size) {
+			columnar_log_format::block_header block;
+			std::memcpy(&block, data + offset, sizeof(block));
+			const std::byte* payload = data + offset + sizeof(block);
+			std::size_t block_size;
+			if (block.kind == columnar_log_format::block_kind::chunk) {
+				block_size = sizeof(block) + _m_columns.size() * block.capacity * sizeof(std::uint64_t);
+			} else if (block.kind == columnar_log_format::block_kind::string) {
+				block_size = columnar_log_format::aligned(sizeof(block) + block.count);
+			} else {
+				break;
+			}
+			if (offset + block_size > size) {
+				break;
+			}
+			if (block.kind == columnar_log_format::block_kind::chunk) {
+				const std::size_t rows = std::min(block.count, block.capacity);
+				for (std::size_t i = 0; i < _m_columns.size(); ++i) {
+					std::vector<std::uint64_t>& bits = _m_columns[i].bits;
+					const std::size_t start = bits.size();
+					bits.resize(start + rows);
+					std::memcpy(bits.data() + start, payload + i * block.capacity * sizeof(std::uint64_t), rows * sizeof(std::uint64_t));
+				}
+			} else {
+				_m_strings.emplace_back(reinterpret_cast<const char*>(payload), block.count);
+			}
+			offset += block_size;
+		}
+
+		for (const column& c : _m_columns) {
+			if (c.type != columnar_log_format::column_type::string) {
+				continue;
+			}
+			for (std::uint64_t id : c.bits) {
+				if (id >= _m_strings.size()) {
+					throw std::runtime_error{path + ": column " + c.name + " refers to undefined string " + std::to_string(id)};
+				}
+			}
+		}
+	}
+};
+
+}
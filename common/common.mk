@@ -23,8 +23,9 @@ DBG_FLAGS ?= -Og -g $(MONADO_FLAGS) -Wall -Wextra -Werror -rdynamic
 #> NDEBUG disables debugging output and logic
 OPT_FLAGS ?= -O3 -DNDEBUG $(MONADO_FLAGS) -Wall -Wextra -Werror
 
-CPP_FILES ?= $(shell find . -name '*.cpp' -not -name 'plugin.cpp' -not -name 'main.cpp' -not -path '*/tests/*')
+CPP_FILES ?= $(shell find . -name '*.cpp' -not -name 'plugin.cpp' -not -name 'main.cpp' -not -path '*/tests/*' -not -path '*/benchmarks/*')
 CPP_TEST_FILES ?= $(shell find tests/ -name '*.cpp' 2>/dev/null)
+CPP_BENCH_FILES ?= $(shell find benchmarks/ -name '*.cpp' 2>/dev/null)
 HPP_FILES ?= $(shell find -L . -name '*.hpp')
 # I need -L to follow symlinks in common/
 LDFLAGS := -ggdb $(LDFLAGS)
@@ -62,14 +63,19 @@ main.opt.exe: main.cpp $(CPP_FILES) $(HPP_FILES) Makefile
 	$(CXX)        -std=$(STDCXX) $(CFLAGS) $(CPPFLAGS) $(OPT_FLAGS) \
 	-o $@ $<
 
-.PHONY: tests/run tests/gdb
+.PHONY: tests/run tests/gdb tests/tsan
 ifeq ($(CPP_TEST_FILES),)
 tests/run:
 tests/gdb:
+tests/tsan:
 else
 tests/run: tests/test.exe
 	./tests/test.exe
 
+## ThreadSanitizer cannot be combined with AddressSanitizer, so it gets its own binary.
+tests/tsan: tests/test.tsan.exe
+	./tests/test.tsan.exe
+
 tests/gdb: tests/test.exe
 	gdb -q ./tests/test.exe -ex run
 
@@ -77,12 +83,30 @@ tests/test.exe: $(CPP_TEST_FILES) $(CPP_FILES) $(HPP_FILES)
 	$(CXX) -ggdb -std=$(STDCXX) $(CFLAGS) $(CPPFLAGS) $(DBG_FLAGS) \
 	$(GTEST_FLAGS) -fsanitize=address,undefined -o ./tests/test.exe \
 	$(CPP_TEST_FILES) $(CPP_FILES) $(LDFLAGS)
+
+tests/test.tsan.exe: $(CPP_TEST_FILES) $(CPP_FILES) $(HPP_FILES)
+	$(CXX) -ggdb -std=$(STDCXX) $(CFLAGS) $(CPPFLAGS) $(DBG_FLAGS) \
+	$(GTEST_FLAGS) -fsanitize=thread -o ./tests/test.tsan.exe \
+	$(CPP_TEST_FILES) $(CPP_FILES) $(LDFLAGS)
+endif
+
+## Each file in benchmarks/ is a standalone program, built with the optimized flags.
+.PHONY: benchmarks/run
+ifeq ($(CPP_BENCH_FILES),)
+benchmarks/run:
+else
+benchmarks/run: $(CPP_BENCH_FILES:.cpp=.exe)
+	for bench in $^; do ./$$bench || exit 1; done
+
+benchmarks/%.exe: benchmarks/%.cpp $(CPP_FILES) $(HPP_FILES)
+	$(CXX) -std=$(STDCXX) $(CFLAGS) $(CPPFLAGS) $(OPT_FLAGS) -pthread \
+	-o $@ $< $(CPP_FILES) $(LDFLAGS)
 endif
 
 .PHONY: clean
 clean:
 	touch _target && \
-	$(RM) _target *.so *.exe *.o ./tests/test.exe
+	$(RM) _target *.so *.exe *.o ./tests/*.exe ./benchmarks/*.exe
 # if *.so and *.o do not exist, rm will still work, because it still receives an operand (target)
 
 .PHONY: deepclean
@@ -254,4 +254,22 @@ namespace ILLIXR {
           , render_quaternion{render_quaternion_}
         { }
     };
+
+	/**
+	 * The topics which plugins share, with their event types; pass these to the switchboard instead
+	 * of strings, so that a plugin cannot disagree with the others about a topic's type.
+	 */
+	namespace topics {
+		inline constexpr switchboard::topic_descriptor<imu_cam_type> imu_cam {"imu_cam"};
+		inline constexpr switchboard::topic_descriptor<rgb_depth_type> rgb_depth {"rgb_depth"};
+		inline constexpr switchboard::topic_descriptor<imu_integrator_input> imu_integrator_input {"imu_integrator_input"};
+		inline constexpr switchboard::topic_descriptor<imu_raw_type> imu_raw {"imu_raw"};
+		inline constexpr switchboard::topic_descriptor<pose_type> slow_pose {"slow_pose"};
+		inline constexpr switchboard::topic_descriptor<pose_type> true_pose {"true_pose"};
+		inline constexpr switchboard::topic_descriptor<switchboard::event_wrapper<Eigen::Vector3f>> ground_truth_offset {"ground_truth_offset"};
+		inline constexpr switchboard::topic_descriptor<switchboard::event_wrapper<time_point>> vsync_estimate {"vsync_estimate"};
+		inline constexpr switchboard::topic_descriptor<rendered_frame> eyebuffer {"eyebuffer"};
+		inline constexpr switchboard::topic_descriptor<hologram_input> hologram_in {"hologram_in"};
+		inline constexpr switchboard::topic_descriptor<texture_pose> texture_pose {"texture_pose"};
+	}
 }
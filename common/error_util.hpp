@@ -35,18 +35,21 @@ static const bool ENABLE_VERBOSE_ERRORS {ILLIXR::str_to_bool(ILLIXR::getenv_or("
  * If errno is set, this function will report errno's value and the calling context.
  * It will subsequently clear errno (reset value to 0).
  * Otherwise, this function does nothing.
+ *
+ * The arguments are C strings, so that calls on hot paths (e.g. `thread_cpu_time()`, once per
+ * switchboard callback) do not allocate.
  */
 inline void report_and_clear_errno(
-    [[maybe_unused]] const std::string& file,
+    [[maybe_unused]] const char* file,
     [[maybe_unused]] const int& line,
-    [[maybe_unused]] const std::string& function,
-    [[maybe_unused]] const std::string& msg = ""
+    [[maybe_unused]] const char* function,
+    [[maybe_unused]] const char* msg = ""
 ) {
 #ifndef NDEBUG
     if (errno > 0) {
         if (ILLIXR::ENABLE_VERBOSE_ERRORS) {
             std::cerr << "|| Errno was set: " << errno << " @ " << file << ":" << line << "[" << function << "]" << std::endl;
-            if (!msg.empty()) {
+            if (msg[0] != '\0') {
                 std::cerr << "|> Message: " << msg << std::endl;
             }
         }
@@ -0,0 +1,554 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include <experimental/filesystem>
+
+#include <semaphore.h>
+#include <time.h>
+
+#include "columnar_log.hpp"
+#include "global_module_defs.hpp"
+#include "record_logger.hpp"
+
+namespace ILLIXR {
+
+/**
+ * @brief Keeps the last seconds of some records in memory, and writes them out when something goes wrong.
+ *
+ * This is a `record_logger` which passes every record on to another logger (@p inner, which may
+ * well be a `noop_record_logger`), and also keeps the records it is told to (`config::records`).
+ * Those are held in chunks of columns, like a `typed_record_coalescer`'s; chunks older than
+ * `config::window`, or beyond `config::max_rows` of a record type, are reused for new records. With
+ * a `record_flusher`, hot threads only push into their rings, and the recorder copies the records
+ * in from the flusher's thread.
+ *
+ * A dump writes each kept record type to a columnar log (see `common/columnar_log.hpp`), in a
+ * directory which only appears, under `config::dir`, once it is complete. It is named after its
+ * sequence number and what caused it:
+ *
+ * - a record of one of `config::triggers` (by default a switchboard deadline miss, or a stale
+ *   frame in timewarp_gl), at most once per `config::cooldown`;
+ * - `request()`, or SIGUSR1;
+ * - a crash (SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT): the crashing thread waits a few seconds
+ *   for the dump, then the signal goes on to the handler installed before the recorder (by
+ *   default, the signal's default action).
+ *
+ * Dumps are written by a thread of the recorder, named `flight_recorder` by @p on_start. Since
+ * signal handlers are process-wide, the most recently constructed recorder gets the signals.
+ * Handlers meant to run on a crash should be installed before it, so it hands the signal on to
+ * them; when destroyed, it leaves alone any handler installed after it.
+ */
+class flight_recorder : public record_logger {
+public:
+	struct config {
+		/// Names of the record types to keep
+		std::vector<std::string> records;
+		/// Names of the record types which cause a dump
+		std::vector<std::string> triggers;
+		std::chrono::milliseconds window;
+		/// Per record type
+		std::size_t max_rows;
+		/// The least time between dumps caused by records
+		std::chrono::milliseconds cooldown;
+		std::experimental::filesystem::path dir;
+
+		/**
+		 * @brief Read from the environment:
+		 *
+		 * - `ILLIXR_FLIGHT_RECORDER`: the seconds to keep (default 10), or 0 to keep none.
+		 * - `ILLIXR_FLIGHT_RECORDER_RECORDS`: comma-separated (default
+		 *   `threadloop_iteration,switchboard_callback,mtp_record`).
+		 * - `ILLIXR_FLIGHT_RECORDER_TRIGGERS`: comma-separated (default
+		 *   `switchboard_deadline_miss,timewarp_stale_frame`).
+		 * - `ILLIXR_FLIGHT_RECORDER_ROWS`: the most rows kept per record type (default 65536).
+		 *
+		 * The cooldown is the window, and dumps go in `metrics/flight_recorder`.
+		 */
+		static config from_env() {
+			const std::chrono::seconds window {std::stoul(getenv_or("ILLIXR_FLIGHT_RECORDER", "10"))};
+			return config{
+				split(getenv_or("ILLIXR_FLIGHT_RECORDER_RECORDS", "threadloop_iteration,switchboard_callback,mtp_record")),
+				split(getenv_or("ILLIXR_FLIGHT_RECORDER_TRIGGERS", "switchboard_deadline_miss,timewarp_stale_frame")),
+				window,
+				std::stoul(getenv_or("ILLIXR_FLIGHT_RECORDER_ROWS", "65536")),
+				window,
+				"metrics/flight_recorder",
+			};
+		}
+
+		/// Whether there is anything to keep
+		bool active() const {
+			return window.count() > 0 && max_rows > 0 && !records.empty();
+		}
+
+		static std::vector<std::string> split(const std::string& names) {
+			std::vector<std::string> result;
+			std::istringstream stream {names};
+			std::string name;
+			while (std::getline(stream, name, ',')) {
+				if (!name.empty()) {
+					result.push_back(name);
+				}
+			}
+			return result;
+		}
+	};
+
+	flight_recorder(std::shared_ptr<record_logger> inner, config config_, std::shared_ptr<record_flusher> flusher = nullptr, std::function<void()> on_start = {})
+		: _m_inner{std::move(inner)}
+		, _m_config{std::move(config_)}
+		, _m_flusher{std::move(flusher)}
+	{
+		// Dumps are of this run only, as other metrics are.
+		std::experimental::filesystem::remove_all(_m_config.dir);
+		if (sem_init(&_m_wake, 0, 0) == -1) {
+			throw std::runtime_error{std::string{"flight_recorder: sem_init: "} + strerror(errno)};
+		}
+		_m_thread = std::thread{[this, on_start] {
+			if (on_start) {
+				on_start();
+			}
+			thread_main();
+		}};
+		install_signal_handlers();
+	}
+
+	flight_recorder(const flight_recorder&) = delete;
+	flight_recorder& operator=(const flight_recorder&) = delete;
+
+	virtual ~flight_recorder() override {
+		restore_signal_handlers();
+		_m_stopping.store(true);
+		sem_post(&_m_wake);
+		_m_thread.join();
+		sem_destroy(&_m_wake);
+	}
+
+	virtual void log(const record& r) override {
+		if (_m_inner && _m_inner->enabled(r.get_record_header())) {
+			_m_inner->log(r);
+		} else {
+			r.mark_used();
+		}
+		keep(r.get_record_header(), 1, [&r](column& c, unsigned i, std::size_t, std::size_t) {
+			c.store(r, i, 0);
+		});
+	}
+
+	virtual void log(const std::vector<record>& rs) override {
+		if (rs.empty()) {
+			return;
+		}
+		if (_m_inner && _m_inner->enabled(rs[0].get_record_header())) {
+			_m_inner->log(rs);
+		} else {
+			for (const record& r : rs) {
+				r.mark_used();
+			}
+		}
+		keep(rs[0].get_record_header(), rs.size(), [&rs](column& c, unsigned i, std::size_t row, std::size_t n) {
+			for (std::size_t j = 0; j < n; ++j) {
+				c.store(rs[row + j], i, j);
+			}
+		});
+	}
+
+	virtual void log(const record_batch& batch) override {
+		if (_m_inner && _m_inner->enabled(batch.header)) {
+			_m_inner->log(batch);
+		}
+		keep(batch.header, batch.rows, [&batch](column& c, unsigned i, std::size_t row, std::size_t n) {
+			c.copy(batch.columns[i], row, n);
+		});
+	}
+
+	virtual bool enabled() const override {
+		return true;
+	}
+
+	virtual bool enabled(const record_header& rh) const override {
+		return (_m_inner && _m_inner->enabled(rh)) || is_kept(rh) || trigger_of(rh) != no_cause;
+	}
+
+	/**
+	 * @brief Dumps what is kept, soon, from the recorder's thread.
+	 *
+	 * Thread-safe, and async-signal-safe.
+	 */
+	void request() {
+		cause(requested);
+	}
+
+	/**
+	 * @brief The dumps written so far.
+	 */
+	std::size_t dumps() const {
+		return _m_dumps.load();
+	}
+
+private:
+	/**
+	 * @brief Values of one column of up to `chunk_rows` rows, of one of the types `is_record_column_v` allows.
+	 */
+	class column {
+	public:
+		virtual ~column() = default;
+		/// Stores column @p i of @p r in row `rows_stored + row`
+		virtual void store(const record& r, unsigned i, std::size_t row) = 0;
+		/// Stores @p n values starting at index @p from of @p values, an array of this column's type,
+		/// in the rows from `rows_stored` on
+		virtual void copy(const void* values, std::size_t from, std::size_t n) = 0;
+		virtual const void* data() const = 0;
+		std::size_t rows_stored {0};
+	};
+
+	template <typename T>
+	class typed_column : public column {
+	public:
+		virtual void store(const record& r, unsigned i, std::size_t row) override {
+			_m_values[rows_stored + row] = r.get_value<T>(i);
+		}
+
+		virtual void copy(const void* values, std::size_t from, std::size_t n) override {
+			const T* begin = static_cast<const T*>(values) + from;
+			std::copy(begin, begin + n, _m_values.get() + rows_stored);
+		}
+
+		virtual const void* data() const override {
+			return _m_values.get();
+		}
+
+	private:
+		std::unique_ptr<T[]> _m_values {new T[chunk_rows]};
+	};
+
+	static std::unique_ptr<column> make_column(const std::type_info& type) {
+		if (false) {
+		} else if (type == typeid(std::size_t)) {
+			return std::make_unique<typed_column<std::size_t>>();
+		} else if (type == typeid(bool)) {
+			return std::make_unique<typed_column<bool>>();
+		} else if (type == typeid(double)) {
+			return std::make_unique<typed_column<double>>();
+		} else if (type == typeid(std::chrono::nanoseconds)) {
+			return std::make_unique<typed_column<std::chrono::nanoseconds>>();
+		} else if (type == typeid(std::chrono::high_resolution_clock::time_point)) {
+			return std::make_unique<typed_column<std::chrono::high_resolution_clock::time_point>>();
+		} else if (type == typeid(time_point)) {
+			return std::make_unique<typed_column<time_point>>();
+		} else if (type == typeid(std::string)) {
+			return std::make_unique<typed_column<std::string>>();
+		} else {
+			throw std::runtime_error{std::string{"type "} + type.name() + " not implemented"};
+		}
+	}
+
+	static constexpr std::size_t chunk_rows = 256;
+
+	struct chunk {
+		std::vector<std::unique_ptr<column>> columns;
+		std::size_t rows {0};
+		/// When the last row came in
+		std::chrono::steady_clock::time_point newest;
+	};
+
+	/// What is kept of one record type
+	struct track {
+		const record_header* rh;
+		std::deque<std::unique_ptr<chunk>> chunks;
+		std::size_t rows {0};
+		/// Emptied chunks, to be reused
+		std::vector<std::unique_ptr<chunk>> spare;
+	};
+
+	bool is_kept(const record_header& rh) const {
+		return std::find(_m_config.records.cbegin(), _m_config.records.cend(), rh.get_name()) != _m_config.records.cend();
+	}
+
+	/// Causes of a dump; record triggers are their index in `config::triggers`.
+	static constexpr int no_cause = -1;
+	static constexpr int requested = -2;
+	static constexpr int crashed = -3;
+
+	int trigger_of(const record_header& rh) const {
+		auto found = std::find(_m_config.triggers.cbegin(), _m_config.triggers.cend(), rh.get_name());
+		return found == _m_config.triggers.cend() ? no_cause : static_cast<int>(found - _m_config.triggers.cbegin());
+	}
+
+	std::string name_of(int cause_) const {
+		switch (cause_) {
+		case requested:
+			return "request";
+		case crashed:
+			return "crash";
+		default:
+			return _m_config.triggers[static_cast<std::size_t>(cause_)];
+		}
+	}
+
+	/// A crash outranks a request, which outranks records.
+	static int rank(int cause_) {
+		return cause_ == crashed ? 3 : cause_ == requested ? 2 : cause_ == no_cause ? 0 : 1;
+	}
+
+	/**
+	 * @brief Has the recorder's thread dump for @p cause_, unless a dump for as much is pending.
+	 *
+	 * Async-signal-safe
+	 */
+	void cause(int cause_) {
+		int pending = _m_cause.load();
+		while (rank(cause_) > rank(pending)) {
+			if (_m_cause.compare_exchange_weak(pending, cause_)) {
+				sem_post(&_m_wake);
+				return;
+			}
+		}
+	}
+
+	/**
+	 * @brief Keeps @p rows records of @p rh, if they are to be kept, and dumps if they are a trigger.
+	 *
+	 * `store(c, i, row, n)` fills column `c` (the `i`th) of a chunk with rows `row` to `row + n`.
+	 */
+	template <typename Store>
+	void keep(const record_header& rh, std::size_t rows, Store&& store) {
+		const int trigger = trigger_of(rh);
+		if (trigger != no_cause) {
+			cause(trigger);
+		}
+		if (rows == 0 || !_m_config.active() || !is_kept(rh)) {
+			return;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		track& t = _m_tracks.try_emplace(rh.get_id(), track{&rh, {}, 0, {}}).first->second;
+		for (std::size_t row = 0; row < rows; ) {
+			if (t.chunks.empty() || t.chunks.back()->rows == chunk_rows) {
+				t.chunks.push_back(new_chunk(t));
+			}
+			chunk& c = *t.chunks.back();
+			const std::size_t n = std::min(rows - row, chunk_rows - c.rows);
+			for (unsigned i = 0; i < rh.get_columns(); ++i) {
+				column& col = *c.columns[i];
+				col.rows_stored = c.rows;
+				store(col, i, row, n);
+			}
+			c.rows += n;
+			c.newest = now;
+			t.rows += n;
+			row += n;
+		}
+		evict(t, now);
+	}
+
+	/// Requires _m_lock
+	std::unique_ptr<chunk> new_chunk(track& t) {
+		if (!t.spare.empty()) {
+			std::unique_ptr<chunk> c = std::move(t.spare.back());
+			t.spare.pop_back();
+			c->rows = 0;
+			return c;
+		}
+		auto c = std::make_unique<chunk>();
+		for (unsigned i = 0; i < t.rh->get_columns(); ++i) {
+			c->columns.push_back(make_column(t.rh->get_column_type(i)));
+		}
+		return c;
+	}
+
+	/// Requires _m_lock
+	void evict(track& t, std::chrono::steady_clock::time_point now) {
+		while (t.chunks.size() > 1
+			   && (t.rows - t.chunks.front()->rows >= _m_config.max_rows || t.chunks.front()->newest < now - _m_config.window)) {
+			t.rows -= t.chunks.front()->rows;
+			t.spare.push_back(std::move(t.chunks.front()));
+			t.chunks.pop_front();
+		}
+	}
+
+	void thread_main() {
+		while (true) {
+			while (sem_wait(&_m_wake) == -1 && errno == EINTR) { }
+			if (_m_stopping.load()) {
+				return;
+			}
+			const int cause_ = _m_cause.exchange(no_cause);
+			if (cause_ == no_cause) {
+				continue;
+			}
+			const auto now = std::chrono::steady_clock::now();
+			if (cause_ >= 0 && _m_dumps.load() > 0 && now < _m_last_dump + _m_config.cooldown) {
+				continue;
+			}
+			_m_last_dump = now;
+			dump(cause_);
+			if (cause_ == crashed) {
+				_m_crash_dumped.store(true);
+			}
+		}
+	}
+
+	void dump(int cause_) {
+		// What is still in the flusher's rings is the latest, and most wanted. After a crash, the
+		// flusher may never let go of them.
+		if (_m_flusher) {
+			if (cause_ == crashed) {
+				_m_flusher->try_flush();
+			} else {
+				_m_flusher->flush();
+			}
+		}
+
+		// Taken out, so that records keep coming in while they are written. Not a vector, which
+		// would copy tracks as it grows (std::deque's move may throw).
+		std::deque<track> taken;
+		{
+			const std::lock_guard<std::mutex> lock {_m_lock};
+			for (auto& pair : _m_tracks) {
+				track& t = pair.second;
+				taken.push_back(track{t.rh, std::move(t.chunks), t.rows, {}});
+				t.chunks.clear();
+				t.rows = 0;
+			}
+		}
+
+		const std::size_t number = _m_dumps.load();
+		const std::string name = std::to_string(number) + "_" + name_of(cause_);
+		const std::experimental::filesystem::path partial = _m_config.dir / ("." + name + ".partial");
+		std::size_t rows = 0;
+		try {
+			std::experimental::filesystem::create_directories(partial);
+			for (const track& t : taken) {
+				columnar_log_writer writer {partial / (t.rh->get_name() + ".cols"), *t.rh};
+				for (const auto& c : t.chunks) {
+					std::vector<const void*> columns;
+					for (const auto& col : c->columns) {
+						columns.push_back(col->data());
+					}
+					writer.append(record_batch{*t.rh, c->rows, columns.data()});
+				}
+				rows += t.rows;
+			}
+			// Readers never see a partial dump.
+			std::experimental::filesystem::rename(partial, _m_config.dir / name);
+			std::cerr << "flight_recorder: dumped " << rows << " records to " << (_m_config.dir / name).string() << std::endl;
+		} catch (const std::exception& e) {
+			std::cerr << "flight_recorder: dump " << name << " failed: " << e.what() << std::endl;
+		}
+		_m_dumps.store(number + 1);
+
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		for (track& t : taken) {
+			track& kept = _m_tracks.at(t.rh->get_id());
+			for (auto& c : t.chunks) {
+				kept.spare.push_back(std::move(c));
+			}
+		}
+	}
+
+	static std::atomic<flight_recorder*>& instance() {
+		static std::atomic<flight_recorder*> instance_ {nullptr};
+		return instance_;
+	}
+
+	static constexpr int crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+	static void on_request([[maybe_unused]] int sig) {
+		if (flight_recorder* recorder = instance().load()) {
+			recorder->request();
+		}
+	}
+
+	static void on_crash(int sig) {
+		if (flight_recorder* recorder = instance().load()) {
+			recorder->cause(crashed);
+			// Up to 5 s; sleeping is async-signal-safe, unlike waiting on the semaphore.
+			for (int i = 0; i < 500 && !recorder->_m_crash_dumped.load(); ++i) {
+				const timespec period {0, 10 * 1000 * 1000};
+				nanosleep(&period, nullptr);
+			}
+			for (std::size_t i = 0; i < std::size(crash_signals); ++i) {
+				if (crash_signals[i] == sig) {
+					sigaction(sig, &recorder->_m_previous_crash[i], nullptr);
+				}
+			}
+		}
+		// Otherwise, the handler was reset, so this takes the default action.
+		raise(sig);
+	}
+
+	void install_signal_handlers() {
+		instance().store(this);
+		struct sigaction request_action {};
+		request_action.sa_handler = &on_request;
+		request_action.sa_flags = SA_RESTART;
+		sigemptyset(&request_action.sa_mask);
+		sigaction(SIGUSR1, &request_action, &_m_previous_request);
+
+		struct sigaction crash_action {};
+		crash_action.sa_handler = &on_crash;
+		crash_action.sa_flags = SA_RESETHAND;
+		sigemptyset(&crash_action.sa_mask);
+		for (std::size_t i = 0; i < std::size(crash_signals); ++i) {
+			sigaction(crash_signals[i], &crash_action, &_m_previous_crash[i]);
+		}
+	}
+
+	void restore_signal_handlers() {
+		flight_recorder* self = this;
+		if (instance().compare_exchange_strong(self, nullptr)) {
+			restore_signal_handler(SIGUSR1, &on_request, _m_previous_request);
+			for (std::size_t i = 0; i < std::size(crash_signals); ++i) {
+				restore_signal_handler(crash_signals[i], &on_crash, _m_previous_crash[i]);
+			}
+		}
+	}
+
+	/// Puts @p previous back for @p sig, unless @p handler has been replaced since.
+	static void restore_signal_handler(int sig, void (*handler)(int), const struct sigaction& previous) {
+		struct sigaction current {};
+		sigaction(sig, nullptr, &current);
+		if (!(current.sa_flags & SA_SIGINFO) && current.sa_handler == handler) {
+			sigaction(sig, &previous, nullptr);
+		}
+	}
+
+	const std::shared_ptr<record_logger> _m_inner;
+	const config _m_config;
+	const std::shared_ptr<record_flusher> _m_flusher;
+	std::mutex _m_lock;
+	// By record_header id
+	std::unordered_map<std::size_t, track> _m_tracks;
+
+	sem_t _m_wake;
+	std::atomic<int> _m_cause {no_cause};
+	std::atomic<bool> _m_stopping {false};
+	std::atomic<bool> _m_crash_dumped {false};
+	std::atomic<std::size_t> _m_dumps {0};
+	// Only for the recorder's thread
+	std::chrono::steady_clock::time_point _m_last_dump;
+	struct sigaction _m_previous_request {};
+	struct sigaction _m_previous_crash[std::size(crash_signals)] {};
+	std::thread _m_thread;
+};
+
+}
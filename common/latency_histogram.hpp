@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ILLIXR {
+
+/**
+ * @brief A lock-free histogram of durations, with HDR-style log-linear buckets.
+ *
+ * Durations are counted in nanoseconds. Below 2^_s_sub_bits ns every value has its own bucket;
+ * above that, each power of two is split into 2^_s_sub_bits buckets, so a bucket is never wider
+ * than 1/32 of the values in it (about 3% error). Values beyond 2^_s_max_exponent ns (about a
+ * minute) go in the last bucket.
+ *
+ * `record` is a relaxed `fetch_add` on one bucket, so any thread may record at any time. Readers
+ * take a `snapshot`, which is consistent per bucket but not across buckets.
+ */
+class latency_histogram {
+private:
+	static constexpr unsigned _s_sub_bits = 5;
+	static constexpr std::uint64_t _s_sub_buckets = std::uint64_t{1} << _s_sub_bits;
+	static constexpr unsigned _s_max_exponent = 36;
+	static constexpr std::size_t _s_buckets = (_s_max_exponent - _s_sub_bits + 2) * _s_sub_buckets;
+
+	static unsigned log2(std::uint64_t value) {
+		return 63 - static_cast<unsigned>(__builtin_clzll(value));
+	}
+
+	static std::size_t bucket_of(std::uint64_t value) {
+		if (value < _s_sub_buckets) {
+			return static_cast<std::size_t>(value);
+		}
+		unsigned exponent = log2(value);
+		if (exponent > _s_max_exponent) {
+			return _s_buckets - 1;
+		}
+		unsigned shift = exponent - _s_sub_bits;
+		return static_cast<std::size_t>((shift + 1) * _s_sub_buckets + ((value >> shift) & (_s_sub_buckets - 1)));
+	}
+
+	/// The middle of the values which land in @p bucket
+	static std::uint64_t value_of(std::size_t bucket) {
+		if (bucket < _s_sub_buckets) {
+			return bucket;
+		}
+		unsigned shift = static_cast<unsigned>(bucket / _s_sub_buckets) - 1;
+		std::uint64_t lowest = (_s_sub_buckets + bucket % _s_sub_buckets) << shift;
+		return lowest + ((std::uint64_t{1} << shift) >> 1);
+	}
+
+	std::array<std::atomic<std::uint64_t>, _s_buckets> _m_counts {};
+	std::atomic<std::uint64_t> _m_max {0};
+
+public:
+	/**
+	 * @brief A point-in-time copy of a `latency_histogram`, for computing percentiles.
+	 */
+	class snapshot {
+	public:
+		std::uint64_t count() const {
+			return _m_count;
+		}
+
+		std::chrono::nanoseconds max() const {
+			return std::chrono::nanoseconds{_m_max};
+		}
+
+		/**
+		 * @brief The smallest recorded duration which at least @p fraction (0 to 1) of the values do not exceed.
+		 *
+		 * Exact up to the bucket width; 0 if nothing was recorded.
+		 */
+		std::chrono::nanoseconds percentile(double fraction) const {
+			if (_m_count == 0) {
+				return std::chrono::nanoseconds{0};
+			}
+			auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(_m_count - 1)) + 1;
+			std::uint64_t seen = 0;
+			for (std::size_t bucket = 0; bucket < _s_buckets; ++bucket) {
+				seen += _m_counts[bucket];
+				if (seen >= rank) {
+					if (bucket == _s_buckets - 1) {
+						// The overflow bucket has no meaningful middle.
+						return max();
+					}
+					// The bucket's middle may overshoot the largest value actually seen.
+					return std::chrono::nanoseconds{static_cast<std::int64_t>(std::min(value_of(bucket), _m_max))};
+				}
+			}
+			return max();
+		}
+
+	private:
+		friend class latency_histogram;
+		std::array<std::uint64_t, _s_buckets> _m_counts {};
+		std::uint64_t _m_count {0};
+		std::uint64_t _m_max {0};
+	};
+
+	/**
+	 * @brief Counts one duration. Negative durations count as 0.
+	 *
+	 * Thread-safe, lock-free
+	 */
+	void record(std::chrono::nanoseconds duration) {
+		std::uint64_t value = duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0;
+		_m_counts[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+		std::uint64_t max = _m_max.load(std::memory_order_relaxed);
+		while (value > max && !_m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+	}
+
+	/**
+	 * @brief Copies the counts out.
+	 *
+	 * Thread-safe
+	 */
+	snapshot get_snapshot() const {
+		snapshot copy;
+		for (std::size_t bucket = 0; bucket < _s_buckets; ++bucket) {
+			copy._m_counts[bucket] = _m_counts[bucket].load(std::memory_order_relaxed);
+			copy._m_count += copy._m_counts[bucket];
+		}
+		copy._m_max = _m_max.load(std::memory_order_relaxed);
+		return copy;
+	}
+};
+
+} // namespace ILLIXR
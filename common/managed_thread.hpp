@@ -55,7 +55,7 @@ public:
 	 * @brief Stops a thread, if necessary
 	 */
 	~managed_thread() noexcept {
-		if (get_state() == state::running) {
+		if (_m_thread.joinable()) {
 			stop();
 		}
 		assert(get_state() == state::stopped || get_state() == state::startable || get_state() == state::nonstartable);
@@ -98,11 +98,22 @@ public:
 	}
 
 	/**
-	 * @brief Moves a managed_thread from running to stopped
+	 * @brief Moves a managed_thread from running to stopped, without waiting for it to exit.
+	 *
+	 * The thread exits after the current call to body. If body blocks, call this, then wake body,
+	 * then call `stop()` to join.
 	 */
-	void stop() {
+	void request_stop() {
 		assert(get_state() == state::running);
 		_m_stop.store(true);
+	}
+
+	/**
+	 * @brief Moves a managed_thread from running to stopped, and joins it
+	 */
+	void stop() {
+		assert(get_state() == state::running || (get_state() == state::stopped && _m_thread.joinable()));
+		_m_stop.store(true);
 		_m_thread.join();
 		assert(get_state() == state::stopped);
 	}
@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include <mutex>
 #include <shared_mutex>
 #include <memory>
 #include <unordered_map>
@@ -105,6 +106,17 @@ namespace ILLIXR {
 			_m_registry.try_emplace(type_index, impl);
 		}
 
+		/**
+		 * @brief Whether an implementation of @p specific_service is registered, for optional services.
+		 *
+		 * Safe to be called from any thread.
+		 */
+		template <typename specific_service>
+		bool has_impl() const {
+			const std::shared_lock<std::shared_mutex> lock{_m_mutex};
+			return _m_registry.count(std::type_index(typeid(specific_service))) == 1;
+		}
+
 		/**
 		 * @brief Look up an implementation of @p specific_service, which should be registered first.
 		 *
@@ -54,6 +54,7 @@ namespace ILLIXR {
 			: name{name_}
 			, pb{pb_}
 			, record_logger_{pb->lookup_impl<record_logger>()}
+			, record_flusher_{pb->has_impl<record_flusher>() ? pb->lookup_impl<record_flusher>() : nullptr}
 			, gen_guid_{pb->lookup_impl<gen_guid>()}
 			, id{gen_guid_->get()}
 		{ }
@@ -66,6 +67,8 @@ namespace ILLIXR {
 		std::string name;
 		const phonebook* pb;
 		const std::shared_ptr<record_logger> record_logger_;
+		// Null unless a record_flusher service is registered
+		const std::shared_ptr<record_flusher> record_flusher_;
 		const std::shared_ptr<gen_guid> gen_guid_;
 		const std::size_t id;
 	};
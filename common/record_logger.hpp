@@ -1,12 +1,25 @@
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <array>
+#include <optional>
 #include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <unordered_map>
 #include <sstream>
 #include <vector>
 #include <memory>
 #include "phonebook.hpp"
+#include "relative_clock.hpp"
 
 namespace ILLIXR {
 
@@ -106,7 +119,7 @@ namespace ILLIXR {
 	public:
 		record(const record_header& rh_, std::vector<std::any> values_)
 			: rh{rh_}
-			, values{values_}
+			, values(values_) // not braces: with std::any elements, GCC would pick the initializer_list constructor
 		{
 #ifndef NDEBUG
 			assert(rh);
@@ -176,6 +189,130 @@ namespace ILLIXR {
 #endif
     };
 
+	/**
+	 * @brief Whether @p T can be the type of a record column; each logger knows how to write these.
+	 */
+	template <typename T>
+	constexpr bool is_record_column_v =
+		   std::is_same_v<T, std::size_t>
+		|| std::is_same_v<T, bool>
+		|| std::is_same_v<T, double>
+		|| std::is_same_v<T, std::chrono::nanoseconds>
+		|| std::is_same_v<T, std::chrono::high_resolution_clock::time_point>
+		|| std::is_same_v<T, time_point>
+		|| std::is_same_v<T, std::string>;
+
+	template <typename... Cols>
+	class typed_record_coalescer;
+
+	/**
+	 * @brief A `record_header` whose column types are known at compile time.
+	 *
+	 * Use like:
+	 *
+	 * \code{.cpp}
+	 * const typed_record_header<std::size_t, std::string> my_header {"my_record", {"id", "name"}};
+	 * \endcode
+	 */
+	template <typename... Cols>
+	class typed_record_header : public record_header {
+		static_assert((is_record_column_v<Cols> && ...), "record columns must be of a type the loggers can write");
+
+	public:
+		/// Buffers records of this header
+		using coalescer = typed_record_coalescer<Cols...>;
+
+		typed_record_header(std::string name_, const std::array<std::string, sizeof...(Cols)>& column_names)
+			: record_header{std::move(name_), columns_of(column_names)}
+		{ }
+
+	private:
+		static std::vector<std::pair<std::string, const std::type_info&>> columns_of(const std::array<std::string, sizeof...(Cols)>& column_names) {
+			const std::array<const std::type_info*, sizeof...(Cols)> types {&typeid(Cols)...};
+			std::vector<std::pair<std::string, const std::type_info&>> columns;
+			for (std::size_t i = 0; i < sizeof...(Cols); ++i) {
+				columns.emplace_back(column_names[i], *types[i]);
+			}
+			return columns;
+		}
+	};
+
+	/**
+	 * @brief One record of a `typed_record_header`, holding its values unboxed.
+	 */
+	template <typename... Cols>
+	class typed_record {
+	public:
+		template <typename... Values>
+		typed_record(const typed_record_header<Cols...>& rh_, Values&&... values_)
+			: rh{rh_}
+			, values{std::forward<Values>(values_)...}
+		{ }
+
+		const typed_record_header<Cols...>& get_record_header() const {
+			return rh;
+		}
+
+		const std::tuple<Cols...>& get_values() const {
+			return values;
+		}
+
+	private:
+		const typed_record_header<Cols...>& rh;
+		std::tuple<Cols...> values;
+	};
+
+	template <typename... Cols, typename... Values>
+	typed_record(const typed_record_header<Cols...>&, Values&&...) -> typed_record<Cols...>;
+
+	/**
+	 * @brief Records of one header, column by column, as `typed_record`s are handed to loggers.
+	 *
+	 * Column `i` is an array of `rows` values of type `header.get_column_type(i)`, which is one for
+	 * which `is_record_column_v` holds.
+	 */
+	struct record_batch {
+		const record_header& header;
+		std::size_t rows;
+		const void* const* columns;
+
+		template <typename T>
+		const T* column(unsigned i) const {
+			assert(header.get_column_type(i) == typeid(T));
+			return static_cast<const T*>(columns[i]);
+		}
+
+		/**
+		 * @brief Copies row @p row into a `record`, for loggers which have no use for batches.
+		 */
+		record to_record(std::size_t row) const {
+			std::vector<std::any> values;
+			values.reserve(header.get_columns());
+			for (unsigned i = 0; i < header.get_columns(); ++i) {
+				const std::type_info& type = header.get_column_type(i);
+				if (false) {
+				} else if (type == typeid(std::size_t)) {
+					values.emplace_back(column<std::size_t>(i)[row]);
+				} else if (type == typeid(bool)) {
+					values.emplace_back(column<bool>(i)[row]);
+				} else if (type == typeid(double)) {
+					values.emplace_back(column<double>(i)[row]);
+				} else if (type == typeid(std::chrono::nanoseconds)) {
+					values.emplace_back(column<std::chrono::nanoseconds>(i)[row]);
+				} else if (type == typeid(std::chrono::high_resolution_clock::time_point)) {
+					values.emplace_back(column<std::chrono::high_resolution_clock::time_point>(i)[row]);
+				} else if (type == typeid(time_point)) {
+					values.emplace_back(column<time_point>(i)[row]);
+				} else if (type == typeid(std::string)) {
+					values.emplace_back(column<std::string>(i)[row]);
+				} else {
+					throw std::runtime_error{std::string{"type "} + type.name() + " not implemented"};
+				}
+			}
+			return record{header, std::move(values)};
+		}
+	};
+
 	/**
 	 * @brief The ILLIXR logging service for structured records.
 	 *
@@ -204,6 +341,51 @@ namespace ILLIXR {
 				log(r);
 			}
 		}
+
+		/**
+		 * @brief Writes records of `typed_record_header`s.
+		 *
+		 * Loggers which write columns by type should override this, as it saves boxing every value
+		 * into a `record`, which this does.
+		 */
+		virtual void log(const record_batch& batch) {
+			std::vector<record> rs;
+			rs.reserve(batch.rows);
+			for (std::size_t row = 0; row < batch.rows; ++row) {
+				rs.push_back(batch.to_record(row));
+			}
+			log(rs);
+		}
+
+		/**
+		 * @brief Writes one typed record.
+		 */
+		template <typename... Cols>
+		void log(const typed_record<Cols...>& r) {
+			const std::array<const void*, sizeof...(Cols)> columns = std::apply([](const Cols&... values) {
+				return std::array<const void*, sizeof...(Cols)>{static_cast<const void*>(&values)...};
+			}, r.get_values());
+			log(record_batch{r.get_record_header(), 1, columns.data()});
+		}
+
+		/**
+		 * @brief Whether records are written at all.
+		 *
+		 * When they are not, `typed_record_coalescer` drops records without storing them, and
+		 * callers can skip measuring what would go into them.
+		 */
+		virtual bool enabled() const {
+			return true;
+		}
+
+		/**
+		 * @brief Whether records of @p rh are written at all.
+		 *
+		 * For loggers which keep only some records; by default, the same as `enabled()`.
+		 */
+		virtual bool enabled([[maybe_unused]] const record_header& rh) const {
+			return enabled();
+		}
 	};
 
 	/**
@@ -326,4 +508,461 @@ namespace ILLIXR {
 			return bool(logger);
 		}
 	};
+
+	/**
+	 * @brief What a `log_ring` does with a record which does not fit.
+	 */
+	enum class log_overflow {
+		/// Drop the record, counting it in `dropped()`
+		drop,
+		/// Wait for `record_flusher` to make room, counting the wait in `blocked()`
+		block,
+	};
+
+	/**
+	 * @brief The part of a `typed_log_ring` which `record_flusher` sees.
+	 */
+	class log_ring {
+	public:
+		virtual ~log_ring() = default;
+
+		/**
+		 * @brief Hands every stored record to the logger, and makes room for more.
+		 *
+		 * Only for the consumer; calls must not be concurrent.
+		 *
+		 * @returns the number of records handed over.
+		 */
+		virtual std::size_t drain() = 0;
+
+		/// The records pushed so far
+		virtual std::size_t pushed() const = 0;
+
+		/// The records which did not fit, under `log_overflow::drop`
+		std::size_t dropped() const {
+			return _dropped.load(std::memory_order_relaxed);
+		}
+
+		/// The records which waited for room, under `log_overflow::block`
+		std::size_t blocked() const {
+			return _blocked.load(std::memory_order_relaxed);
+		}
+
+		/// For the producer
+		void count_dropped() {
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/// For the producer
+		void count_blocked() {
+			_blocked.fetch_add(1, std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<std::size_t> _dropped {0};
+		std::atomic<std::size_t> _blocked {0};
+	};
+
+	/**
+	 * @brief A fixed-capacity ring of records of one `typed_record_header`, with one producer and one consumer.
+	 *
+	 * The producer's calls to `push` must not be concurrent, though they may come from different
+	 * threads in turn (as the callbacks of a switchboard subscription on the executor do). Values are
+	 * stored column by column into slots allocated up front, so a push takes no lock and allocates
+	 * nothing (strings excepted, the first time a slot holds one longer than it held before).
+	 *
+	 * `drain` hands the stored rows to the logger as `record_batch`es which point into the ring,
+	 * without copying them.
+	 */
+	template <typename... Cols>
+	class typed_log_ring : public log_ring {
+	public:
+		/// @p capacity_ is rounded up to a power of two, of at least 2.
+		typed_log_ring(std::shared_ptr<record_logger> logger_, const typed_record_header<Cols...>& rh_, std::size_t capacity_)
+			: logger{std::move(logger_)}
+			, rh{rh_}
+			, capacity{round_up(capacity_)}
+			, columns{std::unique_ptr<Cols[]>{new Cols[capacity]}...}
+		{ }
+
+		typed_log_ring(const typed_log_ring&) = delete;
+		typed_log_ring& operator=(const typed_log_ring&) = delete;
+
+		/**
+		 * @brief Stores a record, if there is room.
+		 *
+		 * @returns the number of records stored, counting this one, or 0 if the ring was full.
+		 */
+		std::size_t push(const Cols&... values) {
+			const std::size_t h = head.load(std::memory_order_relaxed);
+			const std::size_t stored = h - tail.load(std::memory_order_acquire);
+			if (stored == capacity) {
+				return 0;
+			}
+			store(std::index_sequence_for<Cols...>{}, h & (capacity - 1), values...);
+			head.store(h + 1, std::memory_order_release);
+			return stored + 1;
+		}
+
+		virtual std::size_t drain() override {
+			const std::size_t h = head.load(std::memory_order_acquire);
+			std::size_t t = tail.load(std::memory_order_relaxed);
+			const std::size_t drained = h - t;
+			while (t != h) {
+				// Up to the end of the ring, then from its start
+				const std::size_t start = t & (capacity - 1);
+				const std::size_t rows = std::min(h - t, capacity - start);
+				const std::array<const void*, sizeof...(Cols)> columns_ = std::apply([start](const auto&... column) {
+					return std::array<const void*, sizeof...(Cols)>{static_cast<const void*>(column.get() + start)...};
+				}, columns);
+				logger->log(record_batch{rh, rows, columns_.data()});
+				t += rows;
+				tail.store(t, std::memory_order_release);
+			}
+			return drained;
+		}
+
+		virtual std::size_t pushed() const override {
+			return head.load(std::memory_order_acquire);
+		}
+
+		std::size_t get_capacity() const {
+			return capacity;
+		}
+
+		const typed_record_header<Cols...>& get_record_header() const {
+			return rh;
+		}
+
+	private:
+		const std::shared_ptr<record_logger> logger;
+		const typed_record_header<Cols...>& rh;
+		const std::size_t capacity;
+		// Not std::vector, which would pack bools.
+		const std::tuple<std::unique_ptr<Cols[]>...> columns;
+		// Counts of records pushed and drained; they only grow, and index the ring modulo capacity.
+		// Apart, so that the producer and the consumer do not share a cache line.
+		alignas(64) std::atomic<std::size_t> head {0};
+		alignas(64) std::atomic<std::size_t> tail {0};
+
+		static std::size_t round_up(std::size_t n) {
+			std::size_t rounded = 2;
+			while (rounded < n) {
+				rounded *= 2;
+			}
+			return rounded;
+		}
+
+		template <std::size_t... I>
+		void store(std::index_sequence<I...>, std::size_t slot, const Cols&... values) {
+			((std::get<I>(columns)[slot] = values), ...);
+		}
+	};
+
+	/*
+	 * This gets included, but it is functionally 'private'. Hence the double-underscores.
+	 */
+	const typed_record_header<
+		std::string,
+		std::size_t,
+		std::size_t,
+		std::size_t
+	> __log_ring_header {"log_ring", {
+		"record_name",
+		"rows",
+		"dropped",
+		"blocked",
+	}};
+
+	/**
+	 * @brief Writes the records of every `typed_record_coalescer` from one background thread.
+	 *
+	 * Each coalescer which is given a flusher stores its records into a `typed_log_ring` of its own,
+	 * which the flusher drains into the logger every `LOG_BUFFER_DELAY`, and as soon as any ring is
+	 * half full. Logging a record on a hot thread is then only a push into the ring; the logger's
+	 * own work (boxing, queueing, writing) happens on the flusher's thread.
+	 *
+	 * When a ring is full, its records are dropped or wait for room, as `overflow` says. The counts
+	 * are kept per ring, and logged as a `log_ring` record when its coalescer goes away.
+	 */
+	class record_flusher : public phonebook::service {
+	public:
+		/**
+		 * @p on_start runs on the flusher's thread before anything else (to name and place it).
+		 */
+		record_flusher(std::size_t ring_capacity_ = 1024, log_overflow overflow_ = log_overflow::drop, std::function<void()> on_start = {})
+			: ring_capacity{ring_capacity_}
+			, overflow{overflow_}
+			, thread{[this, on_start] {
+				if (on_start) {
+					on_start();
+				}
+				thread_main();
+			}}
+		{ }
+
+		record_flusher(const record_flusher&) = delete;
+		record_flusher& operator=(const record_flusher&) = delete;
+
+		~record_flusher() {
+			{
+				const std::lock_guard<std::mutex> lock {wake_lock};
+				stopping = true;
+			}
+			wake_cv.notify_one();
+			thread.join();
+			assert(rings.empty() && "every coalescer holds its flusher");
+		}
+
+		std::size_t get_ring_capacity() const {
+			return ring_capacity;
+		}
+
+		log_overflow get_overflow() const {
+			return overflow;
+		}
+
+		/**
+		 * @brief Starts draining @p ring, until `remove`.
+		 */
+		void add(log_ring& ring) {
+			const std::lock_guard<std::mutex> lock {rings_lock};
+			rings.push_back(&ring);
+		}
+
+		/**
+		 * @brief Drains @p ring a last time, and forgets it. Its producer must be done pushing.
+		 */
+		void remove(log_ring& ring) {
+			const std::lock_guard<std::mutex> lock {rings_lock};
+			ring.drain();
+			rings.erase(std::remove(rings.begin(), rings.end(), &ring), rings.end());
+		}
+
+		/**
+		 * @brief Drains every ring now, on the caller's thread.
+		 */
+		void flush() {
+			const std::lock_guard<std::mutex> lock {rings_lock};
+			drain_all();
+		}
+
+		/**
+		 * @brief Like `flush`, unless a drain is under way (or never ends, as after a crash).
+		 *
+		 * @returns whether the rings were drained.
+		 */
+		bool try_flush() {
+			const std::unique_lock<std::mutex> lock {rings_lock, std::try_to_lock};
+			if (lock) {
+				drain_all();
+			}
+			return lock.owns_lock();
+		}
+
+		/**
+		 * @brief Drains @p ring now, on the caller's thread.
+		 */
+		void drain(log_ring& ring) {
+			const std::lock_guard<std::mutex> lock {rings_lock};
+			ring.drain();
+		}
+
+		/**
+		 * @brief Has the flusher drain every ring without waiting for `LOG_BUFFER_DELAY`.
+		 *
+		 * Producers call this rarely (once their ring is half full, or when it is full), so it
+		 * takes a lock, which saves the flusher from missing the wakeup.
+		 */
+		void wake() {
+			{
+				const std::lock_guard<std::mutex> lock {wake_lock};
+				woken = true;
+			}
+			wake_cv.notify_one();
+		}
+
+		/**
+		 * @brief Counts a record dropped from @p ring.
+		 */
+		void count_dropped(log_ring& ring) {
+			ring.count_dropped();
+			total_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief The records dropped from every ring so far.
+		 */
+		std::size_t dropped() const {
+			return total_dropped.load(std::memory_order_relaxed);
+		}
+
+	private:
+		const std::size_t ring_capacity;
+		const log_overflow overflow;
+		std::vector<log_ring*> rings;
+		std::mutex rings_lock;
+		std::atomic<std::size_t> total_dropped {0};
+		std::mutex wake_lock;
+		std::condition_variable wake_cv;
+		bool woken {false};
+		bool stopping {false};
+		// This needs to be last, so it starts after the data it uses.
+		std::thread thread;
+
+		void thread_main() {
+			std::unique_lock<std::mutex> lock {wake_lock};
+			while (!stopping) {
+				wake_cv.wait_for(lock, LOG_BUFFER_DELAY, [this] { return woken || stopping; });
+				woken = false;
+				lock.unlock();
+				flush();
+				lock.lock();
+			}
+		}
+
+		/// Requires rings_lock
+		void drain_all() {
+			for (log_ring* ring : rings) {
+				ring->drain();
+			}
+		}
+	};
+
+	/**
+	 * @brief Like `record_coalescer`, for the records of one `typed_record_header`.
+	 *
+	 * Records are stored column by column into a `typed_log_ring`, so logging a record stores its
+	 * values and allocates nothing (strings included, as long as they fit in the strings they
+	 * overwrite). The ring is handed to the logger as `record_batch`es.
+	 *
+	 * With a `record_flusher`, the flusher drains the ring from its own thread, and a full ring
+	 * drops or blocks as the flusher says. Without one, this drains the ring itself once it is full,
+	 * or once the oldest record is older than `LOG_BUFFER_DELAY`, as `record_coalescer` does.
+	 *
+	 * If the logger is not `enabled()` for the header, this converts to false and `log` does nothing.
+	 *
+	 * Use like:
+	 *
+	 * \code{.cpp}
+	 * typed_record_coalescer<std::size_t, std::string> lc {logger, my_header, flusher};
+	 * if (lc) {
+	 *     lc.log(id, name);
+	 * }
+	 * \endcode
+	 */
+	template <typename... Cols>
+	class typed_record_coalescer {
+	public:
+		/// Rows buffered without a flusher
+		static constexpr std::size_t default_capacity = 1024;
+
+		typed_record_coalescer(std::shared_ptr<record_logger> logger_, const typed_record_header<Cols...>& rh_, std::shared_ptr<record_flusher> flusher_ = nullptr)
+			: logger{logger_ && logger_->enabled(rh_) ? logger_ : nullptr}
+			, flusher{logger ? flusher_ : nullptr}
+			, ring{logger ? std::make_unique<typed_log_ring<Cols...>>(logger, rh_, flusher ? flusher->get_ring_capacity() : default_capacity) : nullptr}
+			, last_log{coarse_now()}
+		{
+			if (flusher) {
+				flusher->add(*ring);
+			}
+		}
+
+		typed_record_coalescer(const typed_record_coalescer&) = delete;
+		typed_record_coalescer& operator=(const typed_record_coalescer&) = delete;
+
+		~typed_record_coalescer() {
+			if (flusher) {
+				flusher->remove(*ring);
+				logger->log(typed_record{__log_ring_header, ring->get_record_header().get_name(), ring->pushed(), ring->dropped(), ring->blocked()});
+			} else {
+				flush();
+			}
+		}
+
+		/**
+		 * @brief Appends a record to the buffer, which will eventually be written.
+		 */
+		void log(const Cols&... values) {
+			if (!logger) {
+				return;
+			}
+			const std::size_t stored = ring->push(values...);
+			if (stored == 0) {
+				overflowed(values...);
+			} else if (flusher) {
+				if (stored == ring->get_capacity() / 2) {
+					flusher->wake();
+				}
+			} else {
+				maybe_flush();
+			}
+		}
+
+		/**
+		 * @brief Use internal decision process, and possibly trigger flush.
+		 */
+		void maybe_flush() {
+			if (!flusher && coarse_now() > last_log + LOG_BUFFER_DELAY) {
+				flush();
+			}
+		}
+
+		/**
+		 * @brief Flush buffer of logs to the underlying logger.
+		 */
+		void flush() {
+			if (flusher) {
+				flusher->drain(*ring);
+			} else if (logger) {
+				ring->drain();
+				last_log = coarse_now();
+			}
+		}
+
+		operator bool() const {
+			return bool(logger);
+		}
+
+		/// Records which did not fit, under `log_overflow::drop`
+		std::size_t dropped() const {
+			return ring ? ring->dropped() : 0;
+		}
+
+		/// Records which waited for room, under `log_overflow::block`
+		std::size_t blocked() const {
+			return ring ? ring->blocked() : 0;
+		}
+
+	private:
+		const std::shared_ptr<record_logger> logger;
+		const std::shared_ptr<record_flusher> flusher;
+		const std::unique_ptr<typed_log_ring<Cols...>> ring;
+		std::chrono::nanoseconds last_log;
+
+		/// A clock which is cheap to read on every record (a few ns, unlike `high_resolution_clock`),
+		/// and precise to a few ms, which is plenty for `LOG_BUFFER_DELAY`
+		static std::chrono::nanoseconds coarse_now() {
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+			return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+		}
+
+		void overflowed(const Cols&... values) {
+			if (!flusher) {
+				flush();
+				ring->push(values...);
+				return;
+			}
+			if (flusher->get_overflow() == log_overflow::drop) {
+				flusher->count_dropped(*ring);
+				return;
+			}
+			ring->count_blocked();
+			do {
+				flusher->wake();
+				std::this_thread::sleep_for(std::chrono::microseconds{100});
+			} while (ring->push(values...) == 0);
+		}
+	};
 }
@@ -1,6 +1,15 @@
 #pragma once
+#include <atomic>
+#include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <ratio>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "phonebook.hpp"
 
 namespace ILLIXR {
@@ -72,6 +81,226 @@ inline bool operator!=(const time_point& lhs, const time_point& rhs) {
 	return lhs.time_since_epoch() != rhs.time_since_epoch(); 
 }
 
+/**
+ * @brief Where `RelativeClock` gets its time from, and how it sleeps.
+ *
+ * Times are durations since `start()`.
+ */
+class clock_backend {
+public:
+	virtual ~clock_backend() = default;
+
+	/// Called once, with the real time at which the clock starts
+	virtual void start(std::chrono::steady_clock::time_point start_) = 0;
+
+	/// Thread-safe
+	virtual _clock_duration now() const = 0;
+
+	/**
+	 * @brief Blocks until `now()` reaches @p t, or until `interrupt()`.
+	 *
+	 * Thread-safe
+	 */
+	virtual void sleep_until(_clock_duration t) const = 0;
+
+	/**
+	 * @brief Wakes every sleeping thread, and makes later sleeps return at once.
+	 */
+	virtual void interrupt() = 0;
+
+	/**
+	 * @brief Whether this backend wants `hold()` and `release()` (a virtual clock does).
+	 */
+	virtual bool tracks_work() const { return false; }
+
+	/**
+	 * @brief Announces @p count items of work (e.g. queued events), which must be done before time
+	 * may move on; `release()` them when done. Only matters if `tracks_work()`.
+	 *
+	 * Thread-safe
+	 */
+	virtual void hold([[maybe_unused]] std::size_t count = 1) const { }
+
+	/// See `hold()`
+	virtual void release([[maybe_unused]] std::size_t count = 1) const { }
+};
+
+/**
+ * @brief Follows `std::chrono::steady_clock`, optionally sped up.
+ *
+ * With a @p speed of 2, a second of real time is two seconds of clock time, so paced playback (such
+ * as `offline_imu_cam`) runs twice as fast.
+ */
+class steady_clock_backend : public clock_backend {
+public:
+	explicit steady_clock_backend(double speed = 1)
+		: _m_speed{speed}
+	{
+		if (!(speed > 0)) {
+			throw std::invalid_argument{"steady_clock_backend: speed must be positive"};
+		}
+	}
+
+	void start(std::chrono::steady_clock::time_point start_) override {
+		_m_start = start_;
+	}
+
+	_clock_duration now() const override {
+		const auto elapsed = std::chrono::steady_clock::now() - _m_start;
+		if (_m_speed == 1) {
+			return elapsed;
+		}
+		return std::chrono::duration_cast<_clock_duration>(std::chrono::duration<double, _clock_period>{elapsed} * _m_speed);
+	}
+
+	void sleep_until(_clock_duration t) const override {
+		const auto wake_up = _m_start + (_m_speed == 1 ? t : std::chrono::duration_cast<_clock_duration>(std::chrono::duration<double, _clock_period>{t} / _m_speed));
+		std::unique_lock<std::mutex> lock {_m_lock};
+		_m_interrupted_cv.wait_until(lock, wake_up, [this] { return _m_interrupted; });
+	}
+
+	void interrupt() override {
+		{
+			const std::lock_guard<std::mutex> lock {_m_lock};
+			_m_interrupted = true;
+		}
+		_m_interrupted_cv.notify_all();
+	}
+
+private:
+	const double _m_speed;
+	std::chrono::steady_clock::time_point _m_start;
+	mutable std::mutex _m_lock;
+	mutable std::condition_variable _m_interrupted_cv;
+	bool _m_interrupted = false;
+};
+
+/**
+ * @brief A discrete-event clock: time stands still while anything is busy, and jumps to the earliest
+ * wake-up time once everything is idle.
+ *
+ * Everything is idle when no work is held (see `hold()`; switchboard holds each queued event until
+ * its callback returns), and no participating thread is running. A thread participates from its
+ * first `sleep_until()` until it exits, and counts as running whenever it is not in
+ * `sleep_until()`.
+ *
+ * So a pipeline runs as fast as the CPU allows, but sees the same sequence of times as it would
+ * in real time. This only holds if participants block on nothing but this clock and switchboard:
+ * a participant waiting for anything else (a GPU, a vsync, another thread) stops the clock for
+ * good; a thread polling in a loop without sleeping on the clock does not hold time back.
+ */
+class virtual_clock_backend : public clock_backend {
+public:
+	void start(std::chrono::steady_clock::time_point) override { }
+
+	_clock_duration now() const override {
+		return _clock_duration{_m_state->now.load()};
+	}
+
+	void sleep_until(_clock_duration t) const override {
+		std::unique_lock<std::mutex> lock {_m_state->lock};
+		if (_m_state->interrupted) {
+			return;
+		}
+		participate();
+		if (t.count() <= _m_state->now.load()) {
+			return;
+		}
+		_m_state->running--;
+		auto deadline = _m_state->deadlines.insert(t.count());
+		_m_state->advance();
+		_m_state->cv.wait(lock, [&] { return _m_state->now.load() >= t.count() || _m_state->interrupted; });
+		_m_state->deadlines.erase(deadline);
+		_m_state->running++;
+	}
+
+	void interrupt() override {
+		{
+			const std::lock_guard<std::mutex> lock {_m_state->lock};
+			_m_state->interrupted = true;
+		}
+		_m_state->cv.notify_all();
+	}
+
+	bool tracks_work() const override { return true; }
+
+	void hold(std::size_t count = 1) const override {
+		const std::lock_guard<std::mutex> lock {_m_state->lock};
+		_m_state->held += count;
+	}
+
+	void release(std::size_t count = 1) const override {
+		const std::lock_guard<std::mutex> lock {_m_state->lock};
+		assert(_m_state->held >= count);
+		_m_state->held -= count;
+		_m_state->advance();
+	}
+
+private:
+	struct state {
+		std::mutex lock;
+		std::condition_variable cv;
+		// Nanoseconds; written under the lock, read without
+		std::atomic<_clock_rep> now {0};
+		std::multiset<_clock_rep> deadlines;
+		std::size_t running = 0;
+		std::size_t held = 0;
+		bool interrupted = false;
+
+		/// Jumps to the earliest deadline, if everything is idle. Call with the lock held.
+		void advance() {
+			if (running == 0 && held == 0 && !deadlines.empty() && *deadlines.begin() > now.load()) {
+				now.store(*deadlines.begin());
+				cv.notify_all();
+			}
+		}
+	};
+
+	/// The clocks the calling thread participates in; it leaves them when it exits.
+	struct participation {
+		std::vector<std::shared_ptr<state>> states;
+
+		~participation() {
+			for (const std::shared_ptr<state>& s : states) {
+				const std::lock_guard<std::mutex> lock {s->lock};
+				s->running--;
+				s->advance();
+			}
+		}
+	};
+
+	/// Makes the calling thread a participant, if it is not one yet. Call with the lock held.
+	void participate() const {
+		static thread_local participation this_thread;
+		for (const std::shared_ptr<state>& s : this_thread.states) {
+			if (s == _m_state) {
+				return;
+			}
+		}
+		this_thread.states.push_back(_m_state);
+		_m_state->running++;
+	}
+
+	// Shared with the participating threads, which may outlive this
+	const std::shared_ptr<state> _m_state = std::make_shared<state>();
+};
+
+/**
+ * @brief Makes a clock_backend from @p spec: `real` (or empty), `scaled:<speed>`, or `virtual`.
+ *
+ * @throws if @p spec is malformed.
+ */
+inline std::shared_ptr<clock_backend> make_clock_backend(const std::string& spec) {
+	if (spec.empty() || spec == "real") {
+		return std::make_shared<steady_clock_backend>();
+	} else if (spec.rfind("scaled:", 0) == 0) {
+		return std::make_shared<steady_clock_backend>(std::stod(spec.substr(7)));
+	} else if (spec == "virtual") {
+		return std::make_shared<virtual_clock_backend>();
+	}
+	throw std::runtime_error{"unknown clock '" + spec + "'; expected real, scaled:<speed>, or virtual"};
+}
+
 /**
  * @brief Relative clock for all of ILLIXR
  *
@@ -83,34 +312,81 @@ inline bool operator!=(const time_point& lhs, const time_point& rhs) {
  * because it needs to have data (namely _m_start) shared across link-time boundaries. There's no
  * clean way to do this with static variables, so instead I use instance variables and Phonebook.
  *
+ * The time comes from a `clock_backend`: real time by default, but it can be sped up, or be
+ * virtual (see `make_clock_backend`). Plugins which pace themselves should sleep with
+ * `sleep_until()` rather than `std::this_thread`, so that they follow it.
+ *
  * [1]: https://en.cppreference.com/w/cpp/named_req/Clock
  */
 class RelativeClock : public phonebook::service {
 public:
+	explicit RelativeClock(std::shared_ptr<clock_backend> backend = std::make_shared<steady_clock_backend>())
+		: _m_backend{std::move(backend)}
+	{ }
 
 	using rep = _clock_rep;
 	using period = _clock_period;
 	using duration = _clock_duration;
-	using time_point = time_point;
+	using time_point = ILLIXR::time_point;
 	static constexpr bool is_steady = true;
 	static_assert(std::chrono::steady_clock::is_steady);
 
 	time_point now() const {
 		assert(_m_start > std::chrono::steady_clock::time_point{} && "Can't call now() before this clock has been start()ed.");
-		return time_point{std::chrono::steady_clock::now() - _m_start};
+		return time_point{_m_backend->now()};
+	}
+
+	/**
+	 * @brief Sleeps until @p t on this clock, or until `interrupt()`.
+	 */
+	void sleep_until(time_point t) const {
+		assert(_m_start > std::chrono::steady_clock::time_point{} && "Can't sleep on this clock before it has been start()ed.");
+		_m_backend->sleep_until(t.time_since_epoch());
+	}
+
+	void sleep_for(duration d) const {
+		sleep_until(now() + d);
+	}
+
+	/**
+	 * @brief Ends every `sleep_until()`, now and later; for shutting down.
+	 */
+	void interrupt() {
+		_m_backend->interrupt();
+	}
+
+	/**
+	 * @brief The backend, if it wants to be told about pending work (see `clock_backend::hold()`),
+	 * else null.
+	 */
+	const clock_backend* work_tracker() const {
+		return _m_backend->tracks_work() ? _m_backend.get() : nullptr;
 	}
-	int64_t absolute_ns(time_point relative) {
+
+	int64_t absolute_ns(time_point relative) const {
 		return std::chrono::nanoseconds{_m_start.time_since_epoch()}.count() + std::chrono::nanoseconds{relative.time_since_epoch()}.count();
 	}
 
+	/**
+	 * @brief The inverse of `absolute_ns`.
+	 *
+	 * steady_clock is system-wide, so this converts times from another process's clock into this one's
+	 * (if both use real time).
+	 */
+	time_point from_absolute_ns(int64_t absolute) const {
+		return time_point{std::chrono::nanoseconds{absolute} - std::chrono::nanoseconds{_m_start.time_since_epoch()}};
+	}
+
 	/**
 	 * @brief Starts the clock. All times are relative to this point.
 	 */
 	void start() {
 		_m_start = std::chrono::steady_clock::now();
+		_m_backend->start(_m_start);
 	}
 
 private:
+	const std::shared_ptr<clock_backend> _m_backend;
 	std::chrono::steady_clock::time_point _m_start;
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <GL/glx.h>
@@ -21,6 +22,12 @@ namespace ILLIXR {
 		 */
 		virtual void wait() = 0;
 
+		/**
+		 * Returns once @p run_duration has passed on the runtime's `RelativeClock` (which need not
+		 * be real time), or once `stop()` is called.
+		 */
+		virtual void wait_for(std::chrono::nanoseconds run_duration) = 0;
+
 		/**
 		 * Requests that the runtime is completely stopped.
 		 * Clients must call this before deleting the runtime.
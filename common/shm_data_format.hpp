@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cstring>
+
+#include "data_format.hpp"
+#include "shm_transport.hpp"
+#include "topic_log.hpp"
+
+namespace ILLIXR {
+
+	/**
+	 * @brief Helpers for laying out `cv::Mat`s in a `shm_ring` slot.
+	 *
+	 * A Mat is written as a descriptor followed by its rows, packed and 64-byte aligned. Reading
+	 * wraps the slot's bytes in a Mat header, without copying them; the Mat must only be read.
+	 */
+	namespace shm_mat {
+		struct descriptor {
+			std::int32_t rows;
+			std::int32_t cols;
+			std::int32_t type;
+			std::int32_t present;
+		};
+
+		constexpr std::size_t alignment = 64;
+
+		inline std::size_t aligned(std::size_t size) {
+			return (size + alignment - 1) / alignment * alignment;
+		}
+
+		inline std::size_t size(const std::optional<cv::Mat>& mat) {
+			return aligned(sizeof(descriptor)) + (mat ? aligned(mat->total() * mat->elemSize()) : 0);
+		}
+
+		/// Returns the bytes written.
+		inline std::size_t write(const std::optional<cv::Mat>& mat, std::byte* dst) {
+			descriptor desc {0, 0, 0, 0};
+			if (mat) {
+				desc = descriptor{mat->rows, mat->cols, mat->type(), 1};
+			}
+			std::memcpy(dst, &desc, sizeof(desc));
+			if (mat) {
+				std::byte* data = dst + aligned(sizeof(descriptor));
+				const std::size_t row_size = static_cast<std::size_t>(mat->cols) * mat->elemSize();
+				for (int row = 0; row < mat->rows; ++row) {
+					std::memcpy(data + static_cast<std::size_t>(row) * row_size, mat->ptr(row), row_size);
+				}
+			}
+			return size(mat);
+		}
+
+		/// Advances @p src past the Mat.
+		inline std::optional<cv::Mat> read(const std::byte*& src) {
+			descriptor desc;
+			std::memcpy(&desc, src, sizeof(desc));
+			src += aligned(sizeof(descriptor));
+			if (!desc.present) {
+				return std::nullopt;
+			}
+			// cv::Mat has no read-only header; the mapping is read-only, so writes would fault.
+			cv::Mat mat {desc.rows, desc.cols, desc.type, const_cast<std::byte*>(src)};
+			src += aligned(mat.total() * mat.elemSize());
+			return mat;
+		}
+	}
+
+	/**
+	 * @brief Camera images are mapped in place; the IMU sample is copied.
+	 */
+	template <>
+	struct shm_codec<imu_cam_type> {
+		struct fixed {
+			std::int64_t time;
+			float angular_v[3];
+			float linear_a[3];
+		};
+
+		static std::size_t size(const imu_cam_type& this_event) {
+			return shm_mat::aligned(sizeof(fixed)) + shm_mat::size(this_event.img0) + shm_mat::size(this_event.img1);
+		}
+
+		static void write(const imu_cam_type& this_event, std::byte* dst, const RelativeClock& clock) {
+			fixed head;
+			head.time = clock.absolute_ns(this_event.time);
+			Eigen::Map<Eigen::Vector3f>{head.angular_v} = this_event.angular_v;
+			Eigen::Map<Eigen::Vector3f>{head.linear_a} = this_event.linear_a;
+			std::memcpy(dst, &head, sizeof(head));
+			dst += shm_mat::aligned(sizeof(fixed));
+			dst += shm_mat::write(this_event.img0, dst);
+			shm_mat::write(this_event.img1, dst);
+		}
+
+		static switchboard::ptr<imu_cam_type> read(const std::byte* src, std::size_t, const RelativeClock& clock, std::shared_ptr<const void>&& pin) {
+			fixed head;
+			std::memcpy(&head, src, sizeof(head));
+			src += shm_mat::aligned(sizeof(fixed));
+			std::optional<cv::Mat> img0 = shm_mat::read(src);
+			std::optional<cv::Mat> img1 = shm_mat::read(src);
+			return switchboard::make_ptr<shm_pinned<imu_cam_type>>(
+				std::move(pin),
+				clock.from_absolute_ns(head.time),
+				Eigen::Vector3f{Eigen::Map<const Eigen::Vector3f>{head.angular_v}},
+				Eigen::Vector3f{Eigen::Map<const Eigen::Vector3f>{head.linear_a}},
+				std::move(img0),
+				std::move(img1)
+			);
+		}
+	};
+
+	template <>
+	struct shm_codec<pose_type> {
+		struct fixed {
+			std::int64_t sensor_time;
+			float position[3];
+			float orientation[4]; // w, x, y, z
+		};
+
+		static std::size_t size(const pose_type&) {
+			return sizeof(fixed);
+		}
+
+		static void write(const pose_type& this_event, std::byte* dst, const RelativeClock& clock) {
+			fixed pose;
+			pose.sensor_time = clock.absolute_ns(this_event.sensor_time);
+			Eigen::Map<Eigen::Vector3f>{pose.position} = this_event.position;
+			pose.orientation[0] = this_event.orientation.w();
+			pose.orientation[1] = this_event.orientation.x();
+			pose.orientation[2] = this_event.orientation.y();
+			pose.orientation[3] = this_event.orientation.z();
+			std::memcpy(dst, &pose, sizeof(pose));
+		}
+
+		static switchboard::ptr<pose_type> read(const std::byte* src, std::size_t, const RelativeClock& clock, std::shared_ptr<const void>&&) {
+			fixed pose;
+			std::memcpy(&pose, src, sizeof(pose));
+			return switchboard::make_ptr<pose_type>(
+				clock.from_absolute_ns(pose.sensor_time),
+				Eigen::Vector3f{Eigen::Map<const Eigen::Vector3f>{pose.position}},
+				Eigen::Quaternionf{pose.orientation[0], pose.orientation[1], pose.orientation[2], pose.orientation[3]}
+			);
+		}
+	};
+
+	template <>
+	struct shm_codec<imu_integrator_input> {
+		struct fixed {
+			std::int64_t last_cam_integration_time;
+			std::int64_t t_offset;
+			double gyro_noise;
+			double acc_noise;
+			double gyro_walk;
+			double acc_walk;
+			double n_gravity[3];
+			double imu_integration_sigma;
+			double nominal_rate;
+			double biasAcc[3];
+			double biasGyro[3];
+			double position[3];
+			double velocity[3];
+			double quat[4]; // w, x, y, z
+		};
+
+		static std::size_t size(const imu_integrator_input&) {
+			return sizeof(fixed);
+		}
+
+		static void write(const imu_integrator_input& this_event, std::byte* dst, const RelativeClock& clock) {
+			fixed input;
+			input.last_cam_integration_time = clock.absolute_ns(this_event.last_cam_integration_time);
+			input.t_offset = this_event.t_offset.count();
+			input.gyro_noise = this_event.params.gyro_noise;
+			input.acc_noise = this_event.params.acc_noise;
+			input.gyro_walk = this_event.params.gyro_walk;
+			input.acc_walk = this_event.params.acc_walk;
+			Eigen::Map<Eigen::Vector3d>{input.n_gravity} = this_event.params.n_gravity;
+			input.imu_integration_sigma = this_event.params.imu_integration_sigma;
+			input.nominal_rate = this_event.params.nominal_rate;
+			Eigen::Map<Eigen::Vector3d>{input.biasAcc} = this_event.biasAcc;
+			Eigen::Map<Eigen::Vector3d>{input.biasGyro} = this_event.biasGyro;
+			Eigen::Map<Eigen::Vector3d>{input.position} = this_event.position;
+			Eigen::Map<Eigen::Vector3d>{input.velocity} = this_event.velocity;
+			input.quat[0] = this_event.quat.w();
+			input.quat[1] = this_event.quat.x();
+			input.quat[2] = this_event.quat.y();
+			input.quat[3] = this_event.quat.z();
+			std::memcpy(dst, &input, sizeof(input));
+		}
+
+		static switchboard::ptr<imu_integrator_input> read(const std::byte* src, std::size_t, const RelativeClock& clock, std::shared_ptr<const void>&&) {
+			fixed input;
+			std::memcpy(&input, src, sizeof(input));
+			imu_params params {
+				input.gyro_noise,
+				input.acc_noise,
+				input.gyro_walk,
+				input.acc_walk,
+				Eigen::Vector3d{Eigen::Map<const Eigen::Vector3d>{input.n_gravity}},
+				input.imu_integration_sigma,
+				input.nominal_rate,
+			};
+			return switchboard::make_ptr<imu_integrator_input>(
+				clock.from_absolute_ns(input.last_cam_integration_time),
+				duration{input.t_offset},
+				params,
+				Eigen::Vector3d{Eigen::Map<const Eigen::Vector3d>{input.biasAcc}},
+				Eigen::Vector3d{Eigen::Map<const Eigen::Vector3d>{input.biasGyro}},
+				Eigen::Vector3d{Eigen::Map<const Eigen::Vector3d>{input.position}},
+				Eigen::Vector3d{Eigen::Map<const Eigen::Vector3d>{input.velocity}},
+				Eigen::Quaterniond{input.quat[0], input.quat[1], input.quat[2], input.quat[3]}
+			);
+		}
+	};
+
+	/**
+	 * @brief Eyebuffer metadata. The texture handles are only meaningful in the process which rendered them.
+	 */
+	template <>
+	struct shm_codec<rendered_frame> {
+		struct fixed {
+			GLuint texture_handles[2];
+			GLuint swap_indices[2];
+			shm_codec<pose_type>::fixed pose;
+			std::int64_t predict_computed_time;
+			std::int64_t predict_target_time;
+			std::int64_t sample_time;
+			std::int64_t render_time;
+		};
+
+		static std::size_t size(const rendered_frame&) {
+			return sizeof(fixed);
+		}
+
+		static void write(const rendered_frame& this_event, std::byte* dst, const RelativeClock& clock) {
+			fixed frame;
+			std::copy(this_event.texture_handles.begin(), this_event.texture_handles.end(), frame.texture_handles);
+			std::copy(this_event.swap_indices.begin(), this_event.swap_indices.end(), frame.swap_indices);
+			shm_codec<pose_type>::write(this_event.render_pose.pose, reinterpret_cast<std::byte*>(&frame.pose), clock);
+			frame.predict_computed_time = clock.absolute_ns(this_event.render_pose.predict_computed_time);
+			frame.predict_target_time = clock.absolute_ns(this_event.render_pose.predict_target_time);
+			frame.sample_time = clock.absolute_ns(this_event.sample_time);
+			frame.render_time = clock.absolute_ns(this_event.render_time);
+			std::memcpy(dst, &frame, sizeof(frame));
+		}
+
+		static switchboard::ptr<rendered_frame> read(const std::byte* src, std::size_t, const RelativeClock& clock, std::shared_ptr<const void>&&) {
+			fixed frame;
+			std::memcpy(&frame, src, sizeof(frame));
+			fast_pose_type render_pose {
+				*shm_codec<pose_type>::read(reinterpret_cast<const std::byte*>(&frame.pose), sizeof(frame.pose), clock, nullptr),
+				clock.from_absolute_ns(frame.predict_computed_time),
+				clock.from_absolute_ns(frame.predict_target_time),
+			};
+			return switchboard::make_ptr<rendered_frame>(
+				std::array<GLuint, 2>{frame.texture_handles[0], frame.texture_handles[1]},
+				std::array<GLuint, 2>{frame.swap_indices[0], frame.swap_indices[1]},
+				render_pose,
+				clock.from_absolute_ns(frame.sample_time),
+				clock.from_absolute_ns(frame.render_time)
+			);
+		}
+	};
+
+	/**
+	 * @brief The data_format.hpp types which `shm_topic_types` can export and import.
+	 */
+	inline shm_topic_types data_format_shm_types() {
+		shm_topic_types types;
+		types.add<imu_cam_type>();
+		types.add<pose_type>();
+		types.add<imu_integrator_input>();
+		types.add<rendered_frame>();
+		return types;
+	}
+
+	/**
+	 * @brief The data_format.hpp types which `topic_log_types` can record and replay.
+	 */
+	inline topic_log_types data_format_log_types() {
+		topic_log_types types;
+		types.add<imu_cam_type>();
+		types.add<pose_type>();
+		types.add<imu_integrator_input>();
+		types.add<rendered_frame>();
+		return types;
+	}
+
+}
@@ -0,0 +1,620 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "managed_thread.hpp"
+#include "relative_clock.hpp"
+#include "switchboard.hpp"
+
+namespace ILLIXR {
+
+/**
+ * @brief A single-writer, multi-reader ring of events in POSIX shared memory, for sharing a
+ * switchboard topic between processes on one host.
+ *
+ * The segment holds a fixed number of equally-sized slots. The writer copies each event into a free
+ * slot once; readers in any process map the same segment and use the bytes in place. A reader
+ * *pins* the slot while it holds the event, and the writer never reuses a pinned slot, so the
+ * bytes cannot change under a reader. If every slot is pinned, or an event does not fit, the
+ * writer drops the event. Readers which fall more than a ring behind skip ahead and count what
+ * they lost.
+ *
+ * Readers sleep on a futex in the segment, so an idle reader costs nothing and wakes as soon as
+ * the writer publishes.
+ *
+ * Payloads are mapped read-only in readers. A reader which crashes while holding a pin leaks that
+ * slot until the writer restarts; size `slots` for the events every reader holds at once (queued,
+ * latest, history) plus some slack.
+ */
+class shm_ring : public std::enable_shared_from_this<shm_ring> {
+private:
+	static constexpr std::uint64_t _s_magic = 0x494c4c4958525348; // "ILLIXRSH"
+	static constexpr std::uint32_t _s_writing = std::uint32_t{1} << 31;
+	static constexpr std::size_t _s_type_name_length = 256;
+	static constexpr std::size_t _s_alignment = 64;
+
+	static_assert(std::atomic<std::uint32_t>::is_always_lock_free && sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+				  "futexes need a plain 32-bit word");
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "atomics in shared memory must be address-free");
+
+	struct header {
+		std::atomic<std::uint64_t> magic;
+		std::uint64_t slots;
+		std::uint64_t slot_size;
+		std::uint64_t control_size;
+		char type_name[_s_type_name_length];
+		// Number of events published so far; event n is in slot index[n % slots] if it is still there.
+		alignas(_s_alignment) std::atomic<std::uint64_t> published;
+		// Bumped on every publish (and stop), for readers to sleep on
+		std::atomic<std::uint32_t> notify;
+		std::atomic<std::uint32_t> waiters;
+	};
+
+	struct slot_header {
+		// Reader pins, or _s_writing while the writer fills the slot
+		std::atomic<std::uint32_t> pins;
+		// 1 + the sequence number of the event in the slot; 0 while empty or being written
+		std::atomic<std::uint64_t> seq;
+		std::uint64_t size;
+	};
+
+	static std::size_t round_up(std::size_t value, std::size_t multiple) {
+		return (value + multiple - 1) / multiple * multiple;
+	}
+
+	static std::size_t index_offset() {
+		return round_up(sizeof(header), _s_alignment);
+	}
+
+	static std::size_t slot_headers_offset(std::size_t slots) {
+		return round_up(index_offset() + slots * sizeof(std::atomic<std::uint32_t>), _s_alignment);
+	}
+
+	static std::size_t control_size_of(std::size_t slots) {
+		auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		return round_up(slot_headers_offset(slots) + slots * sizeof(slot_header), page);
+	}
+
+	static std::string shm_name(const std::string& topic_name) {
+		std::string name = "/illixr_" + topic_name;
+		for (std::size_t i = 1; i < name.size(); ++i) {
+			if (name[i] == '/') {
+				name[i] = '_';
+			}
+		}
+		return name;
+	}
+
+	static std::runtime_error system_error(const std::string& what, const std::string& name) {
+		return std::runtime_error{what + " " + name + ": " + strerror(errno)};
+	}
+
+	static long futex(std::atomic<std::uint32_t>* word, int op, std::uint32_t value) {
+		// Not FUTEX_PRIVATE: the waiters are in other processes.
+		return syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), op, value, nullptr, nullptr, 0);
+	}
+
+	const std::string _m_name;
+	const bool _m_owner;
+	header* _m_header {nullptr};
+	std::size_t _m_control_size {0};
+	std::byte* _m_payloads {nullptr};
+	std::size_t _m_payloads_size {0};
+	std::size_t _m_slot_stride {0};
+
+	// Writer-only
+	std::size_t _m_next_slot {0};
+	std::atomic<std::uint64_t> _m_dropped {0};
+
+	std::atomic<std::uint32_t>* index() const {
+		return reinterpret_cast<std::atomic<std::uint32_t>*>(reinterpret_cast<std::byte*>(_m_header) + index_offset());
+	}
+
+	slot_header& slot(std::size_t i) const {
+		return reinterpret_cast<slot_header*>(reinterpret_cast<std::byte*>(_m_header) + slot_headers_offset(_m_header->slots))[i];
+	}
+
+	std::byte* payload(std::size_t i) const {
+		return _m_payloads + i * _m_slot_stride;
+	}
+
+	struct private_tag { };
+
+public:
+	/// Use `create` or `open`.
+	shm_ring(private_tag, std::string name, bool owner)
+		: _m_name{std::move(name)}
+		, _m_owner{owner}
+	{ }
+
+	shm_ring(const shm_ring&) = delete;
+	shm_ring& operator=(const shm_ring&) = delete;
+
+	~shm_ring() {
+		if (_m_payloads) {
+			munmap(_m_payloads, _m_payloads_size);
+		}
+		if (_m_header) {
+			munmap(_m_header, _m_control_size);
+		}
+		if (_m_owner) {
+			shm_unlink(_m_name.c_str());
+		}
+	}
+
+	/**
+	 * @brief Creates the ring for @p topic_name, replacing one left behind by a writer which crashed.
+	 *
+	 * @p slot_size is the largest event (in bytes) which can be published.
+	 */
+	static std::shared_ptr<shm_ring> create(const std::string& topic_name, const std::type_info& type, std::size_t slots, std::size_t slot_size) {
+		assert(slots > 0 && slots < _s_writing);
+		auto ring = std::make_shared<shm_ring>(private_tag{}, shm_name(topic_name), true);
+
+		int fd = shm_open(ring->_m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd == -1 && errno == EEXIST) {
+			shm_unlink(ring->_m_name.c_str());
+			fd = shm_open(ring->_m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		}
+		if (fd == -1) {
+			throw system_error("shm_open", ring->_m_name);
+		}
+
+		ring->_m_control_size = control_size_of(slots);
+		ring->_m_slot_stride = round_up(slot_size, _s_alignment);
+		ring->_m_payloads_size = slots * ring->_m_slot_stride;
+		if (ftruncate(fd, static_cast<off_t>(ring->_m_control_size + ring->_m_payloads_size)) == -1) {
+			close(fd);
+			throw system_error("ftruncate", ring->_m_name);
+		}
+		void* control = mmap(nullptr, ring->_m_control_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		void* payloads = mmap(nullptr, ring->_m_payloads_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(ring->_m_control_size));
+		close(fd);
+		// Whatever did map is unmapped by the destructor.
+		ring->_m_header = control == MAP_FAILED ? nullptr : static_cast<header*>(control);
+		ring->_m_payloads = payloads == MAP_FAILED ? nullptr : static_cast<std::byte*>(payloads);
+		if (!ring->_m_header || !ring->_m_payloads) {
+			throw system_error("mmap", ring->_m_name);
+		}
+
+		// The segment starts zeroed, which is a valid empty ring; readers wait for the magic.
+		header& h = *new (ring->_m_header) header{};
+		h.slots = slots;
+		h.slot_size = ring->_m_slot_stride;
+		h.control_size = ring->_m_control_size;
+		std::strncpy(h.type_name, type.name(), _s_type_name_length - 1);
+		for (std::size_t i = 0; i < slots; ++i) {
+			new (&ring->index()[i]) std::atomic<std::uint32_t>{0};
+			new (&ring->slot(i)) slot_header{};
+		}
+		h.magic.store(_s_magic, std::memory_order_release);
+		return ring;
+	}
+
+	/**
+	 * @brief Attaches to the ring for @p topic_name, or returns null if its writer has not created it yet.
+	 *
+	 * Throws if the ring holds a different type.
+	 */
+	static std::shared_ptr<shm_ring> open(const std::string& topic_name, const std::type_info& type) {
+		auto ring = std::make_shared<shm_ring>(private_tag{}, shm_name(topic_name), false);
+
+		int fd = shm_open(ring->_m_name.c_str(), O_RDWR, 0);
+		if (fd == -1) {
+			if (errno == ENOENT) {
+				errno = 0;
+				return nullptr;
+			}
+			throw system_error("shm_open", ring->_m_name);
+		}
+		struct stat st;
+		if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(header)) {
+			// Created, but not sized yet
+			close(fd);
+			return nullptr;
+		}
+
+		void* control = mmap(nullptr, sizeof(header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (control == MAP_FAILED) {
+			close(fd);
+			throw system_error("mmap", ring->_m_name);
+		}
+		auto* h = static_cast<header*>(control);
+		if (h->magic.load(std::memory_order_acquire) != _s_magic) {
+			munmap(control, sizeof(header));
+			close(fd);
+			return nullptr;
+		}
+		if (std::strncmp(h->type_name, type.name(), _s_type_name_length) != 0) {
+			std::string held {h->type_name};
+			munmap(control, sizeof(header));
+			close(fd);
+			throw std::runtime_error{"shm topic " + ring->_m_name + " holds type " + held + ", but caller used type " + type.name()};
+		}
+		ring->_m_control_size = h->control_size;
+		ring->_m_slot_stride = h->slot_size;
+		ring->_m_payloads_size = h->slots * h->slot_size;
+		munmap(control, sizeof(header));
+
+		control = mmap(nullptr, ring->_m_control_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		// Readers must not scribble on events other readers are using.
+		void* payloads = mmap(nullptr, ring->_m_payloads_size, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(ring->_m_control_size));
+		close(fd);
+		// Whatever did map is unmapped by the destructor.
+		ring->_m_header = control == MAP_FAILED ? nullptr : static_cast<header*>(control);
+		ring->_m_payloads = payloads == MAP_FAILED ? nullptr : static_cast<std::byte*>(payloads);
+		if (!ring->_m_header || !ring->_m_payloads) {
+			throw system_error("mmap", ring->_m_name);
+		}
+		return ring;
+	}
+
+	/// The largest event, in bytes
+	std::size_t slot_size() const {
+		return _m_slot_stride;
+	}
+
+	/// Events the writer could not place
+	std::uint64_t dropped() const {
+		return _m_dropped.load();
+	}
+
+	/**
+	 * @brief Copies one event of @p size bytes in, by calling @p write with the destination.
+	 *
+	 * Writer only. Returns false, and counts a drop, if the event does not fit or every slot is pinned.
+	 */
+	template <typename Write>
+	bool publish(std::size_t size, Write&& write) {
+		assert(_m_owner);
+		if (size > _m_slot_stride) {
+			_m_dropped++;
+			return false;
+		}
+		const std::size_t slots = _m_header->slots;
+		for (std::size_t probe = 0; probe < slots; ++probe) {
+			std::size_t i = (_m_next_slot + probe) % slots;
+			slot_header& s = slot(i);
+			std::uint32_t unpinned = 0;
+			// Acquire: the last reader is done with the old bytes.
+			if (!s.pins.compare_exchange_strong(unpinned, _s_writing, std::memory_order_acquire)) {
+				continue;
+			}
+			std::uint64_t seq = _m_header->published.load(std::memory_order_relaxed);
+			s.seq.store(0, std::memory_order_relaxed);
+			write(payload(i));
+			s.size = size;
+			s.seq.store(seq + 1, std::memory_order_relaxed);
+			s.pins.store(0, std::memory_order_release);
+
+			index()[seq % slots].store(static_cast<std::uint32_t>(i), std::memory_order_release);
+			_m_header->published.store(seq + 1);
+			_m_header->notify.fetch_add(1);
+			if (_m_header->waiters.load() != 0) {
+				futex(&_m_header->notify, FUTEX_WAKE, INT_MAX);
+			}
+			_m_next_slot = i + 1;
+			return true;
+		}
+		_m_dropped++;
+		return false;
+	}
+
+	/**
+	 * @brief An event's bytes, valid while `pin` (or a copy of it) lives.
+	 */
+	struct pinned {
+		std::shared_ptr<const void> pin;
+		const std::byte* data;
+		std::size_t size;
+	};
+
+	/**
+	 * @brief Pins the event numbered @p next, if it was published, and advances @p next.
+	 *
+	 * Events which were overwritten before this reader got to them are skipped and added to @p lost.
+	 */
+	bool try_read(std::uint64_t& next, pinned& out, std::uint64_t& lost) {
+		const std::uint64_t slots = _m_header->slots;
+		while (true) {
+			std::uint64_t published = _m_header->published.load();
+			if (next >= published) {
+				return false;
+			}
+			if (published - next > slots) {
+				lost += published - slots - next;
+				next = published - slots;
+			}
+			std::uint64_t seq = next++;
+			std::uint32_t i = index()[seq % slots].load(std::memory_order_acquire);
+			slot_header& s = slot(i);
+
+			std::uint32_t pins = s.pins.load(std::memory_order_relaxed);
+			bool pinned_ = false;
+			while (!(pins & _s_writing)) {
+				if (s.pins.compare_exchange_weak(pins, pins + 1, std::memory_order_acquire)) {
+					pinned_ = true;
+					break;
+				}
+			}
+			if (pinned_ && s.seq.load(std::memory_order_relaxed) == seq + 1) {
+				out.data = payload(i);
+				out.size = s.size;
+				out.pin = std::shared_ptr<const void>{out.data, [ring = shared_from_this(), &s](const void*) {
+					s.pins.fetch_sub(1, std::memory_order_release);
+				}};
+				return true;
+			}
+			if (pinned_) {
+				s.pins.fetch_sub(1, std::memory_order_release);
+			}
+			lost++;
+		}
+	}
+
+	/**
+	 * @brief Sleeps until an event numbered @p next or later is published, `wake_readers` is called, or @p stop is set.
+	 *
+	 * May return spuriously.
+	 */
+	void wait(std::uint64_t next, const std::atomic<bool>& stop) {
+		_m_header->waiters.fetch_add(1);
+		std::uint32_t notify = _m_header->notify.load();
+		if (_m_header->published.load() <= next && !stop.load()) {
+			futex(&_m_header->notify, FUTEX_WAIT, notify);
+		}
+		_m_header->waiters.fetch_sub(1);
+	}
+
+	/**
+	 * @brief Wakes every reader in `wait`, in every process.
+	 */
+	void wake_readers() {
+		_m_header->notify.fetch_add(1);
+		futex(&_m_header->notify, FUTEX_WAKE, INT_MAX);
+	}
+};
+
+/**
+ * @brief How events of type @p specific_event are laid out in a `shm_ring` slot.
+ *
+ * Specializations provide:
+ *
+ * \code{.cpp}
+ * static std::size_t size(const specific_event&);
+ * static void write(const specific_event&, std::byte* dst, const RelativeClock&);
+ * static switchboard::ptr<specific_event> read(const std::byte* src, std::size_t size, const RelativeClock&, std::shared_ptr<const void>&& pin);
+ * \endcode
+ *
+ * `read` should point into @p src rather than copy, keeping @p pin alive for as long as it does
+ * (see `shm_pinned`). Times should be written as `RelativeClock::absolute_ns`, since the readers'
+ * clocks started at different times.
+ */
+template <typename specific_event>
+struct shm_codec;
+
+/**
+ * @brief An event read out of a `shm_ring`, which keeps its slot pinned.
+ */
+template <typename specific_event>
+class shm_pinned : public specific_event {
+public:
+	template <typename... Args>
+	shm_pinned(std::shared_ptr<const void>&& pin, Args&&... args)
+		: specific_event(std::forward<Args>(args)...)
+		, _m_pin{std::move(pin)}
+	{ }
+
+	bool borrowed() const noexcept override {
+		return true;
+	}
+
+	/**
+	 * @brief Encodes the event again into a buffer of its own, aligned like a slot, and reads it
+	 * back pinning that instead.
+	 *
+	 * The clock is the same on both sides, so times come back unchanged.
+	 */
+	switchboard::ptr<switchboard::event> copy_borrowed() const override {
+		static constexpr std::align_val_t alignment{64};
+		static const RelativeClock clock;
+
+		const std::size_t size = shm_codec<specific_event>::size(*this);
+		std::shared_ptr<std::byte> buffer{static_cast<std::byte*>(::operator new(size, alignment)), [](std::byte* bytes) {
+			::operator delete(bytes, alignment);
+		}};
+		shm_codec<specific_event>::write(*this, buffer.get(), clock);
+		const std::byte* bytes = buffer.get();
+		return shm_codec<specific_event>::read(bytes, size, clock, std::shared_ptr<const void>{std::move(buffer), bytes});
+	}
+
+private:
+	std::shared_ptr<const void> _m_pin;
+};
+
+/**
+ * @brief Trivially-copyable values; the wrapper holds its value, so this copies `sizeof(T)` bytes out.
+ */
+template <typename T>
+struct shm_codec<switchboard::event_wrapper<T>> {
+	static_assert(std::is_trivially_copyable_v<T>, "shm_codec<event_wrapper<T>> needs a trivially-copyable T");
+
+	static std::size_t size(const switchboard::event_wrapper<T>&) {
+		return sizeof(T);
+	}
+
+	static void write(const switchboard::event_wrapper<T>& this_event, std::byte* dst, const RelativeClock&) {
+		std::memcpy(dst, &*this_event, sizeof(T));
+	}
+
+	static switchboard::ptr<switchboard::event_wrapper<T>> read(const std::byte* src, std::size_t, const RelativeClock&, std::shared_ptr<const void>&&) {
+		auto this_event = switchboard::make_ptr<switchboard::event_wrapper<T>>();
+		std::memcpy(&**this_event, src, sizeof(T));
+		return this_event;
+	}
+};
+
+/**
+ * @brief Mirrors every event on a switchboard topic into a `shm_ring` of the same name.
+ *
+ * This is an ordinary subscription, so the publisher is not slowed down; the ring lives (and other
+ * processes can attach) until the switchboard is destroyed. Returns the ring, for its drop count.
+ */
+template <typename specific_event>
+std::shared_ptr<const shm_ring> shm_export(switchboard& sb, const std::shared_ptr<RelativeClock>& clock, plugin_id_t plugin_id,
+										   const std::string& topic_name, std::size_t slots, std::size_t slot_size) {
+	std::shared_ptr<shm_ring> ring = shm_ring::create(topic_name, typeid(specific_event), slots, slot_size);
+	sb.schedule<specific_event>(plugin_id, topic_name, [ring, clock](switchboard::ptr<const specific_event>&& this_event, std::size_t) {
+		ring->publish(shm_codec<specific_event>::size(*this_event), [&](std::byte* dst) {
+			shm_codec<specific_event>::write(*this_event, dst, *clock);
+		});
+	});
+	return ring;
+}
+
+/**
+ * @brief An `shm_importer` of any type.
+ */
+class shm_import {
+public:
+	virtual ~shm_import() = default;
+
+	/// Events which were overwritten before this process got to them
+	virtual std::uint64_t lost() const = 0;
+};
+
+/**
+ * @brief Publishes the events from another process's `shm_export` on the local topic of the same name.
+ *
+ * Local readers and subscribers use the topic as usual; the events they get point into the shared
+ * slots. Waits for the exporting process to create the ring, if need be.
+ */
+template <typename specific_event>
+class shm_importer : public shm_import {
+public:
+	shm_importer(std::shared_ptr<switchboard> sb, std::shared_ptr<RelativeClock> clock, std::string topic_name)
+		: _m_sb{std::move(sb)}
+		, _m_clock{std::move(clock)}
+		, _m_topic_name{std::move(topic_name)}
+		, _m_writer{_m_sb->get_writer<specific_event>(_m_topic_name)}
+		, _m_thread{[this] { thread_body(); }}
+	{
+		_m_thread.start();
+	}
+
+	~shm_importer() override {
+		_m_stopping.store(true);
+		_m_thread.request_stop();
+		if (_m_ring_ready.load()) {
+			_m_ring->wake_readers();
+		}
+		_m_thread.stop();
+	}
+
+	std::uint64_t lost() const override {
+		return _m_lost.load();
+	}
+
+private:
+	std::shared_ptr<switchboard> _m_sb;
+	std::shared_ptr<RelativeClock> _m_clock;
+	const std::string _m_topic_name;
+	switchboard::writer<specific_event> _m_writer;
+	std::shared_ptr<shm_ring> _m_ring;
+	std::atomic<bool> _m_ring_ready {false};
+	std::uint64_t _m_next {0};
+	std::atomic<std::uint64_t> _m_lost {0};
+	std::atomic<bool> _m_stopping {false};
+	managed_thread _m_thread;
+
+	void thread_body() {
+		if (!_m_ring) {
+			_m_ring = shm_ring::open(_m_topic_name, typeid(specific_event));
+			if (!_m_ring) {
+				std::this_thread::sleep_for(std::chrono::milliseconds{10});
+				return;
+			}
+			_m_ring_ready.store(true);
+		}
+		_m_ring->wait(_m_next, _m_stopping);
+		shm_ring::pinned slot;
+		std::uint64_t lost = 0;
+		while (!_m_stopping.load() && _m_ring->try_read(_m_next, slot, lost)) {
+			_m_writer.put(shm_codec<specific_event>::read(slot.data, slot.size, *_m_clock, std::move(slot.pin)));
+		}
+		_m_lost += lost;
+	}
+};
+
+/**
+ * @brief Exports and imports topics whose type is known only by name at runtime (as the
+ * `shm_bridge` plugin does), for the types with an `shm_codec` which were added.
+ */
+class shm_topic_types {
+public:
+	template <typename specific_event>
+	void add() {
+		_m_types[typeid(specific_event).name()] = handlers{
+			[](switchboard& sb, const std::shared_ptr<RelativeClock>& clock, plugin_id_t plugin_id, const std::string& topic_name,
+			   std::size_t slots, std::size_t slot_size) {
+				return shm_export<specific_event>(sb, clock, plugin_id, topic_name, slots, slot_size);
+			},
+			[](std::shared_ptr<switchboard> sb, std::shared_ptr<RelativeClock> clock, const std::string& topic_name) -> std::unique_ptr<shm_import> {
+				return std::make_unique<shm_importer<specific_event>>(std::move(sb), std::move(clock), topic_name);
+			},
+		};
+	}
+
+	bool has(const std::string& type_name) const {
+		return _m_types.count(type_name) != 0;
+	}
+
+	/**
+	 * @brief `shm_export` for @p topic_name, whose events are of @p type.
+	 */
+	std::shared_ptr<const shm_ring> export_topic(const std::type_info& type, switchboard& sb, const std::shared_ptr<RelativeClock>& clock,
+												 plugin_id_t plugin_id, const std::string& topic_name, std::size_t slots, std::size_t slot_size) const {
+		return _m_types.at(type.name()).export_topic(sb, clock, plugin_id, topic_name, slots, slot_size);
+	}
+
+	/**
+	 * @brief An `shm_importer` for @p topic_name, whose events are of @p type.
+	 */
+	std::unique_ptr<shm_import> import_topic(const std::type_info& type, std::shared_ptr<switchboard> sb, std::shared_ptr<RelativeClock> clock,
+											 const std::string& topic_name) const {
+		return _m_types.at(type.name()).import_topic(std::move(sb), std::move(clock), topic_name);
+	}
+
+private:
+	struct handlers {
+		std::function<std::shared_ptr<const shm_ring>(switchboard&, const std::shared_ptr<RelativeClock>&, plugin_id_t, const std::string&, std::size_t, std::size_t)> export_topic;
+		std::function<std::unique_ptr<shm_import>(std::shared_ptr<switchboard>, std::shared_ptr<RelativeClock>, const std::string&)> import_topic;
+	};
+
+	std::unordered_map<std::string, handlers> _m_types;
+};
+
+} // namespace ILLIXR
@@ -1,17 +1,27 @@
 #pragma once
 
 #include <memory>
+#include <new>
 #include <list>
+#include <deque>
+#include <utility>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
 #include <string>
 #include <array>
+#include <cstdint>
 #include <sstream>
 #include <atomic>
+#include <mutex>
 #include <shared_mutex>
 #include <type_traits>
 #include <functional>
 #include <chrono>
 #include <exception>
+#include <thread>
 #include "phonebook.hpp"
+#include "relative_clock.hpp"
 #if __has_include("cpu_timer.hpp")
 	#include "cpu_timer.hpp"
 #else
@@ -19,6 +29,9 @@
 #endif
 #include "record_logger.hpp"
 #include "managed_thread.hpp"
+#include "work_stealing_executor.hpp"
+#include "latency_histogram.hpp"
+#include "thread_placement.hpp"
 #include "concurrentqueue/blockingconcurrentqueue.hpp"
 
 namespace ILLIXR {
@@ -28,14 +41,24 @@ using plugin_id_t = std::size_t;
 /**
  * @Should be private to Switchboard.
  */
-const record_header __switchboard_callback_header {"switchboard_callback", {
-    {"plugin_id", typeid(plugin_id_t)},
-    {"topic_name", typeid(std::string)},
-    {"iteration_no", typeid(std::size_t)},
-    {"cpu_time_start", typeid(std::chrono::nanoseconds)},
-    {"cpu_time_stop" , typeid(std::chrono::nanoseconds)},
-    {"wall_time_start", typeid(std::chrono::high_resolution_clock::time_point)},
-    {"wall_time_stop" , typeid(std::chrono::high_resolution_clock::time_point)},
+const typed_record_header<
+    plugin_id_t,
+    std::string,
+    std::size_t,
+    std::chrono::nanoseconds,
+    std::chrono::nanoseconds,
+    std::chrono::high_resolution_clock::time_point,
+    std::chrono::high_resolution_clock::time_point,
+    std::size_t
+> __switchboard_callback_header {"switchboard_callback", {
+    "plugin_id",
+    "topic_name",
+    "iteration_no",
+    "cpu_time_start",
+    "cpu_time_stop",
+    "wall_time_start",
+    "wall_time_stop",
+    "batch_size",
 }};
 
 /**
@@ -46,7 +69,45 @@ const record_header __switchboard_topic_stop_header {"switchboard_topic_stop", {
     {"topic_name", typeid(std::string)},
     {"enqueued", typeid(std::size_t)},
     {"dequeued", typeid(std::size_t)},
-    {"idle_cycles", typeid(std::size_t)},
+    {"dropped", typeid(std::size_t)},
+    {"deadline_misses", typeid(std::size_t)},
+}};
+
+const record_header __switchboard_latency_header {"switchboard_latency", {
+    {"plugin_id", typeid(plugin_id_t)},
+    {"topic_name", typeid(std::string)},
+    {"metric", typeid(std::string)},
+    {"count", typeid(std::size_t)},
+    {"p50", typeid(std::chrono::nanoseconds)},
+    {"p90", typeid(std::chrono::nanoseconds)},
+    {"p99", typeid(std::chrono::nanoseconds)},
+    {"p999", typeid(std::chrono::nanoseconds)},
+    {"max", typeid(std::chrono::nanoseconds)},
+}};
+
+const typed_record_header<
+    plugin_id_t,
+    std::string,
+    std::size_t,
+    std::chrono::nanoseconds,
+    std::chrono::nanoseconds
+> __switchboard_deadline_miss_header {"switchboard_deadline_miss", {
+    "plugin_id",
+    "topic_name",
+    "iteration_no",
+    "deadline",
+    "lateness",
+}};
+
+/**
+ * @Should be private to Switchboard.
+ */
+const record_header __switchboard_topic_pool_header {"switchboard_topic_pool", {
+    {"topic_name", typeid(std::string)},
+    {"block_size", typeid(std::size_t)},
+    {"hits", typeid(std::size_t)},
+    {"misses", typeid(std::size_t)},
+    {"free_blocks", typeid(std::size_t)},
 }};
 
 /**
@@ -76,7 +137,7 @@ const record_header __switchboard_topic_stop_header {"switchboard_topic_stop", {
  *
  * while (true) {
  *     // Read topic 1
- *     switchboard::ptr<topic1_type> event1 = topic1.get_rw();
+ *     switchboard::cow_ptr<topic1_type> event1 = topic1.get_rw();
  *
  *     // Write to topic 2 using topic 1 input
  *     topic2.put(topic2.allocate<topic2_type>( do_something(event1->foo) ));
@@ -91,16 +152,144 @@ const record_header __switchboard_topic_stop_header {"switchboard_topic_stop", {
  * \endcode
  */
 class switchboard : public phonebook::service {
+private:
+    class event_pool;
+
 public:
 
+    class event;
+
     /**
-     * @brief The type of shared pointer returned by switchboard.
+     * @brief The handle on an event returned by switchboard.
+     *
+     * Like `std::shared_ptr`, but the reference count lives in the `event` itself, so a handle is
+     * one pointer wide and there is no separate control block to allocate or miss on. The count
+     * sits right after the vtable pointer, in the cache line which a reader of the event touches
+     * anyway.
      *
-     * TODO: Make this agnostic to the type of `ptr`
-     * Currently, it depends on `ptr` == shared_ptr
+     * Make one with `writer::allocate()` or `make_ptr()`; convert one with `static_pointer_cast()`,
+     * `const_pointer_cast()` or `dynamic_pointer_cast()`. A `ptr<Derived>` converts implicitly to a
+     * `ptr<const Base>`. Moving a handle costs no atomic operations; copying one costs one.
+     *
+     * One event may be shared by handles on several threads, but one handle must not be used from
+     * several threads at once.
      */
     template <typename specific_event>
-    using ptr = std::shared_ptr<specific_event>;
+    class ptr {
+    public:
+        using element_type = specific_event;
+
+        constexpr ptr() noexcept = default;
+
+        constexpr ptr(std::nullptr_t) noexcept { }
+
+        ptr(const ptr& other) noexcept
+            : _m_event{other._m_event}
+        {
+            retain();
+        }
+
+        ptr(ptr&& other) noexcept
+            : _m_event{std::exchange(other._m_event, nullptr)}
+        { }
+
+        template <typename other_event, typename = std::enable_if_t<std::is_convertible_v<other_event*, specific_event*>>>
+        ptr(const ptr<other_event>& other) noexcept
+            : _m_event{other._m_event}
+        {
+            retain();
+        }
+
+        template <typename other_event, typename = std::enable_if_t<std::is_convertible_v<other_event*, specific_event*>>>
+        ptr(ptr<other_event>&& other) noexcept
+            : _m_event{std::exchange(other._m_event, nullptr)}
+        { }
+
+        ~ptr() {
+            reset();
+        }
+
+        ptr& operator=(ptr other) noexcept {
+            std::swap(_m_event, other._m_event);
+            return *this;
+        }
+
+        void reset() noexcept {
+            if (specific_event* this_event = std::exchange(_m_event, nullptr)) {
+                release(this_event);
+            }
+        }
+
+        specific_event* get() const noexcept { return _m_event; }
+        specific_event& operator*() const noexcept { return *_m_event; }
+        specific_event* operator->() const noexcept { return _m_event; }
+        explicit operator bool() const noexcept { return _m_event != nullptr; }
+
+        /**
+         * @brief The number of handles on this event (racy, like `std::shared_ptr::use_count()`).
+         */
+        std::size_t use_count() const noexcept {
+            return _m_event ? refs(_m_event).load(std::memory_order_relaxed) : 0;
+        }
+
+        friend bool operator==(const ptr& lhs, std::nullptr_t) noexcept { return lhs._m_event == nullptr; }
+        friend bool operator==(std::nullptr_t, const ptr& rhs) noexcept { return rhs._m_event == nullptr; }
+        friend bool operator!=(const ptr& lhs, std::nullptr_t) noexcept { return lhs._m_event != nullptr; }
+        friend bool operator!=(std::nullptr_t, const ptr& rhs) noexcept { return rhs._m_event != nullptr; }
+
+        template <typename other_event>
+        bool operator==(const ptr<other_event>& other) const noexcept { return _m_event == other.get(); }
+
+        template <typename other_event>
+        bool operator!=(const ptr<other_event>& other) const noexcept { return _m_event != other.get(); }
+
+    private:
+        template <typename other_event>
+        friend class ptr;
+        friend class switchboard;
+
+        specific_event* _m_event = nullptr;
+
+        static std::atomic<std::uint32_t>& refs(specific_event* this_event) noexcept {
+            return static_cast<const event*>(this_event)->_m_ownership.refs;
+        }
+
+        /**
+         * @brief Wraps @p this_event, taking over a reference which the caller already counted.
+         */
+        static ptr adopt(specific_event* this_event) noexcept {
+            ptr adopted;
+            adopted._m_event = this_event;
+            return adopted;
+        }
+
+        /**
+         * @brief Gives up the reference without dropping it; the caller must `adopt()` it again.
+         */
+        specific_event* detach() noexcept {
+            return std::exchange(_m_event, nullptr);
+        }
+
+        /**
+         * @brief Counts @p count more references at once, for the caller to `adopt()`.
+         */
+        void add_refs(std::uint32_t count) const noexcept {
+            refs(_m_event).fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void retain() noexcept {
+            if (_m_event) {
+                add_refs(1);
+            }
+        }
+
+        static void release(specific_event* this_event) noexcept {
+            // Acquire-release, so the other owners' reads of the event happen before the destructor.
+            if (refs(this_event).fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                destroy(static_cast<const event*>(this_event));
+            }
+        }
+    };
 
     /**
      * @brief Virtual class for event types.
@@ -110,14 +299,88 @@ public:
      * and is undefined behavior in modern C++.
      * Therefore, we require a common supertype for all events.
      * We will cast them to this common supertype, event* instead.
+     *
+     * The supertype also carries the reference count of `ptr`. Copying an event makes a new,
+     * unreferenced event; the count is not copied.
 
      * [1] https://cellperformance.beyond3d.com/articles/2006/06/understanding-strict-aliasing.html
      */
     class event {
     public:
         virtual ~event() = default;
+
+        /**
+         * @brief Whether the event points into memory it does not own and must not write, such as a
+         * shared-memory slot or a mapped log (see `shm_pinned`).
+         */
+        virtual bool borrowed() const noexcept { return false; }
+
+        /**
+         * @brief For a `borrowed()` event: a writable copy with memory of its own, of the same
+         * dynamic type or its base. `cow_ptr` makes it instead of copying the static type, which
+         * would keep the borrowed pointers but drop what keeps them valid.
+         */
+        virtual ptr<event> copy_borrowed() const { return nullptr; }
+
+    private:
+        template <typename specific_event>
+        friend class ptr;
+        friend class switchboard;
+
+        /// Belongs to one event in memory, so copies of the event start over.
+        struct ownership {
+            std::atomic<std::uint32_t> refs {0};
+            // Where the memory goes back to, or null if the event came from `new`
+            event_pool* pool = nullptr;
+
+            ownership() noexcept = default;
+            ownership(const ownership&) noexcept { }
+            ownership& operator=(const ownership&) noexcept { return *this; }
+        };
+
+        mutable ownership _m_ownership;
     };
 
+    /**
+     * @brief Makes a `ptr` to a new @p specific_event on the heap, like `std::make_shared`.
+     *
+     * Writers should prefer `writer::allocate()`, which recycles memory.
+     */
+    template <typename specific_event, typename... Args>
+    static ptr<specific_event> make_ptr(Args&&... args) {
+        specific_event* this_event = new specific_event(std::forward<Args>(args)...);
+        ptr<specific_event>::refs(this_event).store(1, std::memory_order_relaxed);
+        return ptr<specific_event>::adopt(this_event);
+    }
+
+    /**
+     * @brief Like `std::static_pointer_cast`; moving @p this_event in costs no atomic operations.
+     */
+    template <typename specific_event, typename other_event>
+    static ptr<specific_event> static_pointer_cast(ptr<other_event> this_event) noexcept {
+        return ptr<specific_event>::adopt(static_cast<specific_event*>(this_event.detach()));
+    }
+
+    /**
+     * @brief Like `std::const_pointer_cast`; moving @p this_event in costs no atomic operations.
+     */
+    template <typename specific_event, typename other_event>
+    static ptr<specific_event> const_pointer_cast(ptr<other_event> this_event) noexcept {
+        return ptr<specific_event>::adopt(const_cast<specific_event*>(this_event.detach()));
+    }
+
+    /**
+     * @brief Like `std::dynamic_pointer_cast`: null if @p this_event is not a @p specific_event.
+     */
+    template <typename specific_event, typename other_event>
+    static ptr<specific_event> dynamic_pointer_cast(const ptr<other_event>& this_event) noexcept {
+        ptr<specific_event> cast;
+        if ((cast._m_event = dynamic_cast<specific_event*>(this_event.get()))) {
+            cast.retain();
+        }
+        return cast;
+    }
+
     /**
      * @brief Helper class for making event types
      *
@@ -143,83 +406,1111 @@ public:
         const underlying_type& operator*() const { return underlying_data; }
     };
 
-private:
-    /**
-     * @brief Represents a single topic_subscription (callback and queue)
-     *
-     * This class treats everything as `event`s (type-erased) because `topic` treats everything as
-     * `event`s.
-     *
-     * Each topic can have 0 or more topic_subscriptions.
-     */
-    class topic_subscription {
-    private:
-        const std::string& _m_topic_name;
-        plugin_id_t _m_plugin_id;
-        std::function<void(ptr<const event>&&, std::size_t)> _m_callback;
-        const std::shared_ptr<record_logger> _m_record_logger;
-        record_coalescer _m_cb_log;
-        moodycamel::BlockingConcurrentQueue<ptr<const event>> _m_queue {8 /*max size estimate*/};
-        moodycamel::ConsumerToken _m_ctok {_m_queue};
-        static constexpr std::chrono::milliseconds _m_queue_timeout {100};
-        std::size_t _m_enqueued {0};
-        std::size_t _m_dequeued {0};
-        std::size_t _m_idle_cycles {0};
+    /**
+     * @brief Names a topic together with the type of its events.
+     *
+     * Declare one per topic next to its event type (see `topics` in data_format.hpp), and pass it
+     * to `get_reader()`, `get_writer()` and `schedule()` instead of a string. Then every user of
+     * the topic agrees on the type at compile time, rather than when the handles are made.
+     */
+    template <typename specific_event>
+    struct topic_descriptor {
+        const char* name;
+    };
+
+    /**
+     * @brief A copy-on-write handle on an event, returned by `reader::get_rw()`.
+     *
+     * Const access reads the shared event. The first mutable access (non-const `*`, `->` or
+     * `release()`) takes the event over without copying if this handle is its last owner (the
+     * topic moved on, and no subscriber still holds it); otherwise, it copies the event then.
+     * A `borrowed()` event is always copied, through `event::copy_borrowed()`.
+     *
+     * Like a `ptr`, one handle must not be used from several threads at once.
+     */
+    template <typename specific_event>
+    class cow_ptr {
+    public:
+        cow_ptr() noexcept = default;
+
+        explicit cow_ptr(ptr<const specific_event> shared) noexcept
+            : _m_event{std::move(shared)}
+        { }
+
+        const specific_event& operator*() const noexcept { return *_m_event; }
+        const specific_event* operator->() const noexcept { return _m_event.get(); }
+        const specific_event* get() const noexcept { return _m_event.get(); }
+
+        specific_event& operator*() { return *mutable_get(); }
+        specific_event* operator->() { return mutable_get(); }
+
+        explicit operator bool() const noexcept { return _m_event != nullptr; }
+
+        /**
+         * @brief Whether mutable access would not copy: the event is already private to this handle.
+         */
+        bool owned() const noexcept {
+            return _m_owned || (_m_event.use_count() == 1 && !_m_event->borrowed());
+        }
+
+        /**
+         * @brief Gives up the event as a unique, mutable `ptr` (copying it if it is still shared).
+         *
+         * The result can be `put()` on a writer of the same topic type.
+         */
+        ptr<specific_event> release() {
+            mutable_get();
+            ptr<specific_event> released = const_pointer_cast<specific_event>(std::move(_m_event));
+            _m_owned = false;
+            return released;
+        }
+
+    private:
+        ptr<const specific_event> _m_event;
+        bool _m_owned = false;
+
+        specific_event* mutable_get() {
+            if (!_m_owned && _m_event) {
+                if (_m_event->borrowed()) {
+                    // Neither write into the borrowed memory, nor slice the event away from what
+                    // keeps it mapped.
+                    _m_event = static_pointer_cast<const specific_event>(_m_event->copy_borrowed());
+                } else if (_m_event.use_count() == 1) {
+                    // Pairs with the release in the last other owner's decrement, so its reads of
+                    // the event happen before our writes.
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                } else {
+                    _m_event = make_ptr<specific_event>(*_m_event);
+                }
+                _m_owned = true;
+            }
+            // Events are created mutable and only shared as const, so this is not UB.
+            return const_cast<specific_event*>(_m_event.get());
+        }
+    };
+
+    /**
+     * @brief Counters describing how well a topic recycles event memory.
+     *
+     * See `writer::allocate()`.
+     */
+    struct pool_stats {
+        /// Size of the recycled blocks: that of the topic's event type
+        std::size_t block_size;
+        /// Allocations served from the free list
+        std::size_t hits;
+        /// Allocations which had to go to the heap
+        std::size_t misses;
+        /// Blocks currently waiting in the free list
+        std::size_t free_blocks;
+    };
+
+    /**
+     * @brief What a subscription does with a new event when its queue is full.
+     */
+    enum class overflow_policy {
+        /// The publisher waits for the subscriber to make room (lossless).
+        block,
+        /// The oldest queued event is discarded.
+        drop_oldest,
+        /// The new event is discarded.
+        drop_newest,
+        /// Only the most recent event is kept (the capacity is 1).
+        keep_latest,
+    };
+
+    /**
+     * @brief Where a subscription's callback runs.
+     */
+    enum class dispatch {
+        /// Events are queued for the subscription's thread (or the executor).
+        queued,
+        /// The callback runs directly in `put()`, on the publisher's thread. There is no queue, so
+        /// the capacity and overflow policy do not apply, and the publisher waits for the callback.
+        /// Only for cheap callbacks, which are not worth a thread wakeup. (If the publisher is
+        /// itself an inline callback and the subscription is busy on another thread, the event is
+        /// handed to that thread instead, and `put()` does not wait.)
+        inline_publisher,
+    };
+
+    /**
+     * @brief Quality-of-service parameters for a subscription.
+     *
+     * The default is an unbounded queue, which never drops or blocks.
+     */
+    struct qos {
+        /// Maximum number of queued events; 0 means unbounded.
+        std::size_t capacity = 0;
+        overflow_policy policy = overflow_policy::block;
+        /// The callback should be done with an event this long after it was published; 0 means
+        /// best-effort. On an executor, subscriptions with the earliest deadline run first, before
+        /// best-effort ones. Misses are logged as `switchboard_deadline_miss` records.
+        std::chrono::microseconds deadline {0};
+        dispatch dispatch_mode = dispatch::queued;
+    };
+
+    /**
+     * @brief Latency histograms of one subscription (see `switchboard::get_latency_stats`).
+     */
+    struct latency_stats {
+        plugin_id_t plugin_id;
+        /// From `put` to the start of the callback
+        latency_histogram::snapshot queue_delay;
+        /// Wall time of the callback (of the whole batch, for `schedule_batch`)
+        latency_histogram::snapshot callback_duration;
+        /// Between consecutive events published to the subscription
+        latency_histogram::snapshot inter_arrival;
+    };
+
+private:
+    /**
+     * @brief A recycling [slab][1] of fixed-size blocks, one per topic.
+     *
+     * Every event which a writer allocates on a topic has the topic's type, so the blocks all have
+     * one size. An event records its pool, and when the last `ptr` to it goes away, its block goes
+     * onto a lock-free free list, from which the writer's next `allocate()` takes it.
+     *
+     * The free list is a [Treiber stack][2]. Any thread may push. Only one thread at a time may pop,
+     * which rules out ABA; an allocation which finds another thread popping just goes to the heap
+     * instead of waiting.
+     *
+     * The pool is reference-counted by hand: the topic holds one reference and every outstanding
+     * block holds one, because events can outlive the topic. This is cheaper than putting a
+     * `shared_ptr` in every event.
+     *
+     * [1]: https://en.wikipedia.org/wiki/Slab_allocation
+     * [2]: https://en.wikipedia.org/wiki/Treiber_stack
+     */
+    class event_pool {
+    private:
+        struct free_block {
+            free_block* next;
+        };
+
+        const std::size_t _m_block_size;
+        const std::size_t _m_capacity;
+        std::atomic<free_block*> _m_free {nullptr};
+        std::atomic_flag _m_popping = ATOMIC_FLAG_INIT;
+        // One for the topic, plus one per outstanding block
+        std::atomic<std::size_t> _m_refs {1};
+        // Only written by the thread holding _m_popping
+        std::atomic<std::size_t> _m_hits {0};
+        std::atomic<std::size_t> _m_misses {0};
+        std::atomic<std::size_t> _m_dropped {0};
+
+        ~event_pool() {
+            free_block* block = _m_free.load();
+            while (block) {
+                free_block* next = block->next;
+                ::operator delete(block);
+                block = next;
+            }
+        }
+
+        void* try_pop() {
+            if (_m_popping.test_and_set(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            // We are the only popper, so head cannot be popped and pushed back (ABA) under us.
+            free_block* head = _m_free.load(std::memory_order_acquire);
+            while (head && !_m_free.compare_exchange_weak(head, head->next, std::memory_order_acquire)) { }
+            if (head) {
+                _m_hits.store(_m_hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+            _m_popping.clear(std::memory_order_release);
+            return head;
+        }
+
+        /// Blocks on the free list, derived from the counters to keep atomics off the fast path.
+        std::size_t free_blocks() const {
+            std::size_t owned = _m_misses.load(std::memory_order_relaxed) - _m_dropped.load(std::memory_order_relaxed);
+            std::size_t outstanding = _m_refs.load(std::memory_order_relaxed) - 1;
+            return owned > outstanding ? owned - outstanding : 0;
+        }
+
+    public:
+        /**
+         * @p capacity is the maximum number of free blocks retained; beyond that, blocks go back to the heap.
+         */
+        event_pool(std::size_t block_size, std::size_t capacity)
+            : _m_block_size{std::max(block_size, sizeof(free_block))}
+            , _m_capacity{capacity}
+        { }
+
+        /**
+         * @brief Drops one reference; the last one deletes the pool.
+         */
+        void unref() noexcept {
+            if (_m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        /**
+         * @brief Gets a block, recycling one if possible.
+         *
+         * Thread-safe
+         */
+        void* acquire() {
+            _m_refs.fetch_add(1, std::memory_order_relaxed);
+            if (void* block = try_pop()) {
+                return block;
+            }
+            _m_misses.fetch_add(1, std::memory_order_relaxed);
+            try {
+                return ::operator new(_m_block_size);
+            } catch (...) {
+                unref();
+                throw;
+            }
+        }
+
+        /**
+         * @brief Returns a block from `acquire()`.
+         *
+         * Thread-safe
+         */
+        void release(void* ptr) noexcept {
+            if (free_blocks() < _m_capacity) {
+                free_block* block = new (ptr) free_block{_m_free.load(std::memory_order_relaxed)};
+                while (!_m_free.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) { }
+                unref();
+                return;
+            }
+            _m_dropped.fetch_add(1, std::memory_order_relaxed);
+            ::operator delete(ptr);
+            unref();
+        }
+
+        pool_stats get_stats() const {
+            return pool_stats{_m_block_size, _m_hits.load(), _m_misses.load(), free_blocks()};
+        }
+    };
+
+    /**
+     * @brief Destroys an event whose last `ptr` went away, returning its memory to its pool.
+     */
+    static void destroy(const event* this_event) noexcept {
+        if (event_pool* pool = this_event->_m_ownership.pool) {
+            // The block starts at the most-derived object, which need not be where the event is.
+            void* block = const_cast<void*>(dynamic_cast<const void*>(this_event));
+            this_event->~event();
+            pool->release(block);
+        } else {
+            delete this_event;
+        }
+    }
+
+    /**
+     * @brief Holds the most recent value of a `shared_ptr`-like @p pointer.
+     *
+     * Loads and stores may come from any number of threads. The value lives in one of a few
+     * slots. Each slot has a state word which counts the readers copying out of it, plus a bit
+     * set while a writer fills it.
+     *
+     * - A reader bumps the count of the current slot. If no writer holds that slot and it is still
+     *   current, the reader copies the pointer out and then drops its count.
+     *
+     * - A writer claims a non-current slot with no readers (CAS 0 -> writing), fills it, makes it
+     *   current (CAS from the slot it started from) and releases it. Publishing under the claim
+     *   keeps other writers from reusing the slot in between. If another writer published first,
+     *   the writer puts the slot back as it was and tries again. Then it tries to clear the slot
+     *   which was current before, so an idle topic only keeps its latest value alive.
+     *
+     * Readers never block; they retry when a store happened under them, or for the moment between
+     * a writer publishing its slot and releasing it. Writers never wait for readers unless every
+     * other slot is being copied from at that moment.
+     */
+    template <typename pointer>
+    class latest_slot {
+    private:
+        static constexpr std::size_t _s_slots = 4;
+        static constexpr std::uint32_t _s_writing = std::uint32_t{1} << 31;
+
+        struct alignas(64) slot {
+            std::atomic<std::uint32_t> state {0};
+            pointer value;
+        };
+
+        mutable std::array<slot, _s_slots> _m_slots;
+        std::atomic<std::size_t> _m_current {0};
+
+        bool try_claim(std::size_t i) {
+            std::uint32_t idle = 0;
+            return _m_slots[i].state.compare_exchange_strong(idle, _s_writing);
+        }
+
+        void unclaim(std::size_t i) {
+            _m_slots[i].state.fetch_sub(_s_writing);
+        }
+
+    public:
+        /**
+         * @brief Gets a copy of the latest value (null if nothing was stored yet).
+         *
+         * Thread-safe
+         */
+        pointer load() const {
+            return load_as([](const pointer& value) { return value; });
+        }
+
+        /**
+         * @brief Like `load()`, but copies out `convert(value)`.
+         *
+         * This lets a reader convert the pointer (e.g. downcast a `shared_ptr`) as it copies it,
+         * rather than copying it and then converting the copy.
+         *
+         * Thread-safe
+         */
+        template <typename convert_fn>
+        auto load_as(convert_fn convert) const -> decltype(convert(std::declval<const pointer&>())) {
+            while (true) {
+                std::size_t i = _m_current.load();
+                slot& s = _m_slots[i];
+                if (!(s.state.fetch_add(1) & _s_writing) && _m_current.load() == i) {
+                    auto copy = convert(s.value);
+                    s.state.fetch_sub(1);
+                    return copy;
+                }
+                s.state.fetch_sub(1);
+            }
+        }
+
+        /**
+         * @brief Replaces the latest value.
+         *
+         * Thread-safe
+         */
+        void store(pointer value) {
+            std::size_t previous = _m_current.load();
+            while (true) {
+                std::size_t i = previous;
+                do {
+                    i = (i + 1) % _s_slots;
+                } while (i == previous || !try_claim(i));
+
+                std::swap(_m_slots[i].value, value);
+                if (_m_current.compare_exchange_strong(previous, i)) {
+                    // Drop the old contents of the claimed slot after releasing it.
+                    unclaim(i);
+                    value.reset();
+                    break;
+                }
+                // Someone else published since we looked; `previous` is now their slot.
+                std::swap(_m_slots[i].value, value);
+                unclaim(i);
+            }
+
+            // If nobody is reading the previous slot, do not let it pin a stale value.
+            // It may have become current again through a concurrent store, so check under the claim.
+            if (try_claim(previous)) {
+                if (_m_current.load() != previous) {
+                    std::swap(_m_slots[previous].value, value);
+                }
+                unclaim(previous);
+                value.reset();
+            }
+        }
+    };
+
+    /**
+     * @brief An immutable value which readers use without locking, and writers replace RCU-style.
+     *
+     * A reader enters a read-side section with `read()`, which counts it in the current epoch, and
+     * uses the value until the guard goes away. A writer swaps in the new value and sets the old one
+     * aside, without waiting: readers may hold their guard for long (a publisher blocked on a full
+     * queue, or running inline callbacks), and may be the ones replacing the value.
+     *
+     * `synchronize()` twice flips the epoch and waits for the readers counted in the previous one to
+     * leave. Readers which count themselves after a swap see the new value, so the waits end even
+     * under a steady stream of readers; the second flip catches readers which read the epoch just
+     * before the first one but counted themselves after it. Then nobody can hold the values set
+     * aside before, and they are deleted. Until then (at the latest, until the snapshot goes), they
+     * are kept, which is cheap for values which change rarely.
+     *
+     * The counters are striped per thread, so concurrent readers do not share a cache line.
+     */
+    template <typename T>
+    class rcu_snapshot {
+    private:
+        static constexpr std::size_t _s_stripes = 8;
+
+        struct alignas(64) counter {
+            std::atomic<std::size_t> readers {0};
+        };
+
+        std::atomic<const T*> _m_value;
+        std::atomic<std::size_t> _m_epoch {0};
+        mutable std::array<std::array<counter, _s_stripes>, 2> _m_counters;
+        // Replaced values which readers may still hold
+        std::vector<std::unique_ptr<const T>> _m_retired;
+        std::mutex _m_retired_lock;
+        // Serializes synchronize()
+        std::mutex _m_synchronize_lock;
+
+        static std::size_t this_stripe() {
+            static std::atomic<std::size_t> next {0};
+            thread_local const std::size_t stripe = next.fetch_add(1) % _s_stripes;
+            return stripe;
+        }
+
+    public:
+        class guard {
+        public:
+            guard(std::atomic<std::size_t>& readers, const T* value)
+                : _m_readers{readers}
+                , _m_value{value}
+            { }
+
+            guard(const guard&) = delete;
+            guard& operator=(const guard&) = delete;
+
+            ~guard() {
+                _m_readers.fetch_sub(1);
+            }
+
+            const T& operator*() const { return *_m_value; }
+            const T* operator->() const { return _m_value; }
+
+        private:
+            std::atomic<std::size_t>& _m_readers;
+            const T* const _m_value;
+        };
+
+        explicit rcu_snapshot(std::unique_ptr<const T> value)
+            : _m_value{value.release()}
+        { }
+
+        rcu_snapshot(const rcu_snapshot&) = delete;
+        rcu_snapshot& operator=(const rcu_snapshot&) = delete;
+
+        ~rcu_snapshot() {
+            delete _m_value.load();
+        }
+
+        /**
+         * @brief Enters a read-side section; the value stays alive while the guard exists.
+         *
+         * Thread-safe and lock-free
+         */
+        guard read() const {
+            std::atomic<std::size_t>& readers = _m_counters[_m_epoch.load() % 2][this_stripe()].readers;
+            readers.fetch_add(1);
+            return guard{readers, _m_value.load()};
+        }
+
+        /**
+         * @brief Publishes @p value. The old one is kept until `synchronize()`.
+         *
+         * Thread-safe, and does not wait for readers, so it may be called from a read-side section.
+         */
+        void replace(std::unique_ptr<const T> value) {
+            std::unique_ptr<const T> old {_m_value.exchange(value.release())};
+            const std::lock_guard<std::mutex> lock {_m_retired_lock};
+            _m_retired.push_back(std::move(old));
+        }
+
+        /**
+         * @brief Waits until no reader can still see a value replaced before this call, and deletes
+         * those values.
+         *
+         * Thread-safe, but must not be called from a read-side section, which it would wait for.
+         */
+        void synchronize() {
+            const std::lock_guard<std::mutex> synchronize_lock {_m_synchronize_lock};
+            std::vector<std::unique_ptr<const T>> retired;
+            {
+                const std::lock_guard<std::mutex> lock {_m_retired_lock};
+                retired.swap(_m_retired);
+            }
+            for (int flip = 0; flip < 2; ++flip) {
+                const std::size_t previous = _m_epoch.fetch_add(1);
+                for (counter& c : _m_counters[previous % 2]) {
+                    while (c.readers.load() != 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief A bounded, time-indexed history of the events on a topic.
+     *
+     * Disabled (and free) until `configure()` gives it a length and a way to get the time of an
+     * event. Then it keeps the last `length` events in a ring, ordered by time, so that range
+     * queries are binary searches and hand out pointers to the events rather than copies.
+     *
+     * Keeping an event keeps everything it holds alive (images, shared-memory slots, replay
+     * chunks). To avoid that, `configure()` can also take a function which makes the copy to keep,
+     * with only the fields the queries need.
+     *
+     * Event times must not decrease; if they do (e.g. a dataset loops), the history starts over.
+     *
+     * Thread-safe
+     */
+    class event_history {
+    public:
+        using time_of_fn = std::function<time_point(const event&)>;
+        using remember_fn = std::function<ptr<const event>(const event&)>;
+
+        /**
+         * @brief Keeps at least @p length events from now on, as made by @p remember (by default,
+         * the events themselves).
+         *
+         * Several readers may ask for a history; the longest one wins. @p time_of and @p remember
+         * are those of the first; they are not changed afterwards, so `push()` reads them without
+         * locking.
+         */
+        void configure(std::size_t length, time_of_fn time_of, remember_fn remember = {}) {
+            assert(length > 0);
+            const std::unique_lock lock{_m_lock};
+            if (length > _m_ring.size()) {
+                std::vector<entry> ring (length);
+                for (std::size_t i = 0; i < _m_size; ++i) {
+                    ring[i] = std::move(at(i));
+                }
+                _m_ring = std::move(ring);
+                _m_begin = 0;
+            }
+            if (!_m_enabled.load()) {
+                _m_time_of = std::move(time_of);
+                _m_remember = std::move(remember);
+                _m_enabled.store(true);
+            }
+        }
+
+        void push(const ptr<const event>& this_event) {
+            if (!_m_enabled.load()) {
+                return;
+            }
+            // Set before _m_enabled, and constant since
+            time_point time = _m_time_of(*this_event);
+            ptr<const event> kept = _m_remember ? _m_remember(*this_event) : this_event;
+            const std::unique_lock lock{_m_lock};
+            if (_m_size != 0 && time < at(_m_size - 1).time) {
+                clear();
+            }
+            if (_m_size == _m_ring.size()) {
+                // Overwrite the oldest
+                _m_ring[_m_begin] = entry{time, std::move(kept)};
+                _m_begin = (_m_begin + 1) % _m_ring.size();
+            } else {
+                at(_m_size) = entry{time, std::move(kept)};
+                _m_size++;
+            }
+        }
+
+        /**
+         * @brief The events with @p begin <= time <= @p end, oldest first.
+         */
+        std::vector<ptr<const event>> range(time_point begin, time_point end) const {
+            std::vector<ptr<const event>> events;
+            const std::shared_lock lock{_m_lock};
+            for (std::size_t i = lower_bound(begin); i < _m_size && at(i).time <= end; ++i) {
+                events.push_back(at(i).value);
+            }
+            return events;
+        }
+
+        /**
+         * @brief The last event with time < @p time, or null.
+         */
+        ptr<const event> latest_before(time_point time) const {
+            const std::shared_lock lock{_m_lock};
+            std::size_t i = lower_bound(time);
+            return i == 0 ? nullptr : at(i - 1).value;
+        }
+
+        /**
+         * @brief The first event with time > @p time, or null.
+         */
+        ptr<const event> earliest_after(time_point time) const {
+            const std::shared_lock lock{_m_lock};
+            std::size_t i = lower_bound(time);
+            while (i < _m_size && at(i).time <= time) {
+                ++i;
+            }
+            return i == _m_size ? nullptr : at(i).value;
+        }
+
+        bool enabled() const {
+            return _m_enabled.load();
+        }
+
+    private:
+        struct entry {
+            time_point time;
+            ptr<const event> value;
+        };
+
+        std::vector<entry> _m_ring;
+        std::size_t _m_begin {0};
+        std::size_t _m_size {0};
+        time_of_fn _m_time_of;
+        remember_fn _m_remember;
+        std::atomic<bool> _m_enabled {false};
+        mutable std::shared_mutex _m_lock;
+
+        /// The @p i-th oldest entry
+        entry& at(std::size_t i) {
+            return _m_ring[(_m_begin + i) % _m_ring.size()];
+        }
+
+        const entry& at(std::size_t i) const {
+            return _m_ring[(_m_begin + i) % _m_ring.size()];
+        }
+
+        /// Index of the first entry with time >= @p time
+        std::size_t lower_bound(time_point time) const {
+            std::size_t lo = 0;
+            std::size_t hi = _m_size;
+            while (lo < hi) {
+                std::size_t mid = lo + (hi - lo) / 2;
+                if (at(mid).time < time) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        void clear() {
+            for (std::size_t i = 0; i < _m_size; ++i) {
+                at(i).value.reset();
+            }
+            _m_begin = 0;
+            _m_size = 0;
+        }
+    };
+
+    /**
+     * @brief An event in a subscription's queue, with the time it was published.
+     */
+    struct queued_event {
+        ptr<const event> value;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    /**
+     * @brief Represents a single topic_subscription (callback and queue)
+     *
+     * This class treats everything as `event`s (type-erased) because `topic` treats everything as
+     * `event`s.
+     *
+     * Each topic can have 0 or more topic_subscriptions.
+     *
+     * The callback runs either on a dedicated thread, or (if switchboard has an executor) as a task
+     * on the shared `work_stealing_executor`. In the latter case, `_m_pending` counts events which
+     * have been enqueued but not processed; whoever moves it from 0 to 1 submits the task, so at
+     * most one worker runs this subscription at a time and events are processed in order.
+     *
+     * The queue may be bounded by a `qos`. `_m_queued` counts the events in the queue. Publishers
+     * enforce the overflow policy: they wait on `_m_space` (block), give up (drop_newest), or evict
+     * the oldest event before enqueueing theirs (drop_oldest, keep_latest). Evicting first, under
+     * `_m_evict_lock`, means a publisher never evicts its own event, even when the consumer has
+     * just taken the one it counted on evicting. An evicting publisher does not count its event in
+     * `_m_pending`, since it took one out.
+     *
+     * A batched subscription (one with `_m_batch_callback`) dequeues up to `_m_max_batch` events
+     * in bulk and calls back once for all of them.
+     *
+     * The subscription thread blocks on the queue without a timeout. To stop it, the destructor
+     * asks the thread to stop and enqueues a null event, which wakes it up.
+     *
+     * Events are stamped when published, for the latency histograms (which are logged every
+     * `_m_latency_log_period`) and the deadline. The task is submitted with the deadline of
+     * the oldest event it will process (when resubmitted, that of the last processed event, which
+     * is no later).
+     *
+     * An inline subscription (`dispatch::inline_publisher`) has neither a thread nor a queue; see
+     * `run_inline()`.
+     *
+     * With a virtual `RelativeClock`, each queued event is held on the clock (see
+     * `clock_backend::hold()`) until its callback returns or it is dropped, so that time does not
+     * jump while subscribers are still busy.
+     */
+    class topic_subscription : public work_stealing_executor::task {
+    private:
+        const std::string& _m_topic_name;
+        plugin_id_t _m_plugin_id;
+        std::function<void(ptr<const event>&&, std::size_t)> _m_callback;
+        std::function<void(std::vector<queued_event>&, std::size_t)> _m_batch_callback;
+        const std::size_t _m_max_batch;
+        const std::chrono::microseconds _m_batch_window;
+        std::vector<queued_event> _m_batch;
+        std::size_t _m_batches {0};
+        const std::shared_ptr<record_logger> _m_record_logger;
+        decltype(__switchboard_callback_header)::coalescer _m_cb_log;
+        moodycamel::BlockingConcurrentQueue<queued_event> _m_queue {8 /*max size estimate*/};
+        moodycamel::ConsumerToken _m_ctok {_m_queue};
+        std::atomic<std::size_t> _m_enqueued {0};
+        std::size_t _m_dequeued {0};
+
+        const overflow_policy _m_policy;
+        const std::size_t _m_capacity;
+        moodycamel::LightweightSemaphore _m_space;
+        // Serializes evicting publishers (drop_oldest, keep_latest)
+        std::mutex _m_evict_lock;
+        std::atomic<std::size_t> _m_queued {0};
+        std::atomic<std::size_t> _m_dropped {0};
+
+        const std::chrono::microseconds _m_deadline;
+        std::chrono::steady_clock::time_point _m_last_enqueued;
+        std::size_t _m_deadline_misses {0};
+
+        latency_histogram _m_queue_delay;
+        latency_histogram _m_callback_duration;
+        latency_histogram _m_inter_arrival;
+        // Nanoseconds since the steady_clock epoch; 0 before the first event
+        std::atomic<std::int64_t> _m_last_arrival {0};
+        static constexpr std::chrono::seconds _m_latency_log_period {1};
+        std::chrono::steady_clock::time_point _m_last_latency_log {std::chrono::steady_clock::now()};
+
+        work_stealing_executor* const _m_executor;
+        // Events processed per run() before yielding the worker to other subscriptions
+        static constexpr std::size_t _m_executor_quantum = 16;
+        std::atomic<std::size_t> _m_pending {0};
+        std::atomic<bool> _m_stopping {false};
+        std::size_t _m_discarded {0};
+
+        const bool _m_inline;
+        std::mutex _m_inline_lock;
+        // The thread running the inline callback, if any
+        std::atomic<std::thread::id> _m_inline_owner;
+        // Events published from within inline callbacks, left for the thread holding _m_inline_lock
+        std::deque<queued_event> _m_inline_pending;
+        std::mutex _m_inline_pending_lock;
+
+        // Null unless a thread_placement service is registered
+        const thread_placement* const _m_placement;
+        // Null unless the RelativeClock tracks work
+        const clock_backend* const _m_work_tracker;
+
+        // This needs to be last,
+        // so it is destructed before the data it uses.
+        managed_thread _m_thread;
+
+        void thread_on_start() {
+#ifndef NDEBUG
+            std::cerr << "Thread " << std::this_thread::get_id() << " start" << std::endl;
+#endif
+            if (_m_placement) {
+                _m_placement->apply("sb:" + _m_topic_name);
+            }
+        }
+
+        /**
+         * @brief The executor deadline for processing an event enqueued at @p enqueued.
+         */
+        std::chrono::steady_clock::time_point deadline_of(std::chrono::steady_clock::time_point enqueued) const {
+            return _m_deadline.count() != 0 ? enqueued + _m_deadline : work_stealing_executor::no_deadline;
+        }
+
+        /**
+         * @brief Counts and logs a miss, if an event enqueued at @p enqueued was done at @p done too late.
+         */
+        void check_deadline(std::chrono::steady_clock::time_point enqueued, std::chrono::steady_clock::time_point done, std::size_t iteration_no) {
+            if (_m_deadline.count() == 0 || done <= enqueued + _m_deadline) {
+                return;
+            }
+            _m_deadline_misses++;
+            if (_m_record_logger) {
+                _m_record_logger->log(typed_record{__switchboard_deadline_miss_header,
+                    _m_plugin_id,
+                    _m_topic_name,
+                    iteration_no,
+                    std::chrono::nanoseconds{_m_deadline},
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(done - (enqueued + _m_deadline)),
+                });
+            }
+        }
+
+        void log_latency() {
+            if (!_m_record_logger) {
+                return;
+            }
+            auto log = [this](const char* metric, const latency_histogram& histogram) {
+                latency_histogram::snapshot stats = histogram.get_snapshot();
+                _m_record_logger->log(record{__switchboard_latency_header, {
+                    {_m_plugin_id},
+                    {_m_topic_name},
+                    {std::string{metric}},
+                    {std::size_t{stats.count()}},
+                    {stats.percentile(0.5)},
+                    {stats.percentile(0.9)},
+                    {stats.percentile(0.99)},
+                    {stats.percentile(0.999)},
+                    {stats.max()},
+                }});
+            };
+            log("queue_delay", _m_queue_delay);
+            log("callback_duration", _m_callback_duration);
+            log("inter_arrival", _m_inter_arrival);
+        }
+
+        /**
+         * @brief Records how long a callback started at @p start took, and logs the histograms when due.
+         */
+        std::chrono::steady_clock::time_point callback_done(std::chrono::steady_clock::time_point start) {
+            auto done = std::chrono::steady_clock::now();
+            _m_callback_duration.record(done - start);
+            if (done - _m_last_latency_log >= _m_latency_log_period) {
+                _m_last_latency_log = done;
+                log_latency();
+            }
+            return done;
+        }
+
+        /**
+         * @brief Runs the callback on @p this_event, recording and logging the time.
+         */
+        void process(queued_event&& this_event) {
+            _m_dequeued++;
+            _m_last_enqueued = this_event.enqueued;
+            // Only measured if it gets logged
+            std::chrono::nanoseconds cb_start_cpu_time {};
+            std::chrono::high_resolution_clock::time_point cb_start_wall_time;
+            if (_m_cb_log) {
+                cb_start_cpu_time  = thread_cpu_time();
+                cb_start_wall_time = std::chrono::high_resolution_clock::now();
+            }
+            auto cb_start = std::chrono::steady_clock::now();
+            _m_queue_delay.record(cb_start - _m_last_enqueued);
+            // std::cerr << "deq " << ptr_to_str(reinterpret_cast<const void*>(this_event.get_ro())) << " " << this_event.use_count() << " v\n";
+            _m_callback(std::move(this_event.value), _m_dequeued);
+            auto done = callback_done(cb_start);
+            if (_m_deadline.count() != 0) {
+                check_deadline(_m_last_enqueued, done, _m_dequeued);
+            }
+            if (_m_cb_log) {
+                _m_cb_log.log(
+                    _m_plugin_id,
+                    _m_topic_name,
+                    _m_dequeued,
+                    cb_start_cpu_time,
+                    thread_cpu_time(),
+                    cb_start_wall_time,
+                    std::chrono::high_resolution_clock::now(),
+                    std::size_t{1}
+                );
+            }
+        }
+
+        /**
+         * @brief Runs the batch callback on the events in `_m_batch`, recording and logging the time.
+         */
+        void process_batch() {
+            std::size_t batch_size = _m_batch.size();
+            _m_dequeued += batch_size;
+            _m_batches++;
+            std::chrono::nanoseconds cb_start_cpu_time {};
+            std::chrono::high_resolution_clock::time_point cb_start_wall_time;
+            if (_m_cb_log) {
+                cb_start_cpu_time  = thread_cpu_time();
+                cb_start_wall_time = std::chrono::high_resolution_clock::now();
+            }
+            auto cb_start = std::chrono::steady_clock::now();
+            for (const queued_event& this_event : _m_batch) {
+                _m_queue_delay.record(cb_start - this_event.enqueued);
+            }
+            _m_last_enqueued = _m_batch.back().enqueued;
+            _m_batch_callback(_m_batch, _m_batches);
+            auto done = callback_done(cb_start);
+            if (_m_deadline.count() != 0) {
+                for (const queued_event& this_event : _m_batch) {
+                    check_deadline(this_event.enqueued, done, _m_batches);
+                }
+            }
+            _m_batch.clear();
+            if (_m_cb_log) {
+                _m_cb_log.log(
+                    _m_plugin_id,
+                    _m_topic_name,
+                    _m_batches,
+                    cb_start_cpu_time,
+                    thread_cpu_time(),
+                    cb_start_wall_time,
+                    std::chrono::high_resolution_clock::now(),
+                    batch_size
+                );
+            }
+        }
+
+        /**
+         * @brief Tells the clock that @p count events were processed or discarded.
+         */
+        void work_done(std::size_t count = 1) {
+            if (_m_work_tracker) {
+                _m_work_tracker->release(count);
+            }
+        }
 
-        // This needs to be last,
-        // so it is destructed before the data it uses.
-        managed_thread _m_thread;
+        /**
+         * @brief Bookkeeping after taking @p count events off the queue (to process or to discard).
+         */
+        void dequeued(std::size_t count = 1) {
+            _m_queued -= count;
+            if (_m_capacity && _m_policy == overflow_policy::block) {
+                _m_space.signal(static_cast<moodycamel::LightweightSemaphore::ssize_t>(count));
+            }
+        }
 
-        void thread_on_start() {
-#ifndef NDEBUG
-            std::cerr << "Thread " << std::this_thread::get_id() << " start" << std::endl;
-#endif
+        /**
+         * @brief Waits for a batch: up to `_m_max_batch` events, or as many as arrive within
+         * `_m_batch_window` of the first one.
+         */
+        void thread_body_batch() {
+            _m_batch.resize(_m_max_batch);
+            std::size_t count = _m_queue.wait_dequeue_bulk(_m_ctok, _m_batch.begin(), _m_max_batch);
+            if (_m_batch[count - 1].value && _m_batch_window.count() != 0) {
+                auto deadline = std::chrono::steady_clock::now() + _m_batch_window;
+                while (count < _m_max_batch) {
+                    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+                    if (remaining.count() <= 0) {
+                        break;
+                    }
+                    std::size_t more = _m_queue.wait_dequeue_bulk_timed(_m_ctok, _m_batch.begin() + count, _m_max_batch - count, remaining.count());
+                    count += more;
+                    if (more != 0 && !_m_batch[count - 1].value) {
+                        break;
+                    }
+                }
+            }
+            // The stop signal can only be the last event.
+            if (!_m_batch[count - 1].value) {
+                count--;
+            }
+            _m_batch.resize(count);
+            if (count != 0) {
+                dequeued(count);
+                process_batch();
+                work_done(count);
+            }
         }
 
         void thread_body() {
-            // Try to pull event off of queue
-            ptr<const event> this_event;
-            std::int64_t timeout_usecs = std::chrono::duration_cast<std::chrono::microseconds>(_m_queue_timeout).count();
-            // Note the use of timed blocking wait
-            if (_m_queue.wait_dequeue_timed(_m_ctok, this_event, timeout_usecs)) {
-                // Process event
-                // Also, record and log the time
-                _m_dequeued++;
-                auto cb_start_cpu_time  = thread_cpu_time();
-                auto cb_start_wall_time = std::chrono::high_resolution_clock::now();
-                // std::cerr << "deq " << ptr_to_str(reinterpret_cast<const void*>(this_event.get_ro())) << " " << this_event.use_count() << " v\n";
-                _m_callback(std::move(this_event), _m_dequeued);
-                if (_m_cb_log) {
-                    _m_cb_log.log(record{__switchboard_callback_header, {
-                        {_m_plugin_id},
-                        {_m_topic_name},
-                        {_m_dequeued},
-                        {cb_start_cpu_time},
-                        {thread_cpu_time()},
-                        {cb_start_wall_time},
-                        {std::chrono::high_resolution_clock::now()},
-                    }});
+            if (_m_batch_callback) {
+                thread_body_batch();
+                return;
+            }
+            // Sleep until there is an event (or the stop signal)
+            queued_event this_event;
+            _m_queue.wait_dequeue(_m_ctok, this_event);
+            if (this_event.value) {
+                dequeued();
+                process(std::move(this_event));
+                work_done();
+            }
+        }
+
+        /**
+         * @brief Runs the callback on @p this_event in the publisher's thread.
+         *
+         * Callbacks from concurrent publishers are serialized by `_m_inline_lock`. A callback which
+         * publishes back to this subscription (directly, or through other inline subscriptions)
+         * would recurse into itself; instead, that event is set aside and processed once the
+         * callback returns, so events are still handled one at a time and in order.
+         *
+         * A thread already in an inline callback never waits for the lock either: the holder could
+         * be in a callback publishing to the one this thread is in, and both would wait forever.
+         * The event is set aside for the holder, so it may run on that thread.
+         */
+        void run_inline(queued_event&& this_event) {
+            const std::thread::id this_thread = std::this_thread::get_id();
+            if (_m_inline_owner.load() == this_thread) {
+                set_aside_inline(std::move(this_event));
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock {_m_inline_lock, std::defer_lock};
+            bool set_aside = false;
+            if (inline_depth() == 0) {
+                lock.lock();
+            } else if (!lock.try_lock()) {
+                set_aside_inline(std::move(this_event));
+                set_aside = true;
+                // The holder may have looked for set-aside events for the last time before ours
+                // arrived, and released the lock since; then nobody else would process it.
+                if (!lock.try_lock()) {
+                    return;
                 }
-            } else {
-                // Nothing to do.
-                _m_idle_cycles++;
             }
+
+            _m_inline_owner.store(this_thread);
+            if (!set_aside) {
+                process_inline(std::move(this_event));
+            }
+            for (;;) {
+                queued_event nested;
+                while (take_inline(nested)) {
+                    process_inline(std::move(nested));
+                }
+                _m_inline_owner.store(std::thread::id{});
+                lock.unlock();
+                // Same as above, from this side: an event set aside while we held the lock.
+                if (!has_inline_pending() || !lock.try_lock()) {
+                    return;
+                }
+                _m_inline_owner.store(this_thread);
+            }
+        }
+
+        /// How many inline callbacks this thread is in
+        static std::size_t& inline_depth() {
+            static thread_local std::size_t depth = 0;
+            return depth;
+        }
+
+        void process_inline(queued_event&& this_event) {
+            ++inline_depth();
+            process(std::move(this_event));
+            --inline_depth();
+        }
+
+        void set_aside_inline(queued_event&& this_event) {
+            const std::lock_guard<std::mutex> lock {_m_inline_pending_lock};
+            _m_inline_pending.push_back(std::move(this_event));
+        }
+
+        bool take_inline(queued_event& this_event) {
+            const std::lock_guard<std::mutex> lock {_m_inline_pending_lock};
+            if (_m_inline_pending.empty()) {
+                return false;
+            }
+            this_event = std::move(_m_inline_pending.front());
+            _m_inline_pending.pop_front();
+            return true;
         }
 
+        bool has_inline_pending() {
+            const std::lock_guard<std::mutex> lock {_m_inline_pending_lock};
+            return !_m_inline_pending.empty();
+        }
 
         void thread_on_stop() {
             // Drain queue
-            std::size_t unprocessed = _m_enqueued - _m_dequeued;
+            std::size_t unprocessed = 0;
             {
-                ptr<const event> this_event;
-                for (std::size_t i = 0; i < unprocessed; ++i) {
-                    [[maybe_unused]] bool ret = _m_queue.try_dequeue(_m_ctok, this_event);
-                    assert(ret);
+                queued_event this_event;
+                while (_m_queue.try_dequeue(_m_ctok, this_event)) {
                     // std::cerr << "deq (stopping) " << ptr_to_str(reinterpret_cast<const void*>(this_event.get_ro())) << " " << this_event.use_count() << " v\n";
-                    this_event.reset();
+                    if (!this_event.value) {
+                        // The stop signal
+                        continue;
+                    }
+                    dequeued();
+                    this_event.value.reset();
+                    work_done();
+                    unprocessed++;
                 }
             }
+            log_stop(unprocessed);
+        }
 
+        void log_stop(std::size_t unprocessed) {
+            log_latency();
             // Log stats
             if (_m_record_logger) {
                 _m_record_logger->log(record{__switchboard_topic_stop_header, {
@@ -227,33 +1518,211 @@ private:
                     {_m_topic_name},
                     {_m_dequeued},
                     {unprocessed},
-                    {_m_idle_cycles},
+                    {_m_dropped.load()},
+                    {_m_deadline_misses},
                 }});
             }
         }
 
-    public:
-        topic_subscription(const std::string& topic_name, plugin_id_t plugin_id, std::function<void(ptr<const event>&&, std::size_t)> callback, std::shared_ptr<record_logger> record_logger_)
+        topic_subscription(const std::string& topic_name, plugin_id_t plugin_id,
+                           std::function<void(ptr<const event>&&, std::size_t)> callback,
+                           std::function<void(std::vector<queued_event>&, std::size_t)> batch_callback,
+                           std::size_t max_batch, std::chrono::microseconds batch_window,
+                           std::shared_ptr<record_logger> record_logger_, std::shared_ptr<record_flusher> record_flusher_, work_stealing_executor* executor,
+                           const thread_placement* placement, const clock_backend* work_tracker, qos qos_)
             : _m_topic_name{topic_name}
             , _m_plugin_id{plugin_id}
             , _m_callback{callback}
+            , _m_batch_callback{batch_callback}
+            , _m_max_batch{max_batch}
+            , _m_batch_window{batch_window}
             , _m_record_logger{record_logger_}
-            , _m_cb_log{record_logger_}
-            , _m_thread{[this]{this->thread_body();}, [this]{this->thread_on_start();}, [this]{this->thread_on_stop();}}
+            , _m_cb_log{record_logger_, __switchboard_callback_header, record_flusher_}
+            , _m_policy{qos_.policy}
+            , _m_capacity{qos_.policy == overflow_policy::keep_latest ? 1 : qos_.capacity}
+            , _m_space{static_cast<moodycamel::LightweightSemaphore::ssize_t>(_m_capacity)}
+            , _m_deadline{qos_.deadline}
+            , _m_executor{qos_.dispatch_mode == dispatch::queued ? executor : nullptr}
+            , _m_inline{qos_.dispatch_mode == dispatch::inline_publisher}
+            , _m_placement{placement}
+            , _m_work_tracker{work_tracker}
+            // Without a body, the managed_thread is nonstartable.
+            , _m_thread{_m_executor || _m_inline ? std::function<void()>{} : [this]{this->thread_body();}, [this]{this->thread_on_start();}, [this]{this->thread_on_stop();}}
         {
-            _m_thread.start();
+            assert(_m_max_batch > 0);
+            if (_m_inline && _m_batch_callback) {
+                throw std::invalid_argument{"switchboard: batched subscriptions cannot be inline"};
+            }
+            _m_batch.reserve(_m_max_batch);
+            if (!_m_executor && !_m_inline) {
+                _m_thread.start();
+            }
+        }
+
+    public:
+        topic_subscription(const std::string& topic_name, plugin_id_t plugin_id, std::function<void(ptr<const event>&&, std::size_t)> callback, std::shared_ptr<record_logger> record_logger_, std::shared_ptr<record_flusher> record_flusher_, work_stealing_executor* executor, const thread_placement* placement, const clock_backend* work_tracker, qos qos_)
+            : topic_subscription{topic_name, plugin_id, callback, {}, 1, {}, record_logger_, record_flusher_, executor, placement, work_tracker, qos_}
+        { }
+
+        topic_subscription(const std::string& topic_name, plugin_id_t plugin_id, std::function<void(std::vector<queued_event>&, std::size_t)> batch_callback, std::size_t max_batch, std::chrono::microseconds batch_window, std::shared_ptr<record_logger> record_logger_, std::shared_ptr<record_flusher> record_flusher_, work_stealing_executor* executor, const thread_placement* placement, const clock_backend* work_tracker, qos qos_)
+            : topic_subscription{topic_name, plugin_id, {}, batch_callback, max_batch, batch_window, record_logger_, record_flusher_, executor, placement, work_tracker, qos_}
+        { }
+
+        ~topic_subscription() override {
+            if (_m_inline) {
+                // No put() can reach us anymore (see topic::stop()), so no callback is running.
+                log_stop(0);
+            } else if (_m_executor) {
+                // Discard whatever is still queued, and wait for the worker (if any) to let go of us.
+                _m_stopping.store(true);
+                while (_m_pending.load() != 0) {
+                    std::this_thread::yield();
+                }
+                // The queue is empty now; run() counted what it discarded.
+                log_stop(_m_discarded);
+            } else if (_m_thread.get_state() == managed_thread::state::running) {
+                // Wake the thread up so that it sees the request, instead of waiting for an event.
+                _m_thread.request_stop();
+                [[maybe_unused]] bool ret = _m_queue.enqueue(queued_event{});
+                assert(ret);
+                _m_thread.stop();
+            }
+        }
+
+        /**
+         * @brief Processes a quantum of events on an executor worker.
+         *
+         * Only runs when submitted by `enqueue()`, so never concurrently with itself.
+         */
+        void run() override {
+            if (_m_batch_callback) {
+                run_batch();
+                return;
+            }
+            for (std::size_t i = 0; i < _m_executor_quantum; ++i) {
+                queued_event this_event;
+                // The event counted in _m_pending is already in the queue, so this does not block;
+                // if it takes a moment to be found, the queue's semaphore spins only briefly and then sleeps.
+                _m_queue.wait_dequeue(_m_ctok, this_event);
+                dequeued();
+                if (!_m_stopping.load()) {
+                    process(std::move(this_event));
+                } else {
+                    _m_discarded++;
+                }
+                work_done();
+                if (_m_pending.fetch_sub(1) == 1) {
+                    // Nothing left; the next enqueue will submit us again.
+                    // `this` may be destructed from here on.
+                    return;
+                }
+            }
+            // Let other subscriptions have the worker.
+            _m_executor->submit(this, deadline_of(_m_last_enqueued));
+        }
+
+        /**
+         * @brief Processes one batch on an executor worker.
+         *
+         * A worker cannot afford to wait for the batch window, so the batch is whatever is pending.
+         */
+        void run_batch() {
+            std::size_t count = std::min(_m_pending.load(), _m_max_batch);
+            _m_batch.resize(count);
+            // As in run(), the pending events are in the queue, but may take a moment to be found.
+            for (std::size_t got = 0; got < count; ) {
+                got += _m_queue.wait_dequeue_bulk(_m_ctok, _m_batch.begin() + got, count - got);
+            }
+            dequeued(count);
+            if (!_m_stopping.load()) {
+                process_batch();
+            } else {
+                _m_discarded += count;
+                _m_batch.clear();
+            }
+            work_done(count);
+            if (_m_pending.fetch_sub(count) == count) {
+                // `this` may be destructed from here on.
+                return;
+            }
+            _m_executor->submit(this, deadline_of(_m_last_enqueued));
+        }
+
+        latency_stats get_latency_stats() const {
+            return latency_stats{
+                _m_plugin_id,
+                _m_queue_delay.get_snapshot(),
+                _m_callback_duration.get_snapshot(),
+                _m_inter_arrival.get_snapshot(),
+            };
         }
 
         /**
-         * @brief Tells the subscriber about @p this_event
+         * @brief Tells the subscriber about @p this_event, which was published at @p published
          *
          * Thread-safe
+         *
+         * With the `block` policy, this waits until the subscriber has room. An inline subscription
+         * runs the callback before this returns.
          */
-        void enqueue(ptr<const event>&& this_event) {
-            if (_m_thread.get_state() == managed_thread::state::running) {
-                [[maybe_unused]] bool ret = _m_queue.enqueue(std::move(this_event));
-                assert(ret);
-                _m_enqueued++;
+        void enqueue(ptr<const event>&& this_event, std::chrono::steady_clock::time_point published) {
+            if (!_m_inline && (_m_executor ? _m_stopping.load() : _m_thread.get_state() != managed_thread::state::running)) {
+                return;
+            }
+
+            std::int64_t arrival = std::chrono::duration_cast<std::chrono::nanoseconds>(published.time_since_epoch()).count();
+            std::int64_t last_arrival = _m_last_arrival.exchange(arrival);
+            if (last_arrival != 0) {
+                _m_inter_arrival.record(std::chrono::nanoseconds{arrival - last_arrival});
+            }
+
+            if (_m_inline) {
+                run_inline(queued_event{std::move(this_event), published});
+                return;
+            }
+
+            if (_m_capacity) {
+                if (_m_policy == overflow_policy::block) {
+                    _m_space.wait();
+                } else if (_m_policy == overflow_policy::drop_newest && _m_queued.load() >= _m_capacity) {
+                    _m_dropped++;
+                    return;
+                }
+            }
+
+            if (_m_work_tracker) {
+                _m_work_tracker->hold();
+            }
+
+            bool evicted = false;
+            std::unique_lock<std::mutex> evict_lock;
+            if (_m_capacity && (_m_policy == overflow_policy::drop_oldest || _m_policy == overflow_policy::keep_latest)) {
+                // Evict before enqueueing, so the event evicted is never this one. `_m_queued`
+                // excludes events the consumer has already taken, so this never evicts more than
+                // needed; the lock keeps other publishers from filling the room in between.
+                evict_lock = std::unique_lock<std::mutex>{_m_evict_lock};
+                if (_m_queued.load() >= _m_capacity) {
+                    queued_event stale_event;
+                    if (_m_queue.try_dequeue(stale_event)) {
+                        dequeued();
+                        work_done();
+                        _m_dropped++;
+                        evicted = true;
+                    }
+                }
+            }
+
+            // Count before enqueueing, so the consumer never decrements below zero.
+            _m_queued++;
+            [[maybe_unused]] bool ret = _m_queue.enqueue(queued_event{std::move(this_event), published});
+            assert(ret);
+            _m_enqueued++;
+            if (evict_lock) {
+                evict_lock.unlock();
+            }
+
+            if (_m_executor && !evicted && _m_pending.fetch_add(1) == 0) {
+                _m_executor->submit(this, deadline_of(published));
             }
         }
     };
@@ -277,74 +1746,119 @@ private:
         const std::string _m_name;
         const std::type_info& _m_ty;
         const std::shared_ptr<record_logger> _m_record_logger;
-		std::atomic<size_t> _m_latest_index;
-		static constexpr std::size_t _m_latest_buffer_size = 256;
-		std::array<ptr<const event>, _m_latest_buffer_size> _m_latest_buffer;
+        const std::shared_ptr<record_flusher> _m_record_flusher;
+        latest_slot<ptr<const event>> _m_latest;
+        event_history _m_history;
+        static constexpr std::size_t _m_pool_capacity = 256;
+        event_pool* const _m_pool;
+        work_stealing_executor* const _m_executor;
+        const thread_placement* const _m_placement;
+        const clock_backend* const _m_work_tracker;
+        // Owns the subscriptions; changes are serialized by _m_subscriptions_lock.
         std::list<topic_subscription> _m_subscriptions;
         std::shared_mutex _m_subscriptions_lock;
+        // What put() fans out to, without locking
+        rcu_snapshot<std::vector<topic_subscription*>> _m_subscribers {std::make_unique<const std::vector<topic_subscription*>>()};
+
+        /**
+         * @brief Publishes the current _m_subscriptions to put(). Requires unique state on _m_subscriptions_lock.
+         */
+        void publish_subscribers() {
+            auto subscribers = std::make_unique<std::vector<topic_subscription*>>();
+            for (topic_subscription& ts : _m_subscriptions) {
+                subscribers->push_back(&ts);
+            }
+            _m_subscribers.replace(std::move(subscribers));
+        }
 
     public:
         topic(
             std::string name,
             const std::type_info& ty,
-            std::shared_ptr<record_logger> record_logger_
+            std::size_t event_size,
+            std::shared_ptr<record_logger> record_logger_,
+            std::shared_ptr<record_flusher> record_flusher_,
+            work_stealing_executor* executor,
+            const thread_placement* placement,
+            const clock_backend* work_tracker
         )   : _m_name{name}
             , _m_ty{ty}
             , _m_record_logger{record_logger_}
-			, _m_latest_index{0}
+            , _m_record_flusher{record_flusher_}
+            , _m_pool{new event_pool{event_size, _m_pool_capacity}}
+            , _m_executor{executor}
+            , _m_placement{placement}
+            , _m_work_tracker{work_tracker}
         { }
 
+        topic(const topic&) = delete;
+        topic& operator=(const topic&) = delete;
+
+        ~topic() {
+            _m_pool->unref();
+        }
+
         const std::string& name() { return _m_name; }
 
         const std::type_info& ty() { return _m_ty; }
 
+        /**
+         * @brief The pool from which writers of this topic allocate events.
+         */
+        event_pool* pool() const { return _m_pool; }
+
         /**
          * @brief Gets a read-only copy of the most recent event on the topic.
          */
         ptr<const event> get() const {
-			size_t idx = _m_latest_index.load() % _m_latest_buffer_size;
-			ptr<const event> this_event = _m_latest_buffer[idx];
-			// if (this_event) {
-			// 	std::cerr << "get " << ptr_to_str(reinterpret_cast<const void*>(this_event.get())) << " " << this_event.use_count() << "v \n";
-			// }
-			return this_event;
+            return _m_latest.load();
         }
 
         /**
-         * @brief Publishes @p this_event to the topic
-         *
-         * Thread-safe
-         * - Caveat:
+         * @brief Like `get()`, but as a @p specific_event, which must be this topic's type.
          *
-         *   This (circular) queue based solution may race if >= N write attempts
-         *       to the N-sized queue interrupt a concurrent reader (using 'get').
-         *
-         *   The reader's critical section is as follows:
-         *   1. Read the latest serial number
-         *   2. Compute the serial's modulus
-         *   3. Dereference and access the position in the queue/array
+         * A `static_cast`, taken in the same copy as the load, so it costs no more than `get()`.
+         */
+        template <typename specific_event>
+        ptr<const specific_event> get_as() const {
+            assert(typeid(specific_event) == _m_ty);
+            return _m_latest.load_as([](const ptr<const event>& this_event) {
+                return static_pointer_cast<const specific_event>(this_event);
+            });
+        }
+
+        /**
+         * @brief The time-indexed history of the topic (disabled unless configured).
+         */
+        event_history& history() { return _m_history; }
+
+        /**
+         * @brief Publishes @p this_event to the topic
          *
-         *   The critical section is extremely small, so a race is unlikely, albeit possible.
-         *   The probability of a data race decreases geometrically with N.
+         * Thread-safe and lock-free, unless a subscriber's queue is full and its policy is `block`.
          */
         void put(ptr<const event>&& this_event) {
-			assert(this_event != nullptr);
-			assert(this_event.unique() || this_event.use_count() <= 2);  /// <-- TODO: Revisit for solution that guarantees uniqueness
+            assert(this_event != nullptr);
 
-			/* The pointer that this gets exchanged with needs to get dropped. */
-			size_t index = (_m_latest_index.load() + 1) % _m_latest_buffer_size;
-			_m_latest_buffer[index] = this_event;
-			_m_latest_index++;
+            _m_history.push(this_event);
 
-            // Read/write on _m_subscriptions.
-            // Must acquire shared state on _m_subscriptions_lock
-            std::unique_lock lock{_m_subscriptions_lock};
-            for (topic_subscription& ts : _m_subscriptions) {
-                // std::cerr << "enq " << ptr_to_str(reinterpret_cast<const void*>(this_event->get())) << " " << this_event->use_count() << " ^\n";
-                ptr<const event> event_ptr_copy {this_event};
-                ts.enqueue(std::move(event_ptr_copy));
+            // Concurrent publishers each enqueue on their own; subscriptions outlive this snapshot.
+            const auto subscribers = _m_subscribers.read();
+            if (subscribers->empty()) {
+                _m_latest.store(std::move(this_event));
+                return;
+            }
+
+            // The latest value and all but the last subscriber get references counted in one
+            // atomic add; the last subscriber gets ours.
+            const event* const raw_event = this_event.get();
+            this_event.add_refs(static_cast<std::uint32_t>(subscribers->size()));
+            _m_latest.store(ptr<const event>::adopt(raw_event));
+            auto published = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i + 1 < subscribers->size(); ++i) {
+                (*subscribers)[i]->enqueue(ptr<const event>::adopt(raw_event), published);
             }
-            // std::cerr << "put done " << ptr_to_str(reinterpret_cast<const void*>(this_event->get())) << " " << this_event->use_count() << " (= 1 + len(sub)) \n";
+            subscribers->back()->enqueue(std::move(this_event), published);
         }
 
         /**
@@ -354,12 +1868,45 @@ private:
          */
         void schedule(
             plugin_id_t plugin_id,
-            std::function<void(ptr<const event>&&, std::size_t)> callback)
+            std::function<void(ptr<const event>&&, std::size_t)> callback,
+            qos qos_)
         {
             // Write on _m_subscriptions.
             // Must acquire unique state on _m_subscriptions_lock
             const std::unique_lock lock{_m_subscriptions_lock};
-            _m_subscriptions.emplace_back(_m_name, plugin_id, callback, _m_record_logger);
+            _m_subscriptions.emplace_back(_m_name, plugin_id, callback, _m_record_logger, _m_record_flusher, _m_executor, _m_placement, _m_work_tracker, qos_);
+            publish_subscribers();
+        }
+
+        /**
+         * @brief Add a batched subscription (see `switchboard::schedule_batch`).
+         *
+         * Thread-safe
+         */
+        void schedule_batch(
+            plugin_id_t plugin_id,
+            std::function<void(std::vector<queued_event>&, std::size_t)> callback,
+            std::size_t max_batch,
+            std::chrono::microseconds batch_window,
+            qos qos_)
+        {
+            const std::unique_lock lock{_m_subscriptions_lock};
+            _m_subscriptions.emplace_back(_m_name, plugin_id, callback, max_batch, batch_window, _m_record_logger, _m_record_flusher, _m_executor, _m_placement, _m_work_tracker, qos_);
+            publish_subscribers();
+        }
+
+        /**
+         * @brief The latency histograms of each subscription.
+         *
+         * Thread-safe
+         */
+        std::vector<latency_stats> get_latency_stats() {
+            const std::shared_lock lock{_m_subscriptions_lock};
+            std::vector<latency_stats> stats;
+            for (const topic_subscription& ts : _m_subscriptions) {
+                stats.push_back(ts.get_latency_stats());
+            }
+            return stats;
         }
 
         /**
@@ -368,10 +1915,30 @@ private:
          * Thread-safe
          */
         void stop() {
-            // Write on _m_subscriptions.
-            // Must acquire unique state on _m_subscriptions_lock
-            const std::unique_lock lock{_m_subscriptions_lock};
-            _m_subscriptions.clear();
+            std::list<topic_subscription> stopped;
+            {
+                // Write on _m_subscriptions.
+                // Must acquire unique state on _m_subscriptions_lock
+                const std::unique_lock lock{_m_subscriptions_lock};
+                _m_subscribers.replace(std::make_unique<const std::vector<topic_subscription*>>());
+                stopped.splice(stopped.end(), _m_subscriptions);
+            }
+            // Once no put() can see them, the subscriptions can go. This waits without the lock,
+            // since a put() may be waiting for a callback which calls schedule().
+            _m_subscribers.synchronize();
+            stopped.clear();
+
+            // Log stats
+            if (_m_record_logger) {
+                pool_stats stats = _m_pool->get_stats();
+                _m_record_logger->log(record{__switchboard_topic_pool_header, {
+                    {_m_name},
+                    {stats.block_size},
+                    {stats.hits},
+                    {stats.misses},
+                    {stats.free_blocks},
+                }});
+            }
         }
     };
 
@@ -387,33 +1954,22 @@ public:
         topic& _m_topic;
 
     public:
+        /// The type of @p topic_ must be @p specific_event (`get_reader()` checks it).
         reader(topic& topic_)
             : _m_topic{topic_}
         {
-#ifndef NDEBUG
-            if (typeid(specific_event) != _m_topic.ty()) {
-                std::cerr << "topic '" << _m_topic.name() << "' holds type " << _m_topic.ty().name()
-                          << ", but caller used type" << typeid(specific_event).name() << std::endl;
-                abort();
-            }
-#endif
+            assert(typeid(specific_event) == _m_topic.ty());
         }
 
        /**
         * @brief Gets a "read-only" copy of the latest value.
         *
         * This will return null if no event is on the topic yet.
+        *
+        * The type was checked when this reader was made, so this is a static cast, not an RTTI lookup.
         */
        ptr<const specific_event> get_ro_nullable() const noexcept {
-           ptr<const event> this_event = _m_topic.get();
-           ptr<const specific_event> this_specific_event = std::dynamic_pointer_cast<const specific_event>(this_event);
-
-           if (this_event != nullptr) {
-			   assert(this_specific_event /* Otherwise, dynamic cast failed; dynamic type information could be wrong*/);
-               return this_specific_event;
-           } else {
-               return ptr<const specific_event>{nullptr};
-           }
+           return _m_topic.template get_as<specific_event>();
        }
 
        /**
@@ -432,17 +1988,73 @@ public:
         }
 
        /**
-        * @brief Gets a non-null mutable copy of the latest value.
+        * @brief Gets a non-null mutable (copy-on-write) handle on the latest value.
+        *
+        * Nothing is copied until the handle is first mutated, and not even then if the topic has
+        * moved on and nobody else holds the event anymore (see `cow_ptr`).
         *
         * @throws `runtime_error` If no event is on the topic yet.
         */
-        ptr<specific_event> get_rw() const {
-            /*
-              This method is currently not more efficient than calling get_ro() and making a copy,
-              but in the future it could be.
-             */
-            ptr<const specific_event> this_specific_event = get_ro();
-            return std::make_shared<specific_event>(*this_specific_event);
+        cow_ptr<specific_event> get_rw() const {
+            return cow_ptr<specific_event>{get_ro()};
+        }
+
+        /**
+         * @brief Makes the topic remember its last @p length events, indexed by @p time_of.
+         *
+         * Call this before the events of interest are published. The history holds on to the
+         * events, so keep @p length as small as the queries allow, or pass @p remember to keep a
+         * lighter copy of each event instead (e.g. without its images). Every reader of a topic
+         * must pass the same @p time_of and @p remember; only the first reader's are used.
+         */
+        void keep_history(std::size_t length, std::function<time_point(const specific_event&)> time_of,
+                          std::function<ptr<const specific_event>(const specific_event&)> remember = {}) {
+            event_history::remember_fn remember_event;
+            if (remember) {
+                remember_event = [remember](const event& this_event) -> ptr<const event> {
+                    return remember(static_cast<const specific_event&>(this_event));
+                };
+            }
+            _m_topic.history().configure(length, [time_of](const event& this_event) {
+                return time_of(static_cast<const specific_event&>(this_event));
+            }, std::move(remember_event));
+        }
+
+        /**
+         * @brief Gets the remembered events with @p begin <= time <= @p end, oldest first.
+         *
+         * Requires `keep_history()`. The events are shared, not copied.
+         */
+        std::vector<ptr<const specific_event>> get_range(time_point begin, time_point end) const {
+            assert(_m_topic.history().enabled());
+            std::vector<ptr<const event>> events = _m_topic.history().range(begin, end);
+            std::vector<ptr<const specific_event>> specific_events;
+            specific_events.reserve(events.size());
+            for (ptr<const event>& this_event : events) {
+                // The constructor checked the topic's type
+                specific_events.push_back(static_pointer_cast<const specific_event>(std::move(this_event)));
+            }
+            return specific_events;
+        }
+
+        /**
+         * @brief Gets the last remembered event with time < @p time, or null.
+         *
+         * Requires `keep_history()`.
+         */
+        ptr<const specific_event> get_latest_before(time_point time) const {
+            assert(_m_topic.history().enabled());
+            return static_pointer_cast<const specific_event>(_m_topic.history().latest_before(time));
+        }
+
+        /**
+         * @brief Gets the first remembered event with time > @p time, or null.
+         *
+         * Requires `keep_history()`.
+         */
+        ptr<const specific_event> get_earliest_after(time_point time) const {
+            assert(_m_topic.history().enabled());
+            return static_pointer_cast<const specific_event>(_m_topic.history().earliest_after(time));
         }
     };
 
@@ -455,25 +2067,51 @@ public:
         // Reference to the underlying topic
         topic& _m_topic;
 
+        // Owned by the topic, which outlives this handle
+        event_pool* _m_pool;
+
     public:
         writer(topic& topic_)
             : _m_topic{topic_}
+            , _m_pool{topic_.pool()}
         { }
 
         /**
          * @brief Like `new`/`malloc` but more efficient for this specific case.
          *
-         * There is an optimization available which has not yet been implemented: switchboard can reuse memory
-         * from old events, like a [slab allocator][1]. Suppose module A publishes data for module
-         * B. B's deallocation through the destructor, and A's allocation through this method completes
-         * the cycle in a [double-buffer (AKA swap-chain)][2].
+         * Switchboard reuses memory from old events, like a [slab allocator][1]. Suppose module A
+         * publishes data for module B. B's deallocation through the destructor, and A's allocation
+         * through this method completes the cycle in a [double-buffer (AKA swap-chain)][2]. The
+         * reference count lives in the event, so steady-state publishing does not touch the heap.
+         * Over-aligned types bypass the pool.
          *
          * [1]: https://en.wikipedia.org/wiki/Slab_allocation
          * [2]: https://en.wikipedia.org/wiki/Multiple_buffering
          */
 		template<class... Args>
         ptr<specific_event> allocate(Args&&... args) {
-			return std::make_shared<specific_event>(std::forward<Args>(args)...);
+            if constexpr (alignof(specific_event) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                return make_ptr<specific_event>(std::forward<Args>(args)...);
+            } else {
+                void* block = _m_pool->acquire();
+                specific_event* this_event;
+                try {
+                    this_event = new (block) specific_event(std::forward<Args>(args)...);
+                } catch (...) {
+                    _m_pool->release(block);
+                    throw;
+                }
+                static_cast<event*>(this_event)->_m_ownership.pool = _m_pool;
+                ptr<specific_event>::refs(this_event).store(1, std::memory_order_relaxed);
+                return ptr<specific_event>::adopt(this_event);
+            }
+        }
+
+        /**
+         * @brief Gets the hit rate and size of this topic's event pool.
+         */
+        pool_stats get_pool_stats() const {
+            return _m_pool->get_stats();
         }
 
         /**
@@ -482,17 +2120,21 @@ public:
 		void put(ptr<specific_event>&& this_specific_event) {
 			assert(typeid(specific_event) == _m_topic.ty());
 			assert(this_specific_event != nullptr);
-			assert(this_specific_event.unique());
-			ptr<const event> this_event = std::const_pointer_cast<const event>(std::static_pointer_cast<event>(std::move(this_specific_event)));
-			assert(this_event.unique() || this_event.use_count() <= 2); /// TODO: Revisit for solution that guarantees uniqueness
-			_m_topic.put(std::move(this_event));
+			assert(this_specific_event.use_count() == 1);
+			_m_topic.put(std::move(this_specific_event));
         }
     };
 
 private:
+    std::shared_ptr<const thread_placement> _m_placement;
+    std::shared_ptr<const RelativeClock> _m_clock;
+    // Declared before the registry, so subscriptions are gone before the executor is.
+    std::unique_ptr<work_stealing_executor> _m_executor;
     std::unordered_map<std::string, topic> _m_registry;
     std::shared_mutex _m_registry_lock;
     std::shared_ptr<record_logger> _m_record_logger;
+    // Null unless the phonebook has one; then callbacks are logged through it
+    std::shared_ptr<record_flusher> _m_record_flusher;
 
     template <typename specific_event>
     topic& try_register_topic(const std::string& topic_name) {
@@ -500,54 +2142,111 @@ private:
             const std::shared_lock lock{_m_registry_lock};
             auto found = _m_registry.find(topic_name);
             if (found != _m_registry.end()) {
-                topic& topic_ = found->second;
-#ifndef NDEBUG
-                if (typeid(specific_event) != topic_.ty()) {
-                    std::cerr << "topic '" << topic_name << "' holds type " << topic_.ty().name()
-                              << ", but caller used type" << typeid(specific_event).name()
-                              << std::endl;
-                    abort();
-                }
-#endif
-                return topic_;
+                return check_type<specific_event>(found->second, topic_name);
             }
         }
 
+        // Topic not found. Need to create it here.
+        const std::unique_lock lock{_m_registry_lock};
+        auto [found, created] = _m_registry.try_emplace(topic_name, topic_name, typeid(specific_event), sizeof(specific_event), _m_record_logger, _m_record_flusher, _m_executor.get(), _m_placement.get(),
+                                                        _m_clock ? _m_clock->work_tracker() : nullptr);
+        if (!created) {
+            // Another thread created it since we looked, perhaps with another type.
+            return check_type<specific_event>(found->second, topic_name);
+        }
 #ifndef NDEBUG
         std::cerr << "Creating: " << topic_name << " for " << typeid(specific_event).name() << std::endl;
 #endif
-        // Topic not found. Need to create it here.
-        const std::unique_lock lock{_m_registry_lock};
-        return _m_registry.try_emplace(topic_name, topic_name, typeid(specific_event), _m_record_logger).first->second;
+        return found->second;
+    }
 
+    /// Checked here, once per handle, so that reads can use static casts.
+    template <typename specific_event>
+    static topic& check_type(topic& topic_, const std::string& topic_name) {
+        if (typeid(specific_event) != topic_.ty()) {
+            throw std::runtime_error{"topic '" + topic_name + "' holds type " + topic_.ty().name()
+                                     + ", but caller used type " + typeid(specific_event).name()};
+        }
+        return topic_;
     }
 
 public:
 
     /**
      * If @p pb is null, then logging is disabled.
+     *
+     * If @p executor_threads is 0, every `schedule()` gets its own thread. Otherwise, all callbacks
+     * run on a shared `work_stealing_executor` of that many threads. Either way, the callbacks of
+     * one subscription run one at a time, in order.
+     *
+     * If @p pb has a `thread_placement`, those threads are named and placed by it. If it has a
+     * `RelativeClock` which is virtual, queued events hold its time back until they are processed.
+     * If it has a `record_flusher`, callbacks are logged through it rather than from their threads.
      */
-    switchboard(const phonebook* pb)
-        : _m_record_logger{pb ? pb->lookup_impl<record_logger>() : nullptr}
+    switchboard(const phonebook* pb, std::size_t executor_threads = 0)
+        : _m_placement{pb && pb->has_impl<thread_placement>() ? pb->lookup_impl<thread_placement>() : nullptr}
+        , _m_clock{pb && pb->has_impl<RelativeClock>() ? pb->lookup_impl<RelativeClock>() : nullptr}
+        , _m_executor{executor_threads ? std::make_unique<work_stealing_executor>(executor_threads, [this](std::size_t worker) {
+            if (_m_placement) {
+                _m_placement->apply("sb_worker:" + std::to_string(worker));
+            }
+        }) : nullptr}
+        , _m_record_logger{pb ? pb->lookup_impl<record_logger>() : nullptr}
+        , _m_record_flusher{pb && pb->has_impl<record_flusher>() ? pb->lookup_impl<record_flusher>() : nullptr}
     { }
 
     /**
      * @brief Schedules the callback @p fn every time an event is published to @p topic_name.
      *
-     * Switchboard maintains a threadpool to call @p fn.
+     * Switchboard maintains a threadpool to call @p fn (see the constructor).
      *
-     * This is safe to be called from any thread.
+     * @p qos_ bounds the queue of pending events and says what to do when it is full. By default
+     * it is unbounded. With `dispatch::inline_publisher`, @p fn runs in the publisher's thread
+     * instead; it is still accounted for (histograms, deadline, `switchboard_callback`).
+     *
+     * This is safe to be called from any thread, including from callbacks (which then see events
+     * published after it returns).
      *
      * @throws if topic already exists and its type does not match the @p event.
      */
     template <typename specific_event>
-    void schedule(plugin_id_t plugin_id, std::string topic_name, std::function<void(ptr<const specific_event>&&, std::size_t)> fn) {
+    void schedule(plugin_id_t plugin_id, std::string topic_name, std::function<void(ptr<const specific_event>&&, std::size_t)> fn, qos qos_ = {}) {
         try_register_topic<specific_event>(topic_name).schedule(plugin_id, [=](ptr<const event>&& this_event, std::size_t it_no) {
             assert(this_event);
-            ptr<const specific_event> this_specific_event = std::dynamic_pointer_cast<const specific_event>(std::move(this_event));
-            assert(this_specific_event);
+            // try_register_topic checked the type
+            ptr<const specific_event> this_specific_event = static_pointer_cast<const specific_event>(std::move(this_event));
             fn(std::move(this_specific_event), it_no);
-        });
+        }, qos_);
+    }
+
+    /**
+     * @brief Like `schedule`, but calls @p fn once for a batch of events.
+     *
+     * A batch holds up to @p max_batch events: whatever is queued, plus whatever arrives within
+     * @p batch_window after the first one. With a zero window, batches form only when the
+     * subscriber falls behind, so this adds no latency. With an executor, the window is ignored.
+     *
+     * Use this when per-event work is cheaper in bulk (file writes, serialization, ...). The
+     * iteration number passed to @p fn counts batches.
+     *
+     * This is safe to be called from any thread.
+     *
+     * @throws if topic already exists and its type does not match the @p event, or if @p qos_
+     * asks for `dispatch::inline_publisher`.
+     */
+    template <typename specific_event>
+    void schedule_batch(plugin_id_t plugin_id, std::string topic_name, std::function<void(std::vector<ptr<const specific_event>>&&, std::size_t)> fn,
+                        std::size_t max_batch, std::chrono::microseconds batch_window = std::chrono::microseconds{0}, qos qos_ = {}) {
+        try_register_topic<specific_event>(topic_name).schedule_batch(plugin_id, [=](std::vector<queued_event>& batch, std::size_t it_no) {
+            std::vector<ptr<const specific_event>> specific_batch;
+            specific_batch.reserve(batch.size());
+            for (queued_event& this_event : batch) {
+                assert(this_event.value);
+                specific_batch.push_back(static_pointer_cast<const specific_event>(std::move(this_event.value)));
+                assert(specific_batch.back());
+            }
+            fn(std::move(specific_batch), it_no);
+        }, max_batch, batch_window, qos_);
     }
 
     /**
@@ -574,6 +2273,51 @@ public:
         return reader<specific_event>{try_register_topic<specific_event>(topic_name)};
     }
 
+    /// `get_writer()` with the type taken from @p topic_.
+    template <typename specific_event>
+    writer<specific_event> get_writer(topic_descriptor<specific_event> topic_) {
+        return get_writer<specific_event>(topic_.name);
+    }
+
+    /// `get_reader()` with the type taken from @p topic_.
+    template <typename specific_event>
+    reader<specific_event> get_reader(topic_descriptor<specific_event> topic_) {
+        return get_reader<specific_event>(topic_.name);
+    }
+
+    /// `schedule()` with the type taken from @p topic_.
+    template <typename specific_event, typename callback_fn>
+    void schedule(plugin_id_t plugin_id, topic_descriptor<specific_event> topic_, callback_fn fn, qos qos_ = {}) {
+        schedule<specific_event>(plugin_id, topic_.name, std::move(fn), qos_);
+    }
+
+    /**
+     * @brief The type of the events on @p topic_name, or null if no one has used the topic yet.
+     *
+     * This is safe to be called from any thread.
+     */
+    const std::type_info* topic_type(const std::string& topic_name) {
+        const std::shared_lock lock{_m_registry_lock};
+        auto found = _m_registry.find(topic_name);
+        return found == _m_registry.end() ? nullptr : &found->second.ty();
+    }
+
+    /**
+     * @brief Latency histograms of every subscription to @p topic_name, cumulative since it was scheduled.
+     *
+     * The same percentiles are logged periodically to `switchboard_latency`. Empty if the topic does not exist.
+     *
+     * This is safe to be called from any thread.
+     */
+    std::vector<latency_stats> get_latency_stats(const std::string& topic_name) {
+        const std::shared_lock lock{_m_registry_lock};
+        auto found = _m_registry.find(topic_name);
+        if (found == _m_registry.end()) {
+            return {};
+        }
+        return found->second.get_latency_stats();
+    }
+
     /**
      * @brief Stops calling switchboard callbacks.
      *
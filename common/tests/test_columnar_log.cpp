@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "../columnar_log.hpp"
+
+namespace ILLIXR {
+
+class ColumnarLogTest : public ::testing::Test {
+protected:
+	void TearDown() override {
+		std::remove(path.c_str());
+	}
+
+	const std::string path = "/tmp/illixr_test_columnar_log_" + std::to_string(getpid());
+};
+
+static const record_header all_types {"all_types", {
+	{"size", typeid(std::size_t)},
+	{"flag", typeid(bool)},
+	{"real", typeid(double)},
+	{"ns", typeid(std::chrono::nanoseconds)},
+	{"wall", typeid(std::chrono::high_resolution_clock::time_point)},
+	{"time", typeid(time_point)},
+	{"name", typeid(std::string)},
+}};
+
+static record make_record(std::size_t i) {
+	return record{all_types, {
+		{i},
+		{i % 2 == 0},
+		{i * 0.5},
+		{std::chrono::nanoseconds{-static_cast<long>(i)}},
+		{std::chrono::high_resolution_clock::time_point{std::chrono::nanoseconds{i * 3}}},
+		{time_point{std::chrono::nanoseconds{i * 7}}},
+		{std::string{"plugin_"} + std::to_string(i % 3)},
+	}};
+}
+
+TEST_F(ColumnarLogTest, TestRoundTrip) {
+	constexpr std::size_t rows = 1000;
+	{
+		// Small chunks, so the log holds several, and the last one is partly filled
+		columnar_log_writer log {path, all_types, 64};
+		for (std::size_t i = 0; i < rows / 2; ++i) {
+			log.append(make_record(i));
+		}
+		std::vector<record> batch;
+		for (std::size_t i = rows / 2; i < rows; ++i) {
+			batch.push_back(make_record(i));
+		}
+		log.append(batch);
+	}
+
+	columnar_log_reader reader {path};
+	ASSERT_EQ(reader.name(), "all_types");
+	ASSERT_EQ(reader.columns().size(), all_types.get_columns());
+	ASSERT_EQ(reader.columns()[6].name, "name");
+	ASSERT_EQ(reader.columns()[6].type, columnar_log_format::column_type::string);
+	ASSERT_EQ(reader.rows(), rows);
+	// Each distinct string is stored once.
+	ASSERT_EQ(reader.strings().size(), 3U);
+
+	const auto size = reader.get<std::uint64_t>("size");
+	const auto flag = reader.get<bool>("flag");
+	const auto real = reader.get<double>("real");
+	const auto ns = reader.get<std::int64_t>("ns");
+	const auto wall = reader.get<std::int64_t>("wall");
+	const auto time = reader.get<std::int64_t>("time");
+	const auto name = reader.get<std::string>("name");
+	for (std::size_t i = 0; i < rows; ++i) {
+		ASSERT_EQ(size[i], i);
+		ASSERT_EQ(flag[i], i % 2 == 0);
+		ASSERT_EQ(real[i], i * 0.5);
+		ASSERT_EQ(ns[i], -static_cast<std::int64_t>(i));
+		ASSERT_EQ(wall[i], static_cast<std::int64_t>(i * 3));
+		ASSERT_EQ(time[i], static_cast<std::int64_t>(i * 7));
+		ASSERT_EQ(name[i], "plugin_" + std::to_string(i % 3));
+	}
+
+	ASSERT_THROW(reader.get<double>("size"), std::runtime_error);
+	ASSERT_THROW(reader.get<double>("missing"), std::runtime_error);
+}
+
+TEST_F(ColumnarLogTest, TestBatches) {
+	const typed_record_header<std::size_t, bool, std::string, time_point> typed {"typed", {"size", "flag", "name", "time"}};
+	{
+		columnar_log_writer log {path, typed, 64};
+		std::vector<std::size_t> sizes;
+		std::unique_ptr<bool[]> flags {new bool[100]};
+		std::vector<std::string> names;
+		std::vector<time_point> times;
+		for (std::size_t i = 0; i < 100; ++i) {
+			sizes.push_back(i);
+			flags[i] = i % 3 == 0;
+			names.push_back("name_" + std::to_string(i % 4));
+			times.push_back(time_point{std::chrono::nanoseconds{i * 11}});
+		}
+		const void* columns[] = {sizes.data(), flags.get(), names.data(), times.data()};
+		log.append(record_batch{typed, 100, columns});
+		log.append(record{typed, {{std::size_t{100}}, {true}, {std::string{"name_0"}}, {time_point{duration{0}}}}});
+	}
+
+	columnar_log_reader reader {path};
+	ASSERT_EQ(reader.rows(), 101U);
+	ASSERT_EQ(reader.strings().size(), 4U);
+	const auto size = reader.get<std::uint64_t>("size");
+	const auto flag = reader.get<bool>("flag");
+	const auto name = reader.get<std::string>("name");
+	const auto time = reader.get<std::int64_t>("time");
+	for (std::size_t i = 0; i < 100; ++i) {
+		ASSERT_EQ(size[i], i);
+		ASSERT_EQ(flag[i], i % 3 == 0);
+		ASSERT_EQ(name[i], "name_" + std::to_string(i % 4));
+		ASSERT_EQ(time[i], static_cast<std::int64_t>(i * 11));
+	}
+	ASSERT_EQ(size[100], 100U);
+}
+
+TEST_F(ColumnarLogTest, TestReadWhileWriting) {
+	columnar_log_writer log {path, all_types, 64};
+	for (std::size_t i = 0; i < 100; ++i) {
+		log.append(make_record(i));
+	}
+	// The file is as big as its mapping, zeros after the last row, as if the writer were killed.
+	{
+		columnar_log_reader reader {path};
+		ASSERT_EQ(reader.rows(), 100U);
+		ASSERT_EQ(reader.get<std::uint64_t>("size").back(), 99U);
+	}
+	log.append(make_record(100));
+	ASSERT_EQ(columnar_log_reader{path}.rows(), 101U);
+}
+
+TEST_F(ColumnarLogTest, TestConcurrentAppends) {
+	constexpr std::size_t threads = 4;
+	constexpr std::size_t per_thread = 2000;
+	{
+		columnar_log_writer log {path, all_types, 256};
+		std::vector<std::thread> appenders;
+		for (std::size_t t = 0; t < threads; ++t) {
+			appenders.emplace_back([&log, t] {
+				for (std::size_t i = 0; i < per_thread; ++i) {
+					log.append(make_record(t * per_thread + i));
+				}
+			});
+		}
+		for (std::thread& appender : appenders) {
+			appender.join();
+		}
+	}
+	columnar_log_reader reader {path};
+	ASSERT_EQ(reader.rows(), threads * per_thread);
+	auto size = reader.get<std::uint64_t>("size");
+	const auto name = reader.get<std::string>("name");
+	for (std::size_t i = 0; i < size.size(); ++i) {
+		// Rows are whole, even when appended from several threads.
+		ASSERT_EQ(name[i], "plugin_" + std::to_string(size[i] % 3));
+	}
+	std::sort(size.begin(), size.end());
+	for (std::size_t i = 0; i < size.size(); ++i) {
+		ASSERT_EQ(size[i], i);
+	}
+}
+
+TEST_F(ColumnarLogTest, TestNotALog) {
+	{
+		std::ofstream file {path};
+		file << "not a columnar log";
+	}
+	ASSERT_THROW(columnar_log_reader{path}, std::runtime_error);
+	ASSERT_THROW(columnar_log_reader{path + ".missing"}, std::runtime_error);
+}
+
+}
@@ -0,0 +1,161 @@
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <experimental/filesystem>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "../flight_recorder.hpp"
+
+namespace ILLIXR {
+
+namespace fs = std::experimental::filesystem;
+
+static const typed_record_header<std::size_t, std::string> kept_header {"kept", {"id", "name"}};
+static const typed_record_header<std::size_t> other_header {"other", {"id"}};
+static const typed_record_header<std::size_t> trigger_header {"trigger", {"id"}};
+
+class disabled_logger : public record_logger {
+public:
+	virtual void log(const record& r) override {
+		r.mark_used();
+	}
+
+	virtual bool enabled() const override {
+		return false;
+	}
+};
+
+class FlightRecorderTest : public ::testing::Test {
+protected:
+	void TearDown() override {
+		fs::remove_all(dir);
+	}
+
+	flight_recorder::config make_config(std::size_t max_rows = 1000) const {
+		return flight_recorder::config{{"kept"}, {"trigger"}, std::chrono::hours{1}, max_rows, std::chrono::hours{1}, dir};
+	}
+
+	/// Waits for @p recorder to have written @p dumps dumps.
+	static void wait_for(const flight_recorder& recorder, std::size_t dumps) {
+		for (int i = 0; i < 500 && recorder.dumps() < dumps; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		}
+		ASSERT_EQ(recorder.dumps(), dumps);
+	}
+
+	const fs::path dir = "/tmp/illixr_test_flight_recorder_" + std::to_string(getpid());
+};
+
+TEST_F(FlightRecorderTest, TestEnabled) {
+	auto recorder = std::make_shared<flight_recorder>(std::make_shared<disabled_logger>(), make_config());
+	const record_logger& logger = *recorder;
+	ASSERT_TRUE(logger.enabled(kept_header));
+	ASSERT_TRUE(logger.enabled(trigger_header));
+	ASSERT_FALSE(logger.enabled(other_header));
+
+	typed_record_coalescer other {recorder, other_header};
+	ASSERT_FALSE(other);
+}
+
+TEST_F(FlightRecorderTest, TestKeepsLatest) {
+	auto recorder = std::make_shared<flight_recorder>(std::make_shared<disabled_logger>(), make_config(300));
+	{
+		typed_record_coalescer kept {recorder, kept_header};
+		for (std::size_t i = 0; i < 1000; ++i) {
+			kept.log(i, "name");
+			if (i % 100 == 99) {
+				kept.flush();
+			}
+		}
+	}
+	record_logger& logger = *recorder;
+	logger.log(typed_record{other_header, std::size_t{0}});
+	recorder->request();
+	wait_for(*recorder, 1);
+
+	ASSERT_TRUE(fs::exists(dir / "0_request" / "kept.cols"));
+	ASSERT_FALSE(fs::exists(dir / "0_request" / "other.cols"));
+	columnar_log_reader log {dir / "0_request" / "kept.cols"};
+	// Whole chunks are dropped, so somewhat more than max_rows are kept.
+	ASSERT_GE(log.rows(), 300U);
+	ASSERT_LT(log.rows(), 1000U);
+	const std::vector<std::uint64_t> ids = log.get<std::uint64_t>("id");
+	for (std::size_t row = 0; row < log.rows(); ++row) {
+		ASSERT_EQ(ids[row], 1000 - log.rows() + row);
+	}
+	ASSERT_EQ(log.get<std::string>("name").back(), "name");
+	// Nothing is left half-written.
+	for (const auto& entry : fs::directory_iterator{dir}) {
+		ASSERT_NE(entry.path().filename().string()[0], '.');
+	}
+}
+
+TEST_F(FlightRecorderTest, TestTriggers) {
+	auto recorder = std::make_shared<flight_recorder>(nullptr, make_config());
+	record_logger& logger = *recorder;
+	logger.log(typed_record{kept_header, std::size_t{1}, "one"});
+	logger.log(typed_record{trigger_header, std::size_t{0}});
+	wait_for(*recorder, 1);
+	ASSERT_TRUE(fs::exists(dir / "0_trigger" / "kept.cols"));
+	ASSERT_EQ(columnar_log_reader{dir / "0_trigger" / "kept.cols"}.rows(), 1U);
+
+	// Within the cooldown, triggers do not dump, but requests do.
+	logger.log(typed_record{kept_header, std::size_t{2}, "two"});
+	logger.log(typed_record{trigger_header, std::size_t{1}});
+	raise(SIGUSR1);
+	wait_for(*recorder, 2);
+	ASSERT_TRUE(fs::exists(dir / "1_request" / "kept.cols"));
+	columnar_log_reader second {dir / "1_request" / "kept.cols"};
+	ASSERT_EQ(second.get<std::uint64_t>("id"), std::vector<std::uint64_t>{2});
+}
+
+TEST_F(FlightRecorderTest, TestFlushesFirst) {
+	auto flusher = std::make_shared<record_flusher>(1024);
+	auto recorder = std::make_shared<flight_recorder>(nullptr, make_config(), flusher);
+	typed_record_coalescer kept {recorder, kept_header, flusher};
+	kept.log(std::size_t{7}, "seven");
+	recorder->request();
+	wait_for(*recorder, 1);
+	ASSERT_EQ(columnar_log_reader{dir / "0_request" / "kept.cols"}.get<std::uint64_t>("id"), std::vector<std::uint64_t>{7});
+}
+
+TEST_F(FlightRecorderTest, TestCrash) {
+	// Forked without re-executing (the default style), so the child dumps into the parent's dir
+	ASSERT_DEATH({
+		auto recorder = std::make_shared<flight_recorder>(nullptr, make_config());
+		static_cast<record_logger&>(*recorder).log(typed_record{kept_header, std::size_t{3}, "three"});
+		std::abort();
+	}, "");
+	ASSERT_TRUE(fs::exists(dir / "0_crash" / "kept.cols"));
+}
+
+TEST_F(FlightRecorderTest, TestCrashChains) {
+	// The handler installed before the recorder still runs, after the dump.
+	ASSERT_EXIT({
+		std::signal(SIGABRT, [](int) { _exit(3); });
+		auto recorder = std::make_shared<flight_recorder>(nullptr, make_config());
+		static_cast<record_logger&>(*recorder).log(typed_record{kept_header, std::size_t{3}, "three"});
+		std::abort();
+	}, ::testing::ExitedWithCode(3), "");
+	ASSERT_TRUE(fs::exists(dir / "0_crash" / "kept.cols"));
+}
+
+static void later_handler(int) { }
+
+TEST_F(FlightRecorderTest, TestKeepsLaterHandlers) {
+	struct sigaction ill_before {}, fpe_before {}, fpe_after {};
+	sigaction(SIGILL, nullptr, &ill_before);
+	sigaction(SIGFPE, nullptr, &fpe_before);
+	{
+		auto recorder = std::make_shared<flight_recorder>(nullptr, make_config());
+		std::signal(SIGILL, &later_handler);
+	}
+	// The recorder put back the handlers from before it where it still had its own, but not over this one.
+	sigaction(SIGFPE, nullptr, &fpe_after);
+	ASSERT_EQ(fpe_after.sa_handler, fpe_before.sa_handler);
+	ASSERT_EQ(std::signal(SIGILL, SIG_DFL), &later_handler);
+	sigaction(SIGILL, &ill_before, nullptr);
+}
+
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include "../latency_histogram.hpp"
+
+namespace ILLIXR {
+
+class LatencyHistogramTest : public ::testing::Test { };
+
+TEST_F(LatencyHistogramTest, TestEmpty) {
+	latency_histogram histogram;
+	latency_histogram::snapshot stats = histogram.get_snapshot();
+	ASSERT_EQ(stats.count(), 0);
+	ASSERT_EQ(stats.percentile(0.99), std::chrono::nanoseconds{0});
+}
+
+TEST_F(LatencyHistogramTest, TestPercentiles) {
+	latency_histogram histogram;
+	// 1 us .. 10 ms, uniformly
+	for (std::int64_t us = 1; us <= 10000; ++us) {
+		histogram.record(std::chrono::microseconds{us});
+	}
+	latency_histogram::snapshot stats = histogram.get_snapshot();
+	ASSERT_EQ(stats.count(), 10000);
+	ASSERT_EQ(stats.max(), std::chrono::milliseconds{10});
+
+	// Within the bucket width (1/32)
+	auto near = [](std::chrono::nanoseconds actual, std::chrono::microseconds expected) {
+		return std::abs(actual.count() - std::chrono::nanoseconds{expected}.count()) <= std::chrono::nanoseconds{expected}.count() / 32;
+	};
+	ASSERT_TRUE(near(stats.percentile(0.5), std::chrono::microseconds{5000}));
+	ASSERT_TRUE(near(stats.percentile(0.99), std::chrono::microseconds{9900}));
+	ASSERT_TRUE(near(stats.percentile(0.999), std::chrono::microseconds{9990}));
+	ASSERT_EQ(stats.percentile(1.0), std::chrono::milliseconds{10});
+}
+
+TEST_F(LatencyHistogramTest, TestSmallAndOutOfRange) {
+	latency_histogram histogram;
+	// Small values are exact; negative ones count as 0.
+	histogram.record(std::chrono::nanoseconds{-5});
+	histogram.record(std::chrono::nanoseconds{7});
+	histogram.record(std::chrono::hours{1});
+	latency_histogram::snapshot stats = histogram.get_snapshot();
+	ASSERT_EQ(stats.count(), 3);
+	ASSERT_EQ(stats.percentile(0.0), std::chrono::nanoseconds{0});
+	ASSERT_EQ(stats.percentile(0.5), std::chrono::nanoseconds{7});
+	ASSERT_EQ(stats.max(), std::chrono::hours{1});
+	ASSERT_EQ(stats.percentile(1.0), std::chrono::hours{1});
+}
+
+}
@@ -0,0 +1,222 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../record_logger.hpp"
+
+namespace ILLIXR {
+
+class RecordLoggerTest : public ::testing::Test { };
+
+static const typed_record_header<std::size_t, std::string, time_point> typed_header {"typed", {"id", "name", "time"}};
+
+/// Keeps what it is given; batches go through the default, boxing path unless `keep_batches`.
+class keeping_logger : public record_logger {
+public:
+	explicit keeping_logger(bool keep_batches_ = false, bool enabled_ = true)
+		: keep_batches{keep_batches_}
+		, enabled_{enabled_}
+	{ }
+
+	virtual void log(const record& r) override {
+		ids.push_back(r.get_value<std::size_t>(0));
+		names.push_back(r.get_value<std::string>(1));
+		r.get_value<time_point>(2);
+	}
+
+	virtual void log(const record_batch& batch) override {
+		if (batch.header != typed_header) {
+			// Such as log_ring
+			others.push_back(batch.header.get_name());
+			return;
+		}
+		if (gate.valid()) {
+			gate.wait();
+		}
+		batches.push_back(batch.rows);
+		if (!keep_batches) {
+			record_logger::log(batch);
+			return;
+		}
+		for (std::size_t row = 0; row < batch.rows; ++row) {
+			ids.push_back(batch.column<std::size_t>(0)[row]);
+			names.push_back(batch.column<std::string>(1)[row]);
+		}
+	}
+
+	virtual bool enabled() const override {
+		return enabled_;
+	}
+
+	std::vector<std::size_t> batches;
+	std::vector<std::size_t> ids;
+	std::vector<std::string> names;
+	std::vector<std::string> others;
+	/// If valid, batches wait for it
+	std::shared_future<void> gate;
+
+private:
+	const bool keep_batches;
+	const bool enabled_;
+};
+
+TEST_F(RecordLoggerTest, TestTypedHeader) {
+	const record_header untyped {"typed", {
+		{"id", typeid(std::size_t)},
+		{"name", typeid(std::string)},
+		{"time", typeid(time_point)},
+	}};
+	ASSERT_EQ(typed_header, untyped);
+	ASSERT_EQ(typed_header.get_column_name(1), "name");
+	ASSERT_EQ(typed_header.get_column_type(2), typeid(time_point));
+}
+
+TEST_F(RecordLoggerTest, TestTypedRecord) {
+	keeping_logger logger;
+	record_logger& base = logger;
+	base.log(typed_record{typed_header, std::size_t{7}, "seven", time_point{duration{0}}});
+	ASSERT_EQ(logger.batches, std::vector<std::size_t>{1});
+	ASSERT_EQ(logger.ids, std::vector<std::size_t>{7});
+	ASSERT_EQ(logger.names, std::vector<std::string>{"seven"});
+}
+
+TEST_F(RecordLoggerTest, TestTypedCoalescer) {
+	auto logger = std::make_shared<keeping_logger>(true);
+	// Longer than a short string, so copying it would allocate
+	const std::string name = "a name which does not fit in a short string";
+	{
+		typed_record_coalescer coalescer {logger, typed_header};
+		ASSERT_TRUE(coalescer);
+		for (std::size_t i = 0; i < 100; ++i) {
+			coalescer.log(i, name, time_point{duration{0}});
+		}
+		coalescer.flush();
+		// The buffers are reused.
+		for (std::size_t i = 100; i < 150; ++i) {
+			coalescer.log(i, name, time_point{duration{0}});
+		}
+	}
+	ASSERT_EQ(logger->batches, (std::vector<std::size_t>{100, 50}));
+	ASSERT_EQ(logger->ids.size(), 150U);
+	for (std::size_t i = 0; i < logger->ids.size(); ++i) {
+		ASSERT_EQ(logger->ids[i], i);
+		ASSERT_EQ(logger->names[i], name);
+	}
+}
+
+TEST_F(RecordLoggerTest, TestBoxedBatch) {
+	auto logger = std::make_shared<keeping_logger>();
+	{
+		typed_record_coalescer coalescer {logger, typed_header};
+		coalescer.log(1, "one", time_point{duration{0}});
+		coalescer.log(2, "two", time_point{duration{0}});
+	}
+	ASSERT_EQ(logger->batches, std::vector<std::size_t>{2});
+	ASSERT_EQ(logger->ids, (std::vector<std::size_t>{1, 2}));
+	ASSERT_EQ(logger->names, (std::vector<std::string>{"one", "two"}));
+}
+
+TEST_F(RecordLoggerTest, TestDisabled) {
+	auto logger = std::make_shared<keeping_logger>(true, false);
+	{
+		typed_record_coalescer coalescer {logger, typed_header};
+		ASSERT_FALSE(coalescer);
+		coalescer.log(1, "one", time_point{duration{0}});
+	}
+	ASSERT_TRUE(logger->batches.empty());
+
+	typed_record_coalescer without_logger {nullptr, typed_header};
+	ASSERT_FALSE(without_logger);
+}
+
+TEST_F(RecordLoggerTest, TestFlusher) {
+	auto logger = std::make_shared<keeping_logger>(true);
+	// Faster than the flusher, so some wait for room
+	auto flusher = std::make_shared<record_flusher>(64, log_overflow::block);
+	{
+		typed_record_coalescer coalescer {logger, typed_header, flusher};
+		for (std::size_t i = 0; i < 1000; ++i) {
+			coalescer.log(i, "name", time_point{duration{0}});
+		}
+		ASSERT_EQ(coalescer.dropped(), 0U);
+	}
+	// The coalescer waits for its ring to be drained.
+	ASSERT_EQ(logger->ids.size(), 1000U);
+	for (std::size_t i = 0; i < logger->ids.size(); ++i) {
+		ASSERT_EQ(logger->ids[i], i);
+	}
+	ASSERT_EQ(logger->others, std::vector<std::string>{"log_ring"});
+	ASSERT_EQ(flusher->dropped(), 0U);
+}
+
+TEST_F(RecordLoggerTest, TestFlusherDrops) {
+	auto logger = std::make_shared<keeping_logger>(true);
+	std::promise<void> open;
+	logger->gate = open.get_future().share();
+	auto flusher = std::make_shared<record_flusher>(4, log_overflow::drop);
+	{
+		typed_record_coalescer coalescer {logger, typed_header, flusher};
+		// The flusher cannot make room while the logger waits, so 4 fit.
+		for (std::size_t i = 0; i < 7; ++i) {
+			coalescer.log(i, "name", time_point{duration{0}});
+		}
+		ASSERT_EQ(coalescer.dropped(), 3U);
+		ASSERT_EQ(coalescer.blocked(), 0U);
+		ASSERT_EQ(flusher->dropped(), 3U);
+		open.set_value();
+	}
+	ASSERT_EQ(logger->ids, (std::vector<std::size_t>{0, 1, 2, 3}));
+	ASSERT_EQ(flusher->dropped(), 3U);
+}
+
+TEST_F(RecordLoggerTest, TestFlusherBlocks) {
+	auto logger = std::make_shared<keeping_logger>(true);
+	std::promise<void> open;
+	logger->gate = open.get_future().share();
+	auto flusher = std::make_shared<record_flusher>(4, log_overflow::block);
+	std::atomic<bool> done {false};
+	std::size_t blocked = 0;
+	std::thread producer {[&] {
+		typed_record_coalescer coalescer {logger, typed_header, flusher};
+		for (std::size_t i = 0; i < 10; ++i) {
+			coalescer.log(i, "name", time_point{duration{0}});
+		}
+		blocked = coalescer.blocked();
+		done = true;
+	}};
+	std::this_thread::sleep_for(std::chrono::milliseconds{50});
+	// Waiting for room
+	ASSERT_FALSE(done);
+	open.set_value();
+	producer.join();
+	ASSERT_GE(blocked, 1U);
+	ASSERT_EQ(logger->ids.size(), 10U);
+	for (std::size_t i = 0; i < logger->ids.size(); ++i) {
+		ASSERT_EQ(logger->ids[i], i);
+	}
+	ASSERT_EQ(flusher->dropped(), 0U);
+}
+
+TEST_F(RecordLoggerTest, TestRingWraps) {
+	auto logger = std::make_shared<keeping_logger>(true);
+	typed_log_ring<std::size_t, std::string, time_point> ring {logger, typed_header, 3};
+	ASSERT_EQ(ring.get_capacity(), 4U);
+	for (std::size_t i = 0; i < 3; ++i) {
+		ASSERT_EQ(ring.push(i, "name", time_point{duration{0}}), i + 1);
+	}
+	ASSERT_EQ(ring.drain(), 3U);
+	for (std::size_t i = 3; i < 7; ++i) {
+		ASSERT_NE(ring.push(i, "name", time_point{duration{0}}), 0U);
+	}
+	ASSERT_EQ(ring.push(7, "name", time_point{duration{0}}), 0U);
+	// Slots 3, then 0-2
+	ASSERT_EQ(ring.drain(), 4U);
+	ASSERT_EQ(logger->batches, (std::vector<std::size_t>{3, 1, 3}));
+	ASSERT_EQ(logger->ids, (std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6}));
+	ASSERT_EQ(ring.pushed(), 7U);
+}
+
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../relative_clock.hpp"
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class RelativeClockTest : public ::testing::Test { };
+
+TEST_F(RelativeClockTest, TestMakeBackend) {
+	ASSERT_FALSE(make_clock_backend("")->tracks_work());
+	ASSERT_FALSE(make_clock_backend("real")->tracks_work());
+	ASSERT_FALSE(make_clock_backend("scaled:2.5")->tracks_work());
+	ASSERT_TRUE(make_clock_backend("virtual")->tracks_work());
+	ASSERT_THROW(make_clock_backend("fast"), std::runtime_error);
+	ASSERT_THROW(make_clock_backend("scaled:0"), std::invalid_argument);
+}
+
+TEST_F(RelativeClockTest, TestScaled) {
+	RelativeClock clock {make_clock_backend("scaled:100")};
+	clock.start();
+	auto start = std::chrono::steady_clock::now();
+	clock.sleep_until(time_point{std::chrono::seconds{1}});
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	ASSERT_GE(clock.now(), time_point{std::chrono::seconds{1}});
+	ASSERT_GE(elapsed, std::chrono::milliseconds{9});
+	ASSERT_LT(elapsed, std::chrono::milliseconds{500});
+
+	// Conversions to and from other processes' times are unaffected by the speed.
+	ASSERT_EQ(clock.from_absolute_ns(clock.absolute_ns(time_point{std::chrono::seconds{3}})), time_point{std::chrono::seconds{3}});
+}
+
+TEST_F(RelativeClockTest, TestInterrupt) {
+	RelativeClock clock;
+	clock.start();
+	std::thread sleeper {[&] {
+		clock.sleep_for(std::chrono::hours{1});
+	}};
+	std::this_thread::sleep_for(std::chrono::milliseconds{10});
+	clock.interrupt();
+	sleeper.join();
+	// Later sleeps return at once.
+	clock.sleep_for(std::chrono::hours{1});
+}
+
+class unused_logger : public record_logger {
+protected:
+	void log(const record& r) override {
+		r.mark_used();
+	}
+};
+
+class tick : public switchboard::event {
+public:
+	tick(time_point published_) : published{published_} { }
+	time_point published;
+};
+
+TEST_F(RelativeClockTest, TestVirtual) {
+	phonebook pb;
+	pb.register_impl<record_logger>(std::make_shared<unused_logger>());
+	auto clock = std::make_shared<RelativeClock>(make_clock_backend("virtual"));
+	pb.register_impl<RelativeClock>(clock);
+	switchboard sb {&pb};
+	clock->start();
+	ASSERT_EQ(clock->now(), time_point{duration{0}});
+
+	// A subscriber which takes real time, but no clock time: time stands still until it is done.
+	std::vector<duration> lags;
+	std::atomic<std::size_t> received {0};
+	sb.schedule<tick>(0, "ticks", [&](switchboard::ptr<const tick>&& datum, std::size_t) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{2});
+		lags.push_back(clock->now() - datum->published);
+		received++;
+	});
+
+	// Two participants with different periods; a minute of clock time passes in moments.
+	const auto start = std::chrono::steady_clock::now();
+	std::thread producer {[&] {
+		auto writer = sb.get_writer<tick>("ticks");
+		for (int i = 1; i <= 60; ++i) {
+			clock->sleep_until(time_point{std::chrono::seconds{i}});
+			ASSERT_EQ(clock->now(), time_point{std::chrono::seconds{i}});
+			writer.put(writer.allocate(clock->now()));
+		}
+	}};
+	std::atomic<int> wake_ups {0};
+	std::thread other {[&] {
+		for (int i = 1; i <= 40; ++i) {
+			clock->sleep_until(time_point{std::chrono::milliseconds{1500 * i}});
+			wake_ups++;
+		}
+	}};
+	producer.join();
+	other.join();
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{10});
+	ASSERT_EQ(wake_ups.load(), 40);
+	ASSERT_EQ(clock->now(), time_point{std::chrono::seconds{60}});
+
+	while (received.load() != 60) {
+		std::this_thread::yield();
+	}
+	sb.stop();
+	ASSERT_EQ(lags, std::vector<duration>(60, duration{0}));
+}
+
+}
@@ -0,0 +1,219 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "../shm_transport.hpp"
+
+namespace ILLIXR {
+
+class ShmTransportTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		clock->start();
+	}
+
+	/// shm names are host-wide, so keep concurrent test runs apart.
+	static std::string unique(const std::string& topic_name) {
+		return "test_" + topic_name + "_" + std::to_string(getpid());
+	}
+
+	std::shared_ptr<RelativeClock> clock = std::make_shared<RelativeClock>();
+};
+
+/// A variable-length array which readers see in place.
+struct blob : public switchboard::event {
+	blob(std::vector<std::uint64_t> values_)
+		: owned{std::move(values_)}
+		, values{owned.data()}
+		, count{owned.size()}
+	{ }
+
+	blob(const std::uint64_t* values_, std::size_t count_)
+		: values{values_}
+		, count{count_}
+	{ }
+
+	std::vector<std::uint64_t> owned;
+	const std::uint64_t* values;
+	std::size_t count;
+};
+
+template <>
+struct shm_codec<blob> {
+	static std::size_t size(const blob& this_event) {
+		return this_event.count * sizeof(std::uint64_t);
+	}
+
+	static void write(const blob& this_event, std::byte* dst, const RelativeClock&) {
+		std::memcpy(dst, this_event.values, size(this_event));
+	}
+
+	static switchboard::ptr<blob> read(const std::byte* src, std::size_t size, const RelativeClock&, std::shared_ptr<const void>&& pin) {
+		return switchboard::make_ptr<shm_pinned<blob>>(std::move(pin), reinterpret_cast<const std::uint64_t*>(src), size / sizeof(std::uint64_t));
+	}
+};
+
+template <typename Predicate>
+static void wait_until(Predicate predicate) {
+	while (!predicate()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+}
+
+TEST_F(ShmTransportTest, TestRoundTrip) {
+	using wrapped = switchboard::event_wrapper<std::uint64_t>;
+	const std::string topic_name = unique("round_trip");
+	// Two switchboards stand in for two processes.
+	auto exporter_sb = std::make_shared<switchboard>(nullptr);
+	auto importer_sb = std::make_shared<switchboard>(nullptr);
+	std::vector<std::uint64_t> received;
+	std::mutex received_lock;
+	importer_sb->schedule<wrapped>(0, topic_name, [&](switchboard::ptr<const wrapped>&& this_event, std::size_t) {
+		const std::lock_guard lock {received_lock};
+		received.push_back(**this_event);
+	});
+
+	{
+		// The importer waits for the ring to appear.
+		shm_importer<wrapped> importer {importer_sb, clock, topic_name};
+		std::this_thread::sleep_for(std::chrono::milliseconds{20});
+		auto ring = shm_export<wrapped>(*exporter_sb, clock, 0, topic_name, 256, sizeof(std::uint64_t));
+		auto writer = exporter_sb->get_writer<wrapped>(topic_name);
+		for (std::uint64_t i = 0; i < 200; ++i) {
+			writer.put(writer.allocate(i));
+		}
+		wait_until([&] {
+			const std::lock_guard lock {received_lock};
+			return received.size() == 200;
+		});
+		ASSERT_EQ(importer.lost(), 0);
+		ASSERT_EQ(ring->dropped(), 0);
+	}
+	exporter_sb->stop();
+	importer_sb->stop();
+	for (std::uint64_t i = 0; i < 200; ++i) {
+		ASSERT_EQ(received[i], i);
+	}
+}
+
+TEST_F(ShmTransportTest, TestPinnedSlotsAreNotReused) {
+	const std::string topic_name = unique("pins");
+	auto exporter_sb = std::make_shared<switchboard>(nullptr);
+	auto importer_sb = std::make_shared<switchboard>(nullptr);
+	std::vector<switchboard::ptr<const blob>> held;
+	std::mutex held_lock;
+	importer_sb->schedule<blob>(0, topic_name, [&](switchboard::ptr<const blob>&& this_event, std::size_t) {
+		const std::lock_guard lock {held_lock};
+		held.push_back(std::move(this_event));
+	});
+	auto held_size = [&] {
+		const std::lock_guard lock {held_lock};
+		return held.size();
+	};
+
+	auto ring = shm_export<blob>(*exporter_sb, clock, 0, topic_name, 4, 64 * sizeof(std::uint64_t));
+	{
+		shm_importer<blob> importer {importer_sb, clock, topic_name};
+		auto writer = exporter_sb->get_writer<blob>(topic_name);
+		std::vector<std::uint64_t> values (64);
+		for (std::uint64_t i = 0; i < 4; ++i) {
+			std::fill(values.begin(), values.end(), i);
+			writer.put(writer.allocate(values));
+			wait_until([&] { return held_size() == i + 1; });
+		}
+
+		// Zero-copy: the importer's events point into the shared slots.
+		for (std::uint64_t i = 0; i < 4; ++i) {
+			ASSERT_TRUE(held[i]->owned.empty());
+			ASSERT_EQ(held[i]->count, 64);
+			ASSERT_EQ(held[i]->values[63], i);
+		}
+
+		// Every slot is pinned, so this one cannot be placed.
+		writer.put(writer.allocate(values));
+		wait_until([&] { return ring->dropped() == 1; });
+
+		// Releasing them frees the slots (except the topic's latest).
+		{
+			const std::lock_guard lock {held_lock};
+			held.clear();
+		}
+		std::fill(values.begin(), values.end(), 42);
+		writer.put(writer.allocate(values));
+		wait_until([&] { return held_size() == 1; });
+		ASSERT_EQ(held[0]->values[0], 42);
+		ASSERT_EQ(ring->dropped(), 1);
+		ASSERT_EQ(importer.lost(), 0);
+	}
+	importer_sb->stop();
+	exporter_sb->stop();
+}
+
+TEST_F(ShmTransportTest, TestGetRwCopiesPinnedEvents) {
+	const std::string topic_name = unique("get_rw");
+	auto sb = std::make_shared<switchboard>(nullptr);
+	std::vector<std::uint64_t> slot {1, 2, 3};
+	auto pin = std::make_shared<int>(0);
+	std::weak_ptr<int> pinned = pin;
+	auto writer = sb->get_writer<blob>(topic_name);
+	auto reader = sb->get_reader<blob>(topic_name);
+	writer.put(switchboard::make_ptr<shm_pinned<blob>>(std::move(pin), slot.data(), slot.size()));
+
+	switchboard::cow_ptr<blob> event = reader.get_rw();
+	writer.put(writer.allocate(std::vector<std::uint64_t>{}));
+	// The handle is the event's last owner, but it must not take the borrowed slot over.
+	ASSERT_FALSE(event.owned());
+	ASSERT_EQ(event.get()->values, slot.data());
+
+	blob& copy = *event;
+	ASSERT_TRUE(event.owned());
+	ASSERT_NE(dynamic_cast<shm_pinned<blob>*>(&copy), nullptr);
+	ASSERT_NE(copy.values, slot.data());
+	ASSERT_TRUE(pinned.expired());
+	slot.assign(3, 0);
+	ASSERT_EQ(copy.count, 3);
+	ASSERT_EQ(copy.values[2], 3);
+	sb->stop();
+}
+
+TEST_F(ShmTransportTest, TestTopicTypes) {
+	using wrapped = switchboard::event_wrapper<std::uint64_t>;
+	const std::string topic_name = unique("by_type");
+	shm_topic_types types;
+	types.add<wrapped>();
+	ASSERT_TRUE(types.has(typeid(wrapped).name()));
+	ASSERT_FALSE(types.has(typeid(blob).name()));
+
+	auto exporter_sb = std::make_shared<switchboard>(nullptr);
+	auto importer_sb = std::make_shared<switchboard>(nullptr);
+	std::atomic<std::uint64_t> received {0};
+	importer_sb->schedule<wrapped>(0, topic_name, [&](switchboard::ptr<const wrapped>&& this_event, std::size_t) {
+		received = **this_event;
+	});
+	auto writer = exporter_sb->get_writer<wrapped>(topic_name);
+
+	// Only the topics' type names are needed from here on, as in the shm_bridge plugin.
+	auto ring = types.export_topic(*exporter_sb->topic_type(topic_name), *exporter_sb, clock, 0, topic_name, 4, sizeof(std::uint64_t));
+	{
+		std::unique_ptr<shm_import> importer = types.import_topic(*importer_sb->topic_type(topic_name), importer_sb, clock, topic_name);
+		writer.put(writer.allocate(7));
+		wait_until([&] { return received.load() == 7; });
+		ASSERT_EQ(importer->lost(), 0);
+	}
+	ASSERT_EQ(ring->dropped(), 0);
+	importer_sb->stop();
+	exporter_sb->stop();
+}
+
+TEST_F(ShmTransportTest, TestTypeMismatch) {
+	const std::string topic_name = unique("types");
+	auto ring = shm_ring::create(topic_name, typeid(blob), 4, 64);
+	ASSERT_THROW(shm_ring::open(topic_name, typeid(switchboard::event_wrapper<int>)), std::runtime_error);
+	ASSERT_NE(shm_ring::open(topic_name, typeid(blob)), nullptr);
+	ASSERT_EQ(shm_ring::open(unique("missing"), typeid(blob)), nullptr);
+}
+
+}
@@ -1,6 +1,7 @@
 #include <thread>
 #include <random>
 #include <cstdint>
+#include <ctime>
 #include "gtest/gtest.h"
 #include "../switchboard.hpp"
 
@@ -188,4 +189,937 @@ TEST_F(SwitchboardTest, TestSyncAsync) {
 	// ASSERT_EQ(uint64_wrapper::get_destructed_count(), MAX_ITERATIONS - 1);
 }
 
+TEST_F(SwitchboardTest, TestPoolRecycles) {
+	const std::size_t MAX_ITERATIONS = 1000;
+
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<uint64_wrapper>("recycled");
+	ASSERT_EQ(writer.get_pool_stats().block_size, sizeof(uint64_wrapper));
+
+	for (uint64_t i = 0; i < MAX_ITERATIONS; ++i) {
+		writer.put(writer.allocate<uint64_wrapper>(i));
+	}
+
+	switchboard::pool_stats stats = writer.get_pool_stats();
+	ASSERT_EQ(stats.block_size, sizeof(uint64_wrapper));
+	ASSERT_EQ(stats.hits + stats.misses, MAX_ITERATIONS);
+	// The topic keeps a few recent events alive; the rest should come back through the pool.
+	ASSERT_GT(stats.hits, 0);
+	ASSERT_EQ(*sb.get_reader<uint64_wrapper>("recycled").get_ro(), MAX_ITERATIONS - 1);
+}
+
+TEST_F(SwitchboardTest, TestLatestStress) {
+	const uint64_t MAX_ITERATIONS = 20000;
+	const std::size_t READERS = 4;
+
+	switchboard sb {nullptr};
+
+	std::atomic<bool> done {false};
+	std::vector<std::thread> readers;
+	for (std::size_t r = 0; r < READERS; ++r) {
+		readers.emplace_back([&sb, &done] {
+			auto reader = sb.get_reader<uint64_wrapper>("latest");
+			uint64_t last_datum = 0;
+			while (!done.load()) {
+				switchboard::ptr<const uint64_wrapper> datum = reader.get_ro_nullable();
+				if (datum) {
+					// A single writer publishes increasing values, so reads must never go backwards.
+					ASSERT_LE(last_datum, *datum);
+					last_datum = *datum;
+				}
+			}
+		});
+	}
+
+	// Several writers on one topic must not corrupt the slots either.
+	std::vector<std::thread> writers;
+	for (uint64_t w = 0; w < 2; ++w) {
+		writers.emplace_back([&sb, w] {
+			auto writer = sb.get_writer<uint64_wrapper>("shared_latest");
+			auto reader = sb.get_reader<uint64_wrapper>("shared_latest");
+			for (uint64_t i = 1; i < MAX_ITERATIONS; ++i) {
+				writer.put(writer.allocate<uint64_wrapper>(2*i + w));
+				ASSERT_LT(uint64_t{*reader.get_ro()}, 2*MAX_ITERATIONS);
+			}
+		});
+	}
+
+	auto writer = sb.get_writer<uint64_wrapper>("latest");
+	for (uint64_t i = 1; i < MAX_ITERATIONS; ++i) {
+		writer.put(writer.allocate<uint64_wrapper>(i));
+	}
+
+	for (std::thread& t : writers) {
+		t.join();
+	}
+	done = true;
+	for (std::thread& t : readers) {
+		t.join();
+	}
+
+	ASSERT_EQ(*sb.get_reader<uint64_wrapper>("latest").get_ro(), MAX_ITERATIONS - 1);
+}
+
+class counted_event : public switchboard::event {
+public:
+	counted_event() { _s_alive++; }
+	~counted_event() { _s_alive--; }
+	static std::size_t alive() { return _s_alive; }
+private:
+	static std::atomic<std::size_t> _s_alive;
+};
+
+std::atomic<std::size_t> counted_event::_s_alive {0};
+
+TEST_F(SwitchboardTest, TestLatestDoesNotPin) {
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<counted_event>("idle");
+
+	for (std::size_t i = 0; i < 100; ++i) {
+		writer.put(writer.allocate());
+	}
+
+	// Only the latest event should stay alive on an idle topic.
+	ASSERT_EQ(counted_event::alive(), 1);
+	ASSERT_NE(sb.get_reader<counted_event>("idle").get_ro_nullable(), nullptr);
+}
+
+class other_base {
+public:
+	virtual ~other_base() = default;
+	std::uint64_t padding = 0;
+};
+
+/// The event base is not at the start of the object, so its block is not where the event is.
+class offset_event : public other_base, public switchboard::event {
+public:
+	offset_event(std::uint64_t value_) : value{value_} { }
+	std::uint64_t value;
+};
+
+TEST_F(SwitchboardTest, TestPtr) {
+	{
+		switchboard::ptr<counted_event> made = switchboard::make_ptr<counted_event>();
+		ASSERT_EQ(counted_event::alive(), 1);
+		ASSERT_EQ(made.use_count(), 1);
+
+		switchboard::ptr<const switchboard::event> base = made;
+		ASSERT_EQ(made.use_count(), 2);
+		ASSERT_EQ(base, made);
+
+		// Moves and casts of moved handles do not count.
+		switchboard::ptr<const counted_event> cast = switchboard::static_pointer_cast<const counted_event>(std::move(base));
+		ASSERT_EQ(base, nullptr);
+		ASSERT_EQ(made.use_count(), 2);
+
+		ASSERT_EQ(switchboard::dynamic_pointer_cast<const uint64_wrapper>(cast), nullptr);
+		ASSERT_EQ(switchboard::dynamic_pointer_cast<const counted_event>(cast), made);
+		ASSERT_EQ(made.use_count(), 2);
+
+		made.reset();
+		ASSERT_EQ(cast.use_count(), 1);
+	}
+	ASSERT_EQ(counted_event::alive(), 0);
+
+	// A copy of an event is a new event, not another reference.
+	auto original = switchboard::make_ptr<offset_event>(1);
+	auto copied = switchboard::make_ptr<offset_event>(*original);
+	ASSERT_EQ(original.use_count(), 1);
+	ASSERT_EQ(copied.use_count(), 1);
+}
+
+TEST_F(SwitchboardTest, TestPtrFanOut) {
+	const std::size_t SUBSCRIBERS = 3;
+	const std::uint64_t MAX_ITERATIONS = 100;
+
+	switchboard sb {nullptr};
+	std::atomic<std::size_t> received {0};
+	std::atomic<std::uint64_t> total {0};
+	for (std::size_t i = 0; i < SUBSCRIBERS; ++i) {
+		sb.schedule<offset_event>(0, "fan_out", [&](switchboard::ptr<const offset_event>&& datum, std::size_t) {
+			total += datum->value;
+			received++;
+		});
+	}
+
+	auto writer = sb.get_writer<offset_event>("fan_out");
+	for (std::uint64_t i = 1; i <= MAX_ITERATIONS; ++i) {
+		writer.put(writer.allocate(i));
+	}
+	while (received.load() != SUBSCRIBERS * MAX_ITERATIONS) {
+		std::this_thread::yield();
+	}
+	sb.stop();
+
+	ASSERT_EQ(total.load(), SUBSCRIBERS * MAX_ITERATIONS * (MAX_ITERATIONS + 1) / 2);
+	// Once the subscribers are done, only the latest value holds the last event.
+	auto latest = sb.get_reader<offset_event>("fan_out").get_ro();
+	ASSERT_EQ(latest->value, MAX_ITERATIONS);
+	ASSERT_EQ(latest.use_count(), 2);
+	// The other events went back to the pool, from wherever their event base was.
+	switchboard::pool_stats stats = writer.get_pool_stats();
+	ASSERT_EQ(stats.free_blocks, stats.hits + stats.misses - 1);
+}
+
+class copy_counted_event : public switchboard::event {
+public:
+	copy_counted_event(int value_) : value{value_} { }
+	copy_counted_event(const copy_counted_event& other)
+		: value{other.value}
+	{
+		++copies;
+	}
+	int value;
+	static inline std::size_t copies = 0;
+};
+
+TEST_F(SwitchboardTest, TestGetRwCopyOnWrite) {
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<copy_counted_event>("cow");
+	auto reader = sb.get_reader<copy_counted_event>("cow");
+	copy_counted_event::copies = 0;
+
+	writer.put(writer.allocate(1));
+	switchboard::cow_ptr<copy_counted_event> first = reader.get_rw();
+	switchboard::cow_ptr<copy_counted_event> second = reader.get_rw();
+
+	// Reading does not copy.
+	ASSERT_EQ(std::as_const(first)->value, 1);
+	ASSERT_FALSE(first.owned());
+	ASSERT_EQ(copy_counted_event::copies, 0);
+
+	// Mutating an event which the topic still holds copies it, once.
+	first->value = 2;
+	first->value = 3;
+	ASSERT_EQ(copy_counted_event::copies, 1);
+	ASSERT_EQ(reader.get_ro()->value, 1);
+
+	// Once the topic moved on, the last holder takes the event over without a copy.
+	writer.put(writer.allocate(4));
+	ASSERT_TRUE(second.owned());
+	const copy_counted_event* before = second.get();
+	second->value = 5;
+	ASSERT_EQ(second.get(), before);
+	ASSERT_EQ(copy_counted_event::copies, 1);
+
+	// A taken-over event can be published again.
+	writer.put(second.release());
+	ASSERT_FALSE(second);
+	ASSERT_EQ(reader.get_ro()->value, 5);
+	ASSERT_EQ(std::as_const(first)->value, 3);
+	ASSERT_EQ(copy_counted_event::copies, 1);
+}
+
+TEST_F(SwitchboardTest, TestConcurrentProducers) {
+	const std::size_t PRODUCERS = 4;
+	const std::size_t EVENTS = 2000;
+
+	switchboard sb {nullptr};
+	std::atomic<std::size_t> first_received {0};
+	sb.schedule<uint64_wrapper>(0, "shared", [&](switchboard::ptr<const uint64_wrapper>&&, std::size_t) {
+		first_received++;
+	});
+
+	std::atomic<bool> go {false};
+	std::vector<std::thread> producers;
+	for (std::size_t p = 0; p < PRODUCERS; ++p) {
+		producers.emplace_back([&] {
+			auto writer = sb.get_writer<uint64_wrapper>("shared");
+			while (!go.load()) { }
+			for (uint64_t i = 0; i < EVENTS; ++i) {
+				writer.put(writer.allocate<uint64_wrapper>(i));
+			}
+		});
+	}
+
+	// Subscribing while the producers publish must neither block them nor lose the earlier subscriber's events.
+	std::atomic<std::size_t> late_received {0};
+	go = true;
+	for (std::size_t i = 0; i < 4; ++i) {
+		sb.schedule<uint64_wrapper>(0, "shared", [&](switchboard::ptr<const uint64_wrapper>&&, std::size_t) {
+			late_received++;
+		});
+	}
+	for (std::thread& t : producers) {
+		t.join();
+	}
+
+	while (first_received.load() != PRODUCERS * EVENTS) {
+		std::this_thread::yield();
+	}
+	ASSERT_LE(late_received.load(), 4 * PRODUCERS * EVENTS);
+	sb.stop();
+}
+
+TEST_F(SwitchboardTest, TestInlineDispatch) {
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer<uint64_wrapper>("inline");
+	switchboard::qos qos_;
+	qos_.dispatch_mode = switchboard::dispatch::inline_publisher;
+
+	std::vector<uint64_t> seen;
+	std::thread::id callback_thread;
+	sb.schedule<uint64_wrapper>(0, "inline", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		callback_thread = std::this_thread::get_id();
+		seen.push_back(*datum);
+		// Publishing back to ourselves is deferred until this callback returns, not recursed into.
+		if (*datum < 3) {
+			writer.put(writer.allocate<uint64_wrapper>(*datum + 10));
+			ASSERT_EQ(seen.back(), *datum);
+		}
+	}, qos_);
+
+	for (uint64_t i = 0; i < 3; ++i) {
+		writer.put(writer.allocate<uint64_wrapper>(i));
+		// Done by the time put() returns, in this thread
+		ASSERT_EQ(callback_thread, std::this_thread::get_id());
+		ASSERT_EQ(seen.size(), 2 * (i + 1));
+	}
+	ASSERT_EQ(seen, (std::vector<uint64_t>{0, 10, 1, 11, 2, 12}));
+
+	std::vector<switchboard::latency_stats> stats = sb.get_latency_stats("inline");
+	ASSERT_EQ(stats.size(), 1);
+	ASSERT_EQ(stats[0].callback_duration.count(), 6);
+
+	ASSERT_THROW(sb.schedule_batch<uint64_wrapper>(0, "inline", [](std::vector<switchboard::ptr<const uint64_wrapper>>&&, std::size_t) { }, 4, std::chrono::microseconds{0}, qos_), std::invalid_argument);
+	sb.stop();
+}
+
+TEST_F(SwitchboardTest, TestScheduleFromCallback) {
+	switchboard sb {nullptr};
+	std::atomic<uint64_t> late_seen {0};
+	auto schedule_late = [&](const std::string& topic_name) {
+		sb.schedule<uint64_wrapper>(0, topic_name, [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+			late_seen += *datum;
+		});
+	};
+
+	// An inline callback is called from within put().
+	switchboard::qos inline_qos;
+	inline_qos.dispatch_mode = switchboard::dispatch::inline_publisher;
+	auto inline_writer = sb.get_writer<uint64_wrapper>("schedules_inline");
+	sb.schedule<uint64_wrapper>(0, "schedules_inline", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		if (*datum == 1) {
+			schedule_late("schedules_inline");
+		}
+	}, inline_qos);
+	inline_writer.put(inline_writer.allocate<uint64_wrapper>(1));
+	inline_writer.put(inline_writer.allocate<uint64_wrapper>(2));
+	while (late_seen.load() != 2) {
+		std::this_thread::yield();
+	}
+
+	// The publisher is blocked in put() until this callback makes room.
+	switchboard::qos blocking_qos;
+	blocking_qos.capacity = 1;
+	auto blocked_writer = sb.get_writer<uint64_wrapper>("schedules_blocked");
+	sb.schedule<uint64_wrapper>(0, "schedules_blocked", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		if (*datum == 10) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{50});
+			schedule_late("schedules_blocked");
+		}
+	}, blocking_qos);
+	for (uint64_t i = 10; i < 14; ++i) {
+		blocked_writer.put(blocked_writer.allocate<uint64_wrapper>(i));
+	}
+	// The late subscription sees the last event, at least.
+	while (late_seen.load() < 2 + 13) {
+		std::this_thread::yield();
+	}
+	sb.stop();
+}
+
+TEST_F(SwitchboardTest, TestInlineCrossPublish) {
+	switchboard sb {nullptr};
+	auto ping_writer = sb.get_writer<uint64_wrapper>("ping");
+	auto pong_writer = sb.get_writer<uint64_wrapper>("pong");
+	switchboard::qos qos_;
+	qos_.dispatch_mode = switchboard::dispatch::inline_publisher;
+
+	// Each callback waits until the other one is running too, then publishes to it: both hold
+	// their own subscription while publishing to the other's.
+	std::atomic<int> running {0};
+	auto both_running = [&] {
+		running++;
+		auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+		while (running.load() < 2 && std::chrono::steady_clock::now() < give_up) {
+			std::this_thread::yield();
+		}
+	};
+	std::atomic<uint64_t> ping_seen {0};
+	std::atomic<uint64_t> pong_seen {0};
+	sb.schedule<uint64_wrapper>(0, "ping", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		ping_seen++;
+		if (*datum == 0) {
+			both_running();
+			pong_writer.put(pong_writer.allocate<uint64_wrapper>(1));
+		}
+	}, qos_);
+	sb.schedule<uint64_wrapper>(0, "pong", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		pong_seen++;
+		if (*datum == 0) {
+			both_running();
+			ping_writer.put(ping_writer.allocate<uint64_wrapper>(1));
+		}
+	}, qos_);
+
+	std::thread pinger {[&] { ping_writer.put(ping_writer.allocate<uint64_wrapper>(0)); }};
+	std::thread ponger {[&] { pong_writer.put(pong_writer.allocate<uint64_wrapper>(0)); }};
+	pinger.join();
+	ponger.join();
+	ASSERT_EQ(ping_seen.load(), 2);
+	ASSERT_EQ(pong_seen.load(), 2);
+	sb.stop();
+}
+
+TEST_F(SwitchboardTest, TestTopicDescriptors) {
+	static constexpr switchboard::topic_descriptor<uint64_wrapper> numbers {"numbers"};
+	switchboard sb {nullptr};
+	auto writer = sb.get_writer(numbers);
+	auto reader = sb.get_reader(numbers);
+	std::atomic<uint64_t> received {0};
+	sb.schedule(0, numbers, [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		received = *datum;
+	});
+
+	ASSERT_EQ(reader.get_ro_nullable(), nullptr);
+	writer.put(writer.allocate<uint64_wrapper>(7));
+	switchboard::ptr<const uint64_wrapper> latest = reader.get_ro();
+	ASSERT_EQ(*latest, 7);
+	ASSERT_EQ(typeid(*latest), typeid(uint64_wrapper));
+	while (received.load() != 7) {
+		std::this_thread::yield();
+	}
+
+	// The type is checked once, when the handle is made.
+	ASSERT_THROW(sb.get_reader<copy_counted_event>("numbers"), std::runtime_error);
+	ASSERT_THROW(sb.get_writer<copy_counted_event>(numbers.name), std::runtime_error);
+	sb.stop();
+}
+
+TEST_F(SwitchboardTest, TestConcurrentTopicTypes) {
+	const std::size_t TOPICS = 200;
+	switchboard sb {nullptr};
+	std::vector<bool> numbers_threw (TOPICS);
+	std::vector<bool> counted_threw (TOPICS);
+	std::atomic<int> ready {0};
+	auto register_all = [&](auto make_handle, std::vector<bool>& threw) {
+		ready++;
+		while (ready.load() < 2) {
+			std::this_thread::yield();
+		}
+		for (std::size_t i = 0; i < TOPICS; ++i) {
+			try {
+				make_handle("topic_" + std::to_string(i));
+			} catch (const std::runtime_error&) {
+				threw[i] = true;
+			}
+		}
+	};
+	std::thread numbers {[&] {
+		register_all([&](const std::string& topic_name) { sb.get_writer<uint64_wrapper>(topic_name); }, numbers_threw);
+	}};
+	std::thread counted {[&] {
+		register_all([&](const std::string& topic_name) { sb.get_reader<copy_counted_event>(topic_name); }, counted_threw);
+	}};
+	numbers.join();
+	counted.join();
+
+	// Whichever type got to a topic first, the other one was refused.
+	for (std::size_t i = 0; i < TOPICS; ++i) {
+		ASSERT_NE(numbers_threw[i], counted_threw[i]);
+	}
+	sb.stop();
+}
+
+/// Resubmits itself from the worker running it, until it has run `runs` times.
+struct resubmitting_task : public work_stealing_executor::task {
+	work_stealing_executor* executor;
+	std::atomic<std::size_t>* total;
+	std::size_t runs;
+
+	void run() override {
+		(*total)++;
+		if (--runs > 0) {
+			executor->submit(this);
+		}
+	}
+};
+
+static std::chrono::nanoseconds process_cpu_time() {
+	timespec now {};
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+	return std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+}
+
+TEST_F(SwitchboardTest, TestEventCountSleeps) {
+	event_count submitted;
+
+	// A key from before a notify does not wait.
+	std::uint64_t stale = submitted.key();
+	submitted.notify();
+	submitted.wait(stale);
+
+	// As take() does when its scan starves: wait for a submit which does not come yet.
+	std::atomic<bool> woken {false};
+	std::chrono::nanoseconds waiter_cpu {0};
+	std::thread waiter {[&] {
+		submitted.wait(submitted.key());
+		woken = true;
+		timespec now {};
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+		waiter_cpu = std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+	}};
+	std::this_thread::sleep_for(std::chrono::milliseconds{300});
+	ASSERT_FALSE(woken.load());
+	submitted.notify();
+	waiter.join();
+	ASSERT_TRUE(woken.load());
+	// It slept rather than spun.
+	ASSERT_LT(waiter_cpu, std::chrono::milliseconds{50});
+}
+
+TEST_F(SwitchboardTest, TestExecutorSleepsWhenIdle) {
+	const std::size_t TASKS = 64;
+	const std::size_t RUNS = 500;
+	std::atomic<std::size_t> total {0};
+	// Outlives the executor, whose workers may still be returning from them.
+	std::vector<resubmitting_task> tasks (TASKS);
+	work_stealing_executor executor {4};
+
+	// Workers taking and stealing while others submit, so that scans miss.
+	std::vector<std::thread> submitters;
+	for (std::size_t s = 0; s < 2; ++s) {
+		submitters.emplace_back([&, s] {
+			for (std::size_t i = s; i < TASKS; i += 2) {
+				tasks[i].executor = &executor;
+				tasks[i].total = &total;
+				tasks[i].runs = RUNS;
+				executor.submit(&tasks[i]);
+			}
+		});
+	}
+	for (std::thread& t : submitters) {
+		t.join();
+	}
+	while (total.load() != TASKS * RUNS) {
+		std::this_thread::yield();
+	}
+
+	// Then no worker should be left scanning.
+	std::this_thread::sleep_for(std::chrono::milliseconds{50});
+	const std::chrono::nanoseconds before = process_cpu_time();
+	std::this_thread::sleep_for(std::chrono::milliseconds{300});
+	ASSERT_LT(process_cpu_time() - before, std::chrono::milliseconds{50});
+}
+
+TEST_F(SwitchboardTest, TestExecutorSerializes) {
+	const uint64_t MAX_ITERATIONS = 2000;
+	const std::size_t SUBSCRIPTIONS = 6;
+
+	switchboard sb {nullptr, 3};
+
+	std::vector<std::atomic<uint64_t>> last_datum (SUBSCRIPTIONS);
+	std::vector<std::atomic<uint64_t>> last_it (SUBSCRIPTIONS);
+	std::vector<std::atomic<bool>> running (SUBSCRIPTIONS);
+	for (std::size_t s = 0; s < SUBSCRIPTIONS; ++s) {
+		std::string topic_name = (s % 2 == 0) ? "even" : "odd";
+		sb.schedule<uint64_wrapper>(s, topic_name, [&, s](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t it) {
+			// Callbacks of one subscription never overlap, even on a shared pool
+			ASSERT_FALSE(running[s].exchange(true));
+			ASSERT_EQ(last_it[s] + 1, it);
+			ASSERT_EQ(last_datum[s] + 1, *datum);
+			last_it[s] = it;
+			last_datum[s] = *datum;
+			running[s] = false;
+		});
+	}
+
+	std::thread odd_writer {[&sb] {
+		auto writer = sb.get_writer<uint64_wrapper>("odd");
+		for (uint64_t i = 1; i < MAX_ITERATIONS; ++i) {
+			writer.put(writer.allocate<uint64_wrapper>(i));
+		}
+	}};
+	auto writer = sb.get_writer<uint64_wrapper>("even");
+	for (uint64_t i = 1; i < MAX_ITERATIONS; ++i) {
+		writer.put(writer.allocate<uint64_wrapper>(i));
+	}
+	odd_writer.join();
+
+	for (std::size_t s = 0; s < SUBSCRIPTIONS; ++s) {
+		while (last_it[s] != MAX_ITERATIONS - 1) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		}
+	}
+	sb.stop();
+}
+
+/**
+ * Publishes 1..10 to a subscriber with capacity 2, which is stuck in the callback for 1 until the
+ * publisher is done (or, for the blocking policy, until a while later).
+ */
+static std::vector<uint64_t> run_overflow(std::size_t executor_threads, switchboard::overflow_policy policy, std::size_t expected) {
+	switchboard sb {nullptr, executor_threads};
+	std::atomic<bool> started {false};
+	std::atomic<bool> gate {false};
+	std::mutex seen_lock;
+	std::vector<uint64_t> seen;
+	sb.schedule<uint64_wrapper>(0, "bounded", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+		started = true;
+		while (!gate.load()) {
+			std::this_thread::yield();
+		}
+		const std::lock_guard lock {seen_lock};
+		seen.push_back(*datum);
+	}, {2, policy});
+
+	auto writer = sb.get_writer<uint64_wrapper>("bounded");
+	writer.put(writer.allocate(1));
+	while (!started.load()) {
+		std::this_thread::yield();
+	}
+	std::thread opener {[&] {
+		if (policy == switchboard::overflow_policy::block) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{50});
+			gate = true;
+		}
+	}};
+	for (uint64_t i = 2; i <= 10; ++i) {
+		writer.put(writer.allocate(i));
+	}
+	opener.join();
+	gate = true;
+
+	while (true) {
+		const std::lock_guard lock {seen_lock};
+		if (seen.size() >= expected) {
+			break;
+		}
+	}
+	sb.stop();
+	return seen;
+}
+
+TEST_F(SwitchboardTest, TestOverflowPolicies) {
+	using policy = switchboard::overflow_policy;
+	for (std::size_t threads : {0, 2}) {
+		ASSERT_EQ(run_overflow(threads, policy::drop_newest, 3), (std::vector<uint64_t>{1, 2, 3}));
+		ASSERT_EQ(run_overflow(threads, policy::drop_oldest, 3), (std::vector<uint64_t>{1, 9, 10}));
+		ASSERT_EQ(run_overflow(threads, policy::keep_latest, 2), (std::vector<uint64_t>{1, 10}));
+		ASSERT_EQ(run_overflow(threads, policy::block, 10), (std::vector<uint64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+	}
+}
+
+/**
+ * Publishes 1..ROUND_SIZE to a keep_latest subscriber which keeps up, so the subscriber often holds
+ * an event it has dequeued but not yet accounted for as the publisher evicts. The last event must
+ * never be the one evicted.
+ */
+TEST_F(SwitchboardTest, TestKeepLatestKeepsNewest) {
+	static constexpr uint64_t ROUNDS = 200;
+	static constexpr uint64_t ROUND_SIZE = 100;
+	for (std::size_t threads : {0, 2}) {
+		switchboard sb {nullptr, threads};
+		std::atomic<uint64_t> last {0};
+		sb.schedule<uint64_wrapper>(0, "latest", [&](switchboard::ptr<const uint64_wrapper>&& datum, std::size_t) {
+			last = *datum;
+		}, {1, switchboard::overflow_policy::keep_latest});
+
+		auto writer = sb.get_writer<uint64_wrapper>("latest");
+		for (uint64_t round = 1; round <= ROUNDS; ++round) {
+			for (uint64_t i = 1; i <= ROUND_SIZE; ++i) {
+				writer.put(writer.allocate(round * ROUND_SIZE + i));
+			}
+			const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+			while (last.load() != (round + 1) * ROUND_SIZE && std::chrono::steady_clock::now() < give_up) {
+				std::this_thread::yield();
+			}
+			ASSERT_EQ(last.load(), (round + 1) * ROUND_SIZE);
+		}
+		sb.stop();
+	}
+}
+
+TEST_F(SwitchboardTest, TestBatch) {
+	const uint64_t EVENTS = 100;
+	const std::size_t MAX_BATCH = 8;
+	for (std::size_t threads : {0, 2}) {
+		switchboard sb {nullptr, threads};
+		std::atomic<bool> gate {false};
+		std::atomic<uint64_t> last_datum {0};
+		std::atomic<std::size_t> largest_batch {0};
+		std::size_t last_it = 0;
+		sb.schedule_batch<uint64_wrapper>(0, "batched", [&](std::vector<switchboard::ptr<const uint64_wrapper>>&& batch, std::size_t it) {
+			while (!gate.load()) {
+				std::this_thread::yield();
+			}
+			ASSERT_EQ(last_it + 1, it);
+			last_it = it;
+			ASSERT_GE(batch.size(), 1);
+			ASSERT_LE(batch.size(), MAX_BATCH);
+			largest_batch = std::max(largest_batch.load(), batch.size());
+			for (const switchboard::ptr<const uint64_wrapper>& datum : batch) {
+				ASSERT_EQ(last_datum + 1, *datum);
+				last_datum = *datum;
+			}
+		}, MAX_BATCH);
+
+		auto writer = sb.get_writer<uint64_wrapper>("batched");
+		for (uint64_t i = 1; i <= EVENTS; ++i) {
+			writer.put(writer.allocate(i));
+		}
+		gate = true;
+		while (last_datum != EVENTS) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+		// The subscriber was held up, so events must have piled up into full batches.
+		ASSERT_EQ(largest_batch, MAX_BATCH);
+		sb.stop();
+	}
+}
+
+TEST_F(SwitchboardTest, TestBatchWindow) {
+	switchboard sb {nullptr};
+	std::atomic<std::size_t> batches {0};
+	std::atomic<std::size_t> events {0};
+	sb.schedule_batch<uint64_wrapper>(0, "windowed", [&](std::vector<switchboard::ptr<const uint64_wrapper>>&& batch, std::size_t) {
+		batches++;
+		events += batch.size();
+	}, 64, std::chrono::milliseconds{500});
+
+	auto writer = sb.get_writer<uint64_wrapper>("windowed");
+	for (uint64_t i = 1; i <= 5; ++i) {
+		writer.put(writer.allocate(i));
+	}
+	while (events != 5) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+	// All five arrived within the window of the first.
+	ASSERT_EQ(batches, 1);
+	sb.stop();
+}
+
+class timed_event : public switchboard::event {
+public:
+	timed_event(time_point time_) : time{time_} { }
+	time_point time;
+};
+
+static time_point at_ms(long ms) {
+	return time_point{std::chrono::milliseconds{ms}};
+}
+
+static std::vector<long> times_ms(const std::vector<switchboard::ptr<const timed_event>>& events) {
+	std::vector<long> times;
+	for (const switchboard::ptr<const timed_event>& ev : events) {
+		times.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(ev->time.time_since_epoch()).count());
+	}
+	return times;
+}
+
+TEST_F(SwitchboardTest, TestHistory) {
+	switchboard sb {nullptr};
+	auto reader = sb.get_reader<timed_event>("timed");
+	auto writer = sb.get_writer<timed_event>("timed");
+	reader.keep_history(4, [](const timed_event& ev) { return ev.time; });
+
+	for (long ms = 10; ms <= 70; ms += 10) {
+		writer.put(writer.allocate(at_ms(ms)));
+	}
+
+	// Only the last 4 are kept
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(0), at_ms(100))), (std::vector<long>{40, 50, 60, 70}));
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(35), at_ms(60))), (std::vector<long>{40, 50, 60}));
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(51), at_ms(59))), (std::vector<long>{}));
+	ASSERT_EQ(reader.get_latest_before(at_ms(40)), nullptr);
+	ASSERT_EQ(reader.get_latest_before(at_ms(45))->time, at_ms(40));
+	ASSERT_EQ(reader.get_latest_before(at_ms(1000))->time, at_ms(70));
+	ASSERT_EQ(reader.get_earliest_after(at_ms(60))->time, at_ms(70));
+	ASSERT_EQ(reader.get_earliest_after(at_ms(70)), nullptr);
+
+	// Growing keeps what is there
+	reader.keep_history(8, [](const timed_event& ev) { return ev.time; });
+	writer.put(writer.allocate(at_ms(80)));
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(0), at_ms(100))), (std::vector<long>{40, 50, 60, 70, 80}));
+
+	// Time going backwards restarts the history
+	writer.put(writer.allocate(at_ms(5)));
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(0), at_ms(100))), (std::vector<long>{5}));
+}
+
+TEST_F(SwitchboardTest, TestHistoryRemembers) {
+	switchboard sb {nullptr};
+	auto reader = sb.get_reader<timed_event>("timed");
+	auto writer = sb.get_writer<timed_event>("timed");
+	// Keeps a copy, shifted by 1 ms so that it can be told apart
+	reader.keep_history(4, [](const timed_event& ev) { return ev.time; }, [](const timed_event& ev) {
+		return switchboard::make_ptr<timed_event>(ev.time + std::chrono::milliseconds{1});
+	});
+	// A later reader cannot change how events are indexed or kept
+	reader.keep_history(4, [](const timed_event&) { return at_ms(0); });
+
+	auto published = writer.allocate(at_ms(10));
+	const timed_event* published_event = published.get();
+	writer.put(std::move(published));
+	writer.put(writer.allocate(at_ms(20)));
+
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(0), at_ms(100))), (std::vector<long>{11, 21}));
+	ASSERT_EQ(times_ms(reader.get_range(at_ms(5), at_ms(15))), (std::vector<long>{11}));
+	ASSERT_NE(reader.get_latest_before(at_ms(15)).get(), published_event);
+}
+
+/// Keeps the records of interest for inspection.
+class capturing_logger : public record_logger {
+public:
+	~capturing_logger() override {
+		for (const record& r : _m_records) {
+			r.mark_used();
+		}
+	}
+
+	void log(const record& r) override {
+		r.mark_used();
+		const std::lock_guard lock {_m_lock};
+		_m_records.push_back(r);
+	}
+
+	std::vector<record> get(const std::string& table) {
+		const std::lock_guard lock {_m_lock};
+		std::vector<record> matching;
+		for (const record& r : _m_records) {
+			if (r.get_record_header().get_name() == table) {
+				matching.push_back(r);
+			}
+		}
+		// Growing the vector copies, so mark once it is done.
+		for (const record& r : matching) {
+			r.mark_used();
+		}
+		return matching;
+	}
+
+private:
+	std::mutex _m_lock;
+	std::vector<record> _m_records;
+};
+
+TEST_F(SwitchboardTest, TestDeadlineScheduling) {
+	phonebook pb;
+	auto logger = std::make_shared<capturing_logger>();
+	pb.register_impl<record_logger>(logger);
+	std::vector<std::string> order;
+	std::mutex order_lock;
+	std::atomic<bool> started {false};
+	std::atomic<bool> gate {false};
+	{
+		// One worker, so that the order is up to the executor
+		switchboard sb {&pb, 1};
+		sb.schedule<uint64_wrapper>(0, "blocker", [&](switchboard::ptr<const uint64_wrapper>&&, std::size_t) {
+			started = true;
+			while (!gate.load()) {
+				std::this_thread::yield();
+			}
+		});
+		for (const std::string topic_name : {"lazy", "urgent"}) {
+			switchboard::qos qos_;
+			if (topic_name == "urgent") {
+				qos_.deadline = std::chrono::milliseconds{1};
+			}
+			sb.schedule<uint64_wrapper>(0, topic_name, [&, topic_name](switchboard::ptr<const uint64_wrapper>&&, std::size_t) {
+				const std::lock_guard lock {order_lock};
+				order.push_back(topic_name);
+			}, qos_);
+		}
+
+		auto blocker = sb.get_writer<uint64_wrapper>("blocker");
+		blocker.put(blocker.allocate(1));
+		while (!started.load()) {
+			std::this_thread::yield();
+		}
+
+		// Published first, but best-effort
+		auto lazy = sb.get_writer<uint64_wrapper>("lazy");
+		lazy.put(lazy.allocate(1));
+		auto urgent = sb.get_writer<uint64_wrapper>("urgent");
+		urgent.put(urgent.allocate(1));
+		std::this_thread::sleep_for(std::chrono::milliseconds{5});
+		gate = true;
+
+		while (true) {
+			const std::lock_guard lock {order_lock};
+			if (order.size() == 2) {
+				break;
+			}
+		}
+		sb.stop();
+	}
+	ASSERT_EQ(order, (std::vector<std::string>{"urgent", "lazy"}));
+
+	// The worker was held up for longer than the deadline
+	std::vector<record> misses = logger->get("switchboard_deadline_miss");
+	ASSERT_EQ(misses.size(), 1);
+	ASSERT_EQ(misses[0].get_value<std::string>(1), "urgent");
+	ASSERT_GT(misses[0].get_value<std::chrono::nanoseconds>(4), std::chrono::milliseconds{3});
+}
+
+TEST_F(SwitchboardTest, TestStopIsFast) {
+	switchboard sb {nullptr};
+	std::atomic<std::size_t> callbacks {0};
+	for (std::size_t s = 0; s < 20; ++s) {
+		sb.schedule<uint64_wrapper>(s, "idle" + std::to_string(s % 4), [&](switchboard::ptr<const uint64_wrapper>&&, std::size_t) {
+			callbacks++;
+		});
+	}
+	auto writer = sb.get_writer<uint64_wrapper>("idle0");
+	writer.put(writer.allocate(1));
+	while (callbacks != 5) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+
+	// Idle subscription threads are woken up rather than polled, so stopping does not wait out a timeout per thread.
+	auto start = std::chrono::steady_clock::now();
+	sb.stop();
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{100});
+}
+
+TEST_F(SwitchboardTest, TestLatencyStats) {
+	phonebook pb;
+	auto logger = std::make_shared<capturing_logger>();
+	pb.register_impl<record_logger>(logger);
+	std::atomic<std::size_t> callbacks {0};
+	{
+		switchboard sb {&pb};
+		sb.schedule<uint64_wrapper>(7, "timed", [&](switchboard::ptr<const uint64_wrapper>&&, std::size_t) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{2});
+			callbacks++;
+		});
+		auto writer = sb.get_writer<uint64_wrapper>("timed");
+		for (std::size_t i = 0; i < 10; ++i) {
+			writer.put(writer.allocate(i));
+			std::this_thread::sleep_for(std::chrono::milliseconds{5});
+		}
+		while (callbacks != 10) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+
+		ASSERT_TRUE(sb.get_latency_stats("missing").empty());
+		std::vector<switchboard::latency_stats> stats = sb.get_latency_stats("timed");
+		ASSERT_EQ(stats.size(), 1);
+		ASSERT_EQ(stats[0].plugin_id, 7);
+		ASSERT_EQ(stats[0].queue_delay.count(), 10);
+		ASSERT_EQ(stats[0].callback_duration.count(), 10);
+		ASSERT_GE(stats[0].callback_duration.percentile(0.5), std::chrono::milliseconds{2});
+		ASSERT_EQ(stats[0].inter_arrival.count(), 9);
+		ASSERT_GE(stats[0].inter_arrival.percentile(0.5), std::chrono::milliseconds{5});
+		sb.stop();
+	}
+
+	// At least the final set, one record per metric
+	std::vector<record> logged = logger->get("switchboard_latency");
+	ASSERT_GE(logged.size(), 3);
+	ASSERT_EQ(logged.back().get_value<std::string>(2), "inter_arrival");
+	ASSERT_EQ(logged.back().get_value<std::size_t>(3), 9);
+}
+
 }
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <mutex>
+#include "../thread_placement.hpp"
+#include "../switchboard.hpp"
+
+namespace ILLIXR {
+
+class placement_logger : public record_logger {
+public:
+	~placement_logger() override {
+		for (const record& r : _m_records) {
+			r.mark_used();
+		}
+	}
+
+	void log(const record& r) override {
+		r.mark_used();
+		const std::lock_guard lock {_m_lock};
+		_m_records.push_back(r);
+	}
+
+	std::vector<record> get() {
+		const std::lock_guard lock {_m_lock};
+		std::vector<record> ret {_m_records};
+		for (const record& r : ret) {
+			r.mark_used();
+		}
+		return ret;
+	}
+
+private:
+	std::mutex _m_lock;
+	std::vector<record> _m_records;
+};
+
+static std::string thread_name() {
+	char name[16];
+	pthread_getname_np(pthread_self(), name, sizeof(name));
+	return name;
+}
+
+class ThreadPlacementTest : public ::testing::Test { };
+
+TEST_F(ThreadPlacementTest, TestParse) {
+	std::vector<thread_placement::rule> rules = thread_placement::parse("timewarp_gl=3:fifo:80;sqlite:*=0,2-3:other;;offline_imu_cam=");
+	ASSERT_EQ(rules.size(), 3);
+
+	ASSERT_EQ(rules[0].pattern, "timewarp_gl");
+	ASSERT_EQ(rules[0].cpus, std::vector<int>{3});
+	ASSERT_EQ(rules[0].policy, SCHED_FIFO);
+	ASSERT_EQ(rules[0].priority, 80);
+
+	ASSERT_EQ(rules[1].cpus, (std::vector<int>{0, 2, 3}));
+	ASSERT_EQ(rules[1].policy, SCHED_OTHER);
+	ASSERT_TRUE(rules[1].matches("sqlite:switchboard_latency"));
+	ASSERT_FALSE(rules[1].matches("sqlite"));
+
+	ASSERT_TRUE(rules[2].cpus.empty());
+	ASSERT_FALSE(rules[2].policy);
+	ASSERT_FALSE(rules[2].matches("offline_imu_cam2"));
+
+	ASSERT_THROW(thread_placement::parse("no_equals"), std::runtime_error);
+	ASSERT_THROW(thread_placement::parse("a=0:deadline"), std::runtime_error);
+	ASSERT_THROW(thread_placement::parse("a=0:fifo:1000"), std::runtime_error);
+	ASSERT_THROW(thread_placement::parse("a=3-1"), std::runtime_error);
+}
+
+TEST_F(ThreadPlacementTest, TestApply) {
+	// Pin to a CPU which we are already allowed on, so this works on any machine.
+	cpu_set_t allowed;
+	ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+	int cpu = 0;
+	while (!CPU_ISSET(cpu, &allowed)) {
+		++cpu;
+	}
+
+	auto logger = std::make_shared<placement_logger>();
+	thread_placement placement {logger, "worker*=" + std::to_string(cpu) + ":other:0"};
+
+	std::thread{[&] {
+		ASSERT_TRUE(placement.apply("worker_with_a_long_name"));
+		ASSERT_EQ(thread_name(), "worker_with_a_l");
+		cpu_set_t cpus;
+		ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus), 0);
+		ASSERT_EQ(CPU_COUNT(&cpus), 1);
+		ASSERT_TRUE(CPU_ISSET(cpu, &cpus));
+
+		// No matching rule: only named
+		ASSERT_TRUE(placement.apply("other"));
+		ASSERT_EQ(thread_name(), "other");
+	}}.join();
+
+	std::vector<record> records = logger->get();
+	ASSERT_EQ(records.size(), 2);
+	ASSERT_EQ(records[0].get_value<std::string>(0), "worker_with_a_long_name");
+	ASSERT_EQ(records[0].get_value<std::string>(2), std::to_string(cpu));
+	ASSERT_EQ(records[0].get_value<std::string>(3), "other");
+	ASSERT_EQ(records[0].get_value<std::string>(5), "");
+	ASSERT_EQ(records[1].get_value<std::string>(2), "");
+}
+
+TEST_F(ThreadPlacementTest, TestSwitchboardThreads) {
+	phonebook pb;
+	auto logger = std::make_shared<placement_logger>();
+	pb.register_impl<record_logger>(logger);
+	pb.register_impl<thread_placement>(std::make_shared<thread_placement>(logger));
+
+	class number : public switchboard::event {
+	public:
+		number(int value_) : value{value_} { }
+		int value;
+	};
+
+	for (std::size_t executor_threads : {0, 1}) {
+		switchboard sb {&pb, executor_threads};
+		std::promise<std::string> name;
+		sb.schedule<number>(0, "numbers", [&](switchboard::ptr<const number>&&, std::size_t) {
+			name.set_value(thread_name());
+		});
+		auto writer = sb.get_writer<number>("numbers");
+		writer.put(writer.allocate(1));
+		ASSERT_EQ(name.get_future().get(), executor_threads ? "sb_worker:0" : "sb:numbers");
+		sb.stop();
+	}
+}
+
+}
@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "../topic_log.hpp"
+
+namespace ILLIXR {
+
+class TopicLogTest : public ::testing::Test {
+protected:
+	void TearDown() override {
+		std::remove(path.c_str());
+	}
+
+	const std::string path = "/tmp/illixr_test_topic_log_" + std::to_string(getpid());
+};
+
+using wrapped = switchboard::event_wrapper<std::uint64_t>;
+
+TEST_F(TopicLogTest, TestRoundTrip) {
+	{
+		topic_log_writer log {path};
+		std::uint32_t a = log.declare("a", typeid(wrapped));
+		std::uint32_t b = log.declare("b", typeid(int));
+		// Bigger than the initial mapping, so it has to grow
+		std::vector<std::byte> big (40 * 1024 * 1024, std::byte{7});
+		log.append(a, time_point{std::chrono::milliseconds{1}}, 3, [](std::byte* dst) { std::memcpy(dst, "abc", 3); });
+		log.append(b, time_point{std::chrono::milliseconds{2}}, big.size(), [&](std::byte* dst) { std::memcpy(dst, big.data(), big.size()); });
+		std::uint32_t c = log.declare("c", typeid(wrapped));
+		log.append(c, time_point{std::chrono::milliseconds{3}}, 0, [](std::byte*) { });
+		log.append(a, time_point{std::chrono::milliseconds{4}}, 1, [](std::byte* dst) { *dst = std::byte{'z'}; });
+	}
+	// What is left of a log whose recorder was killed
+	{
+		std::ofstream tail {path, std::ios::binary | std::ios::app};
+		tail << std::string(4096, '\0');
+	}
+
+	std::shared_ptr<topic_log_reader> reader = topic_log_reader::open(path);
+	topic_log_reader::entry entry;
+	std::vector<std::uint32_t> topics;
+	std::vector<long> times;
+	std::vector<std::size_t> sizes;
+	while (reader->next(entry)) {
+		topics.push_back(entry.topic);
+		times.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(entry.time.time_since_epoch()).count());
+		sizes.push_back(entry.size);
+		if (entry.topic == 1) {
+			ASSERT_EQ(entry.data[entry.size - 1], std::byte{7});
+		}
+	}
+	ASSERT_EQ(topics, (std::vector<std::uint32_t>{0, 1, 2, 0}));
+	ASSERT_EQ(times, (std::vector<long>{1, 2, 3, 4}));
+	ASSERT_EQ(sizes, (std::vector<std::size_t>{3, 40 * 1024 * 1024, 0, 1}));
+	ASSERT_EQ(reader->topics().size(), 3);
+	ASSERT_EQ(reader->topics()[2].name, "c");
+	ASSERT_EQ(reader->topics()[1].type_name, typeid(int).name());
+}
+
+TEST_F(TopicLogTest, TestRecordAndReplay) {
+	auto clock = std::make_shared<RelativeClock>();
+	clock->start();
+	topic_log_types types;
+	types.add<wrapped>();
+	{
+		topic_log_writer log {path};
+		switchboard sb {nullptr};
+		types.record(typeid(wrapped), log, sb, *clock, 0, "numbers");
+		auto writer = sb.get_writer<wrapped>("numbers");
+		for (std::uint64_t i = 0; i < 100; ++i) {
+			writer.put(writer.allocate(i));
+		}
+		// Stopping discards what the recorder has not got to.
+		while (sb.get_latency_stats("numbers")[0].callback_duration.count() != 100) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+		sb.stop();
+	}
+
+	std::shared_ptr<topic_log_reader> reader = topic_log_reader::open(path);
+	switchboard sb {nullptr};
+	std::vector<std::uint64_t> replayed;
+	std::mutex replayed_lock;
+	sb.schedule<wrapped>(0, "numbers", [&](switchboard::ptr<const wrapped>&& this_event, std::size_t) {
+		const std::lock_guard lock {replayed_lock};
+		replayed.push_back(**this_event);
+	});
+	topic_log_reader::entry entry;
+	std::vector<topic_log_types::publisher> publishers;
+	time_point last {std::chrono::nanoseconds{0}};
+	while (reader->next(entry)) {
+		if (publishers.size() < reader->topics().size()) {
+			ASSERT_EQ(reader->topics()[0].name, "numbers");
+			publishers.push_back(types.make_publisher(reader->topics()[0].type_name, sb, "numbers"));
+		}
+		ASSERT_GE(entry.time, last);
+		last = entry.time;
+		publishers[entry.topic](entry.data, entry.size, reader->pin());
+	}
+	while (true) {
+		const std::lock_guard lock {replayed_lock};
+		if (replayed.size() == 100) {
+			break;
+		}
+	}
+	sb.stop();
+	for (std::uint64_t i = 0; i < 100; ++i) {
+		ASSERT_EQ(replayed[i], i);
+	}
+}
+
+}
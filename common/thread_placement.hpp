@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "phonebook.hpp"
+#include "record_logger.hpp"
+
+namespace ILLIXR {
+
+	const record_header __thread_placement_header {"thread_placement", {
+		{"name", typeid(std::string)},
+		{"tid", typeid(std::size_t)},
+		{"cpus", typeid(std::string)},
+		{"policy", typeid(std::string)},
+		{"priority", typeid(std::size_t)},
+		{"error", typeid(std::string)},
+	}};
+
+	/**
+	 * @brief Names ILLIXR's threads, and pins them to CPUs and scheduling classes.
+	 *
+	 * Every long-lived thread calls `apply()` with its own name as it starts: threadloops use the
+	 * plugin name, switchboard subscriptions `sb:<topic>`, switchboard workers `sb_worker:<index>`,
+	 * the SQLite record logger `sqlite:<table>` (or `sqlite:writer_<index>`), the `record_flusher`
+	 * `log_flusher`, and the `flight_recorder` `flight_recorder`. The thread gets that name
+	 * (truncated to the 15 characters Linux allows), and the first matching rule decides its placement.
+	 *
+	 * Rules are separated by `;`, and look like `<name>=<cpus>[:<policy>[:<priority>]]`:
+	 * \code
+	 * timewarp_gl=3:fifo:80;sb:imu_cam=2:fifo:70;sqlite:*=0-1:other
+	 * \endcode
+	 * A name ending in `*` matches any thread whose name starts with the rest. `cpus` is a list such as
+	 * `0,2-3`, or empty to leave the affinity alone. `policy` is `fifo`, `rr` or `other` (the default
+	 * of the process), or absent to leave it alone.
+	 *
+	 * Real-time policies need `CAP_SYS_NICE` (or a suitable `RLIMIT_RTPRIO`). Placement which the OS
+	 * refuses is reported and logged, but the thread still runs.
+	 */
+	class thread_placement : public phonebook::service {
+	public:
+		struct rule {
+			std::string pattern;
+			/// Empty to leave the affinity alone
+			std::vector<int> cpus;
+			/// SCHED_FIFO, SCHED_RR, or SCHED_OTHER
+			std::optional<int> policy;
+			int priority = 0;
+
+			bool matches(const std::string& name) const {
+				if (!pattern.empty() && pattern.back() == '*') {
+					return name.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0;
+				}
+				return name == pattern;
+			}
+		};
+
+		/**
+		 * @brief Parses @p rules (see the class documentation); @p record_logger_ may be null.
+		 *
+		 * @throws if @p rules is malformed.
+		 */
+		thread_placement(std::shared_ptr<record_logger> record_logger_, const std::string& rules = "")
+			: _m_record_logger{record_logger_}
+			, _m_rules{parse(rules)}
+		{ }
+
+		const std::vector<rule>& rules() const { return _m_rules; }
+
+		/**
+		 * @brief Names the calling thread @p name and applies the first rule which matches it.
+		 *
+		 * Thread-safe
+		 *
+		 * @return false if the OS refused some of the placement.
+		 */
+		bool apply(const std::string& name) const {
+			std::string error;
+			// Linux thread names are limited to 16 bytes, including the terminator.
+			if (int ret = pthread_setname_np(pthread_self(), name.substr(0, 15).c_str())) {
+				add_error(error, "setname", ret);
+			}
+
+			const rule* match = nullptr;
+			for (const rule& r : _m_rules) {
+				if (r.matches(name)) {
+					match = &r;
+					break;
+				}
+			}
+
+			if (match && !match->cpus.empty()) {
+				cpu_set_t cpus;
+				CPU_ZERO(&cpus);
+				for (int cpu : match->cpus) {
+					CPU_SET(cpu, &cpus);
+				}
+				if (int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+					add_error(error, "setaffinity", ret);
+				}
+			}
+
+			if (match && match->policy) {
+				sched_param param {};
+				param.sched_priority = match->priority;
+				if (int ret = pthread_setschedparam(pthread_self(), *match->policy, &param)) {
+					add_error(error, "setschedparam", ret);
+				}
+			}
+
+			if (!error.empty()) {
+				std::cerr << "thread_placement: " << name << ": " << error << std::endl;
+			}
+
+			if (_m_record_logger) {
+				_m_record_logger->log(record{__thread_placement_header, {
+					{name},
+					{static_cast<std::size_t>(syscall(SYS_gettid))},
+					{match ? cpus_to_string(match->cpus) : std::string{}},
+					{match && match->policy ? policy_to_string(*match->policy) : std::string{}},
+					{static_cast<std::size_t>(match ? match->priority : 0)},
+					{error},
+				}});
+			}
+			return error.empty();
+		}
+
+		/**
+		 * @brief Parses a `;`-separated list of rules.
+		 *
+		 * @throws if @p rules is malformed.
+		 */
+		static std::vector<rule> parse(const std::string& rules) {
+			std::vector<rule> ret;
+			for (const std::string& text : split(rules, ';')) {
+				if (text.empty()) {
+					continue;
+				}
+				const std::size_t eq = text.find('=');
+				if (eq == std::string::npos || eq == 0) {
+					throw std::runtime_error{"thread_placement: expected <name>=<cpus>[:<policy>[:<priority>]] in '" + text + "'"};
+				}
+				rule r;
+				r.pattern = text.substr(0, eq);
+				const std::vector<std::string> fields = split(text.substr(eq + 1), ':');
+				if (fields.size() > 3) {
+					throw std::runtime_error{"thread_placement: too many fields in '" + text + "'"};
+				}
+				r.cpus = parse_cpus(fields[0]);
+				if (fields.size() > 1 && !fields[1].empty()) {
+					r.policy = parse_policy(fields[1]);
+				}
+				if (fields.size() > 2 && !fields[2].empty()) {
+					r.priority = std::stoi(fields[2]);
+				}
+				if (r.policy && (r.priority < sched_get_priority_min(*r.policy) || r.priority > sched_get_priority_max(*r.policy))) {
+					throw std::runtime_error{"thread_placement: priority out of range in '" + text + "'"};
+				}
+				ret.push_back(std::move(r));
+			}
+			return ret;
+		}
+
+	private:
+		const std::shared_ptr<record_logger> _m_record_logger;
+		const std::vector<rule> _m_rules;
+
+		static void add_error(std::string& error, const char* call, int ret) {
+			if (!error.empty()) {
+				error += "; ";
+			}
+			error += std::string{call} + ": " + std::strerror(ret);
+		}
+
+		static std::vector<std::string> split(const std::string& text, char delimiter) {
+			std::vector<std::string> ret;
+			std::size_t begin = 0;
+			while (true) {
+				const std::size_t end = text.find(delimiter, begin);
+				ret.push_back(text.substr(begin, end - begin));
+				if (end == std::string::npos) {
+					return ret;
+				}
+				begin = end + 1;
+			}
+		}
+
+		static std::vector<int> parse_cpus(const std::string& text) {
+			std::vector<int> cpus;
+			for (const std::string& range : split(text, ',')) {
+				if (range.empty()) {
+					continue;
+				}
+				const std::size_t dash = range.find('-');
+				const int first = std::stoi(range.substr(0, dash));
+				const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+				if (first < 0 || last < first || last >= CPU_SETSIZE) {
+					throw std::runtime_error{"thread_placement: bad CPU range '" + range + "'"};
+				}
+				for (int cpu = first; cpu <= last; ++cpu) {
+					cpus.push_back(cpu);
+				}
+			}
+			return cpus;
+		}
+
+		static int parse_policy(const std::string& text) {
+			if (text == "fifo") {
+				return SCHED_FIFO;
+			} else if (text == "rr") {
+				return SCHED_RR;
+			} else if (text == "other") {
+				return SCHED_OTHER;
+			}
+			throw std::runtime_error{"thread_placement: unknown policy '" + text + "'"};
+		}
+
+		static std::string policy_to_string(int policy) {
+			switch (policy) {
+			case SCHED_FIFO:
+				return "fifo";
+			case SCHED_RR:
+				return "rr";
+			default:
+				return "other";
+			}
+		}
+
+		static std::string cpus_to_string(const std::vector<int>& cpus) {
+			std::string ret;
+			for (int cpu : cpus) {
+				ret += (ret.empty() ? "" : ",") + std::to_string(cpu);
+			}
+			return ret;
+		}
+	};
+
+}
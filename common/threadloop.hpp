@@ -8,17 +8,26 @@
 #include "cpu_timer.hpp"
 #include "stoplight.hpp"
 #include "error_util.hpp"
+#include "thread_placement.hpp"
 
 namespace ILLIXR {
 
-const record_header __threadloop_iteration_header {"threadloop_iteration", {
-	{"plugin_id", typeid(std::size_t)},
-	{"iteration_no", typeid(std::size_t)},
-	{"skips", typeid(std::size_t)},
-	{"cpu_time_start", typeid(std::chrono::nanoseconds)},
-	{"cpu_time_stop" , typeid(std::chrono::nanoseconds)},
-	{"wall_time_start", typeid(std::chrono::high_resolution_clock::time_point)},
-	{"wall_time_stop" , typeid(std::chrono::high_resolution_clock::time_point)},
+const typed_record_header<
+	std::size_t,
+	std::size_t,
+	std::size_t,
+	std::chrono::nanoseconds,
+	std::chrono::nanoseconds,
+	std::chrono::high_resolution_clock::time_point,
+	std::chrono::high_resolution_clock::time_point
+> __threadloop_iteration_header {"threadloop_iteration", {
+	"plugin_id",
+	"iteration_no",
+	"skips",
+	"cpu_time_start",
+	"cpu_time_stop",
+	"wall_time_start",
+	"wall_time_stop",
 }};
 
 /**
@@ -33,6 +42,7 @@ public:
 	threadloop(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, _m_stoplight{pb->lookup_impl<Stoplight>()}
+		, _m_placement{pb->has_impl<thread_placement>() ? pb->lookup_impl<thread_placement>() : nullptr}
 	{ }
 
 	/**
@@ -78,8 +88,11 @@ protected:
 private:
 
 	void thread_main() {
-		record_coalescer it_log {record_logger_};
+		typed_record_coalescer it_log {record_logger_, __threadloop_iteration_header, record_flusher_};
 		std::cout << "thread," << std::this_thread::get_id() << ",threadloop," << name << std::endl;
+		if (_m_placement) {
+			_m_placement->apply(name);
+		}
 
 		// TODO: In the future, synchronize the main loop instead of the setup.
 		// This is currently not possible because RelativeClock is required in
@@ -100,22 +113,29 @@ private:
 				++skip_no;
 				break;
 			case skip_option::run: {
-				auto iteration_start_cpu_time  = thread_cpu_time();
-				auto iteration_start_wall_time = std::chrono::high_resolution_clock::now();
+				// Only measured if it gets logged
+				std::chrono::nanoseconds iteration_start_cpu_time {};
+				std::chrono::high_resolution_clock::time_point iteration_start_wall_time;
+				if (it_log) {
+					iteration_start_cpu_time  = thread_cpu_time();
+					iteration_start_wall_time = std::chrono::high_resolution_clock::now();
+				}
 				
 				RAC_ERRNO();
 				_p_one_iteration();
 				RAC_ERRNO();
 				
-				it_log.log(record{__threadloop_iteration_header, {
-					{id},
-					{iteration_no},
-					{skip_no},
-					{iteration_start_cpu_time},
-					{thread_cpu_time()},
-					{iteration_start_wall_time},
-					{std::chrono::high_resolution_clock::now()},
-				}});
+				if (it_log) {
+					it_log.log(
+						id,
+						iteration_no,
+						skip_no,
+						iteration_start_cpu_time,
+						thread_cpu_time(),
+						iteration_start_wall_time,
+						std::chrono::high_resolution_clock::now()
+					);
+				}
 				++iteration_no;
 				skip_no = 0;
 				break;
@@ -177,6 +197,7 @@ private:
 	std::atomic<bool> _m_terminate {false};
 	std::thread _m_thread;
 	std::shared_ptr<const Stoplight> _m_stoplight;
+	std::shared_ptr<const thread_placement> _m_placement;
 };
 
 }
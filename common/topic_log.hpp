@@ -0,0 +1,357 @@
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "relative_clock.hpp"
+#include "shm_transport.hpp"
+#include "switchboard.hpp"
+
+namespace ILLIXR {
+
+/**
+ * @brief On-disk layout of a topic log.
+ *
+ * A file header, then entries, each 8-byte aligned: a fixed `entry_header` and `size` bytes of
+ * payload. An entry with `topic == declaration` introduces the next topic id; its payload is the
+ * type name, a NUL, and the topic name. Other payloads are written by `shm_codec<T>::write` of the
+ * topic's type, so the log is readable as it is being appended to, and needs no index.
+ *
+ * Topic ids start at 1 in the file, so the zero-filled tail of a log whose recorder was killed
+ * reads as its end.
+ */
+namespace topic_log_format {
+	constexpr std::uint64_t magic = 0x4c54525849584c49; // "ILLIXRTL"
+	constexpr std::uint32_t version = 1;
+	constexpr std::uint32_t declaration = UINT32_MAX;
+
+	struct file_header {
+		std::uint64_t magic;
+		std::uint32_t version;
+		std::uint32_t reserved;
+	};
+
+	struct entry_header {
+		std::uint32_t topic;
+		std::uint32_t size;
+		// `RelativeClock` time at which the recorder received the event
+		std::int64_t time;
+	};
+
+	inline std::size_t aligned(std::size_t size) {
+		return (size + 7) / 8 * 8;
+	}
+}
+
+/**
+ * @brief Appends entries to an mmap-backed topic log, growing the file (and mapping) geometrically.
+ *
+ * Thread-safe. The file is truncated to its contents when this is destroyed.
+ */
+class topic_log_writer {
+public:
+	explicit topic_log_writer(const std::string& path)
+		: _m_path{path}
+	{
+		_m_fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+		if (_m_fd == -1) {
+			throw std::runtime_error{"open " + path + ": " + strerror(errno)};
+		}
+		reserve(_s_initial_capacity);
+		topic_log_format::file_header header {topic_log_format::magic, topic_log_format::version, 0};
+		std::memcpy(_m_data, &header, sizeof(header));
+		_m_size = sizeof(header);
+	}
+
+	topic_log_writer(const topic_log_writer&) = delete;
+	topic_log_writer& operator=(const topic_log_writer&) = delete;
+
+	~topic_log_writer() {
+		munmap(_m_data, _m_capacity);
+		if (ftruncate(_m_fd, static_cast<off_t>(_m_size)) == -1) {
+			std::cerr << "topic_log_writer: ftruncate " << _m_path << ": " << strerror(errno) << std::endl;
+		}
+		close(_m_fd);
+	}
+
+	/**
+	 * @brief Allocates the id under which events of @p topic_name are appended.
+	 */
+	std::uint32_t declare(const std::string& topic_name, const std::type_info& type) {
+		std::string payload = std::string{type.name()} + '\0' + topic_name;
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		append_locked(topic_log_format::declaration, 0, payload.size(), [&](std::byte* dst) {
+			std::memcpy(dst, payload.data(), payload.size());
+		});
+		return _m_topics++ - 1;
+	}
+
+	/**
+	 * @brief Appends @p size bytes for @p topic, written by @p write into the log.
+	 */
+	template <typename Write>
+	void append(std::uint32_t topic, time_point time, std::size_t size, Write&& write) {
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		assert(topic + 1 < _m_topics);
+		append_locked(topic + 1, time.time_since_epoch().count(), size, std::forward<Write>(write));
+	}
+
+	/// Bytes written so far
+	std::size_t size() {
+		const std::lock_guard<std::mutex> lock {_m_lock};
+		return _m_size;
+	}
+
+private:
+	static constexpr std::size_t _s_initial_capacity = 16 * 1024 * 1024;
+
+	const std::string _m_path;
+	int _m_fd {-1};
+	std::byte* _m_data {nullptr};
+	std::size_t _m_capacity {0};
+	std::size_t _m_size {0};
+	// The next topic id (in the file)
+	std::uint32_t _m_topics {1};
+	std::mutex _m_lock;
+
+	void reserve(std::size_t capacity) {
+		if (ftruncate(_m_fd, static_cast<off_t>(capacity)) == -1) {
+			throw std::runtime_error{"ftruncate " + _m_path + ": " + strerror(errno)};
+		}
+		void* data = _m_data
+			? mremap(_m_data, _m_capacity, capacity, MREMAP_MAYMOVE)
+			: mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _m_fd, 0);
+		if (data == MAP_FAILED) {
+			throw std::runtime_error{"mmap " + _m_path + ": " + strerror(errno)};
+		}
+		_m_data = static_cast<std::byte*>(data);
+		_m_capacity = capacity;
+	}
+
+	template <typename Write>
+	void append_locked(std::uint32_t topic, std::int64_t time, std::size_t size, Write&& write) {
+		assert(size <= UINT32_MAX);
+		std::size_t entry_size = topic_log_format::aligned(sizeof(topic_log_format::entry_header) + size);
+		if (_m_size + entry_size > _m_capacity) {
+			std::size_t capacity = _m_capacity;
+			while (_m_size + entry_size > capacity) {
+				capacity *= 2;
+			}
+			reserve(capacity);
+		}
+		std::byte* entry = _m_data + _m_size;
+		topic_log_format::entry_header header {topic, static_cast<std::uint32_t>(size), time};
+		std::memcpy(entry, &header, sizeof(header));
+		write(entry + sizeof(header));
+		_m_size += entry_size;
+	}
+};
+
+/**
+ * @brief Reads a topic log in place.
+ *
+ * Entries point into the mapping, and `pin()` keeps it alive, so replayed events (e.g. camera
+ * frames) need not be copied.
+ */
+class topic_log_reader : public std::enable_shared_from_this<topic_log_reader> {
+private:
+	struct private_tag { };
+
+public:
+	struct topic_info {
+		std::string name;
+		std::string type_name;
+	};
+
+	struct entry {
+		std::uint32_t topic;
+		time_point time;
+		const std::byte* data;
+		std::size_t size;
+	};
+
+	/// Use `open`.
+	topic_log_reader(private_tag, const std::string& path)
+		: _m_path{path}
+	{ }
+
+	topic_log_reader(const topic_log_reader&) = delete;
+	topic_log_reader& operator=(const topic_log_reader&) = delete;
+
+	~topic_log_reader() {
+		if (_m_data) {
+			munmap(const_cast<std::byte*>(_m_data), _m_size);
+		}
+	}
+
+	static std::shared_ptr<topic_log_reader> open(const std::string& path) {
+		auto reader = std::make_shared<topic_log_reader>(private_tag{}, path);
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			throw std::runtime_error{"open " + path + ": " + strerror(errno)};
+		}
+		struct stat st;
+		if (fstat(fd, &st) == -1) {
+			close(fd);
+			throw std::runtime_error{"fstat " + path + ": " + strerror(errno)};
+		}
+		reader->_m_size = static_cast<std::size_t>(st.st_size);
+		topic_log_format::file_header header {};
+		if (reader->_m_size >= sizeof(header)) {
+			void* data = mmap(nullptr, reader->_m_size, PROT_READ, MAP_SHARED, fd, 0);
+			if (data == MAP_FAILED) {
+				close(fd);
+				throw std::runtime_error{"mmap " + path + ": " + strerror(errno)};
+			}
+			reader->_m_data = static_cast<const std::byte*>(data);
+			std::memcpy(&header, reader->_m_data, sizeof(header));
+		}
+		close(fd);
+		if (header.magic != topic_log_format::magic || header.version != topic_log_format::version) {
+			throw std::runtime_error{path + " is not a version " + std::to_string(topic_log_format::version) + " topic log"};
+		}
+		reader->_m_offset = sizeof(header);
+		return reader;
+	}
+
+	/**
+	 * @brief Reads the next event entry (declarations are consumed along the way).
+	 *
+	 * Returns false at the end, or at a truncated entry (e.g. the recorder was killed).
+	 */
+	bool next(entry& out) {
+		while (_m_offset + sizeof(topic_log_format::entry_header) <= _m_size) {
+			topic_log_format::entry_header header;
+			std::memcpy(&header, _m_data + _m_offset, sizeof(header));
+			if (header.topic == 0) {
+				return false;
+			}
+			std::size_t entry_size = topic_log_format::aligned(sizeof(header) + header.size);
+			if (_m_offset + entry_size > _m_size) {
+				return false;
+			}
+			const std::byte* payload = _m_data + _m_offset + sizeof(header);
+			_m_offset += entry_size;
+
+			if (header.topic == topic_log_format::declaration) {
+				const char* chars = reinterpret_cast<const char*>(payload);
+				std::size_t type_length = strnlen(chars, header.size);
+				std::size_t name_start = std::min<std::size_t>(type_length + 1, header.size);
+				_m_topics.push_back(topic_info{
+					std::string{chars + name_start, header.size - name_start},
+					std::string{chars, type_length},
+				});
+				continue;
+			}
+			if (header.topic > _m_topics.size()) {
+				throw std::runtime_error{_m_path + ": entry for undeclared topic " + std::to_string(header.topic)};
+			}
+			out = entry{header.topic - 1, time_point{std::chrono::nanoseconds{header.time}}, payload, header.size};
+			return true;
+		}
+		return false;
+	}
+
+	/// Topics declared so far
+	const std::vector<topic_info>& topics() const {
+		return _m_topics;
+	}
+
+	/// Keeps the mapping alive while an entry is in use
+	std::shared_ptr<const void> pin() {
+		return shared_from_this();
+	}
+
+private:
+	const std::string _m_path;
+	const std::byte* _m_data {nullptr};
+	std::size_t _m_size {0};
+	std::size_t _m_offset {0};
+	std::vector<topic_info> _m_topics;
+};
+
+/**
+ * @brief The event types a recorder or replayer can handle, by `type_info` name.
+ *
+ * Each type needs a `shm_codec` specialization, which doubles as its serializer. Codecs write times
+ * through a clock which was never started, so the log holds times relative to the recording's
+ * start, and a replay republishes them relative to its own start.
+ */
+class topic_log_types {
+public:
+	/// Publishes one serialized event on the topic it was made for
+	using publisher = std::function<void(const std::byte* data, std::size_t size, std::shared_ptr<const void>&& pin)>;
+
+	template <typename specific_event>
+	void add() {
+		_m_types[typeid(specific_event).name()] = handlers{
+			[](topic_log_writer& log, switchboard& sb, const RelativeClock& clock, plugin_id_t plugin_id, const std::string& topic_name) {
+				std::uint32_t topic = log.declare(topic_name, typeid(specific_event));
+				sb.schedule<specific_event>(plugin_id, topic_name, [&log, &clock, topic](switchboard::ptr<const specific_event>&& this_event, std::size_t) {
+					log.append(topic, clock.now(), shm_codec<specific_event>::size(*this_event), [&](std::byte* dst) {
+						shm_codec<specific_event>::write(*this_event, dst, relative());
+					});
+				});
+			},
+			[](switchboard& sb, const std::string& topic_name) -> publisher {
+				auto writer = std::make_shared<switchboard::writer<specific_event>>(sb.get_writer<specific_event>(topic_name));
+				return [writer](const std::byte* data, std::size_t size, std::shared_ptr<const void>&& pin) {
+					writer->put(shm_codec<specific_event>::read(data, size, relative(), std::move(pin)));
+				};
+			},
+		};
+	}
+
+	bool has(const std::string& type_name) const {
+		return _m_types.count(type_name) != 0;
+	}
+
+	/**
+	 * @brief Appends every event published on @p topic_name (of type @p type) to @p log.
+	 *
+	 * Entries are stamped with @p clock. @p log and @p clock must outlive the switchboard's subscriptions.
+	 */
+	void record(const std::type_info& type, topic_log_writer& log, switchboard& sb, const RelativeClock& clock,
+				plugin_id_t plugin_id, const std::string& topic_name) const {
+		_m_types.at(type.name()).record(log, sb, clock, plugin_id, topic_name);
+	}
+
+	/**
+	 * @brief Makes a function which republishes logged events of @p type_name on @p topic_name.
+	 */
+	publisher make_publisher(const std::string& type_name, switchboard& sb, const std::string& topic_name) const {
+		return _m_types.at(type_name).make_publisher(sb, topic_name);
+	}
+
+private:
+	/// absolute_ns and from_absolute_ns are the identity on a clock which was not started.
+	static const RelativeClock& relative() {
+		static const RelativeClock unstarted;
+		return unstarted;
+	}
+
+	struct handlers {
+		std::function<void(topic_log_writer&, switchboard&, const RelativeClock&, plugin_id_t, const std::string&)> record;
+		std::function<publisher(switchboard&, const std::string&)> make_publisher;
+	};
+
+	std::unordered_map<std::string, handlers> _m_types;
+};
+
+} // namespace ILLIXR
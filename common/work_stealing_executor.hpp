@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "concurrentqueue/blockingconcurrentqueue.hpp"
+
+namespace ILLIXR {
+
+/**
+ * @brief Lets threads sleep until something changes, without costing the notifier a lock unless
+ * one of them actually sleeps.
+ *
+ * A waiter reads `key()`, checks its condition, and if that fails, calls `wait()` with the key:
+ * that returns at once if there was a `notify()` in between, and otherwise sleeps until the next
+ * one. So a notification between the check and the sleep is not lost.
+ */
+class event_count {
+public:
+	std::uint64_t key() const {
+		return _m_count.load();
+	}
+
+	void wait(std::uint64_t key) {
+		_m_waiters.fetch_add(1);
+		{
+			std::unique_lock<std::mutex> lock {_m_lock};
+			_m_changed.wait(lock, [&] { return _m_count.load() != key; });
+		}
+		_m_waiters.fetch_sub(1);
+	}
+
+	void notify() {
+		_m_count.fetch_add(1);
+		if (_m_waiters.load() != 0) {
+			{
+				// A waiter between its check and its sleep holds this, so it cannot miss the wakeup.
+				std::lock_guard<std::mutex> lock {_m_lock};
+			}
+			_m_changed.notify_all();
+		}
+	}
+
+private:
+	std::atomic<std::uint64_t> _m_count {0};
+	std::atomic<std::size_t> _m_waiters {0};
+	std::mutex _m_lock;
+	std::condition_variable _m_changed;
+};
+
+/**
+ * @brief A fixed-size pool of threads which run `task`s, stealing work from each other when idle.
+ *
+ * Each worker owns a deque. A task submitted from a worker goes on that worker's deque (it is
+ * probably related to what the worker just did); a task submitted from elsewhere goes round-robin.
+ * Workers take from the front of their own deque, and steal from the back of the others'.
+ *
+ * A semaphore counts the tasks sitting in deques. Every take is preceded by a successful wait, so
+ * a worker which wakes up is guaranteed to find a task somewhere, and idle workers sleep instead of
+ * polling. A scan can still miss while other workers take and submit concurrently; then the worker
+ * sleeps until the next submit, so none spins.
+ *
+ * A task may also be submitted with a deadline. Those go in one shared heap instead, and every
+ * worker takes the one with the earliest deadline before looking at the deques (EDF). Tasks are not
+ * preempted, so this orders ready work; it cannot interrupt a long task which is already running.
+ *
+ * The executor does not own the tasks. A task may be submitted again once it started running, but
+ * must not be submitted twice before that; `switchboard` uses this to keep the callbacks of one
+ * subscription serialized.
+ */
+class work_stealing_executor {
+public:
+	class task {
+	public:
+		virtual ~task() = default;
+		virtual void run() = 0;
+	};
+
+	/**
+	 * @p on_start, if present, is called by each worker (with its index) before it runs any task.
+	 */
+	explicit work_stealing_executor(std::size_t threads, std::function<void(std::size_t)> on_start = {})
+		: _m_workers(threads)
+		, _m_on_start{on_start}
+	{
+		assert(threads > 0);
+		for (std::size_t i = 0; i < threads; ++i) {
+			_m_workers[i].thread = std::thread{&work_stealing_executor::worker_main, this, i};
+		}
+	}
+
+	/// The deadline of best-effort tasks
+	static constexpr std::chrono::steady_clock::time_point no_deadline = std::chrono::steady_clock::time_point::max();
+
+	work_stealing_executor(const work_stealing_executor&) = delete;
+	work_stealing_executor& operator=(const work_stealing_executor&) = delete;
+
+	/**
+	 * @brief Stops and joins the workers. Tasks still waiting are not run.
+	 */
+	~work_stealing_executor() {
+		_m_stop.store(true);
+		_m_ready.signal(static_cast<moodycamel::LightweightSemaphore::ssize_t>(_m_workers.size()));
+		_m_submitted.notify();
+		for (worker& w : _m_workers) {
+			w.thread.join();
+		}
+	}
+
+	/**
+	 * @brief Schedules @p t to run on some worker, ahead of tasks with a later @p deadline.
+	 *
+	 * Thread-safe
+	 */
+	void submit(task* t, std::chrono::steady_clock::time_point deadline = no_deadline) {
+		assert(t);
+		if (deadline != no_deadline) {
+			{
+				std::lock_guard<std::mutex> lock {_m_urgent_lock};
+				_m_urgent.push(urgent_task{deadline, t});
+				_m_urgent_size.store(_m_urgent.size());
+			}
+			_m_submitted.notify();
+			_m_ready.signal();
+			return;
+		}
+		std::size_t target = (_s_this_executor == this)
+			? _s_this_worker
+			: _m_next_worker.fetch_add(1, std::memory_order_relaxed) % _m_workers.size();
+		{
+			std::lock_guard<std::mutex> lock {_m_workers[target].lock};
+			_m_workers[target].tasks.push_back(t);
+		}
+		_m_submitted.notify();
+		_m_ready.signal();
+	}
+
+	std::size_t size() const {
+		return _m_workers.size();
+	}
+
+private:
+	struct worker {
+		std::mutex lock;
+		std::deque<task*> tasks;
+		std::thread thread;
+	};
+
+	struct urgent_task {
+		std::chrono::steady_clock::time_point deadline;
+		task* t;
+		bool operator>(const urgent_task& other) const {
+			return deadline > other.deadline;
+		}
+	};
+
+	std::vector<worker> _m_workers;
+	std::function<void(std::size_t)> _m_on_start;
+	// A min-heap on deadline. The size is mirrored so that workers can skip the lock when it is empty.
+	std::priority_queue<urgent_task, std::vector<urgent_task>, std::greater<urgent_task>> _m_urgent;
+	std::mutex _m_urgent_lock;
+	std::atomic<std::size_t> _m_urgent_size {0};
+	moodycamel::LightweightSemaphore _m_ready;
+	std::atomic<std::size_t> _m_next_worker {0};
+	std::atomic<bool> _m_stop {false};
+	// For workers whose scan missed (see take())
+	event_count _m_submitted;
+
+	static thread_local const work_stealing_executor* _s_this_executor;
+	static thread_local std::size_t _s_this_worker;
+
+	/**
+	 * @brief Takes a task, or null if the executor is stopping; the caller must have waited on
+	 * `_m_ready` for it.
+	 *
+	 * The semaphore never counts more tasks than the deques hold, so one is in there all along.
+	 * If a scan misses it anyway, it was pushed after the scan began (tasks do not move), so the
+	 * scan is not repeated until that submit is done.
+	 */
+	task* take(std::size_t self) {
+		while (true) {
+			const std::uint64_t submits = _m_submitted.key();
+			if (task* t = try_take(self)) {
+				return t;
+			}
+			if (_m_stop.load()) {
+				return nullptr;
+			}
+			_m_submitted.wait(submits);
+		}
+	}
+
+	task* try_take(std::size_t self) {
+		if (_m_urgent_size.load() != 0) {
+			std::lock_guard<std::mutex> lock {_m_urgent_lock};
+			if (!_m_urgent.empty()) {
+				task* t = _m_urgent.top().t;
+				_m_urgent.pop();
+				_m_urgent_size.store(_m_urgent.size());
+				return t;
+			}
+		}
+		for (std::size_t i = 0; i < _m_workers.size(); ++i) {
+			worker& victim = _m_workers[(self + i) % _m_workers.size()];
+			std::lock_guard<std::mutex> lock {victim.lock};
+			if (!victim.tasks.empty()) {
+				task* t;
+				if (i == 0) {
+					t = victim.tasks.front();
+					victim.tasks.pop_front();
+				} else {
+					t = victim.tasks.back();
+					victim.tasks.pop_back();
+				}
+				return t;
+			}
+		}
+		return nullptr;
+	}
+
+	void worker_main(std::size_t self) {
+		_s_this_executor = this;
+		_s_this_worker = self;
+		std::cout << "thread," << std::this_thread::get_id() << ",switchboard worker," << self << std::endl;
+		if (_m_on_start) {
+			_m_on_start(self);
+		}
+		while (true) {
+			_m_ready.wait();
+			if (_m_stop.load()) {
+				break;
+			}
+			task* t = take(self);
+			if (!t) {
+				break;
+			}
+			t->run();
+		}
+	}
+};
+
+inline thread_local const work_stealing_executor* work_stealing_executor::_s_this_executor = nullptr;
+inline thread_local std::size_t work_stealing_executor::_s_this_worker = 0;
+
+} // namespace ILLIXR
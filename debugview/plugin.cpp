@@ -72,8 +72,8 @@ public:
 		: threadloop{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
 		, pp{pb->lookup_impl<pose_prediction>()}
-		, _m_slow_pose{sb->get_reader<pose_type>("slow_pose")}
-		, _m_fast_pose{sb->get_reader<imu_raw_type>("imu_raw")}
+		, _m_slow_pose{sb->get_reader(topics::slow_pose)}
+		, _m_fast_pose{sb->get_reader(topics::imu_raw)}
 		//, glfw_context{pb->lookup_impl<global_config>()->glfw_context}
 	{}
 
@@ -477,7 +477,7 @@ public:
 		// It serves more as an event stream. Camera frames are only available on this topic
 		// the very split second they are made available. Subsequently published packets to this
 		// topic do not contain the camera frames.
-   		sb->schedule<imu_cam_type>(id, "imu_cam", [&](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
+   		sb->schedule(id, topics::imu_cam, [&](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
         	this->imu_cam_handler(datum);
     	});
 
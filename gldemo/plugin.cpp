@@ -45,8 +45,8 @@ public:
 		//, xwin{pb->lookup_impl<xlib_gl_extended_window>()}
 		, pp{pb->lookup_impl<pose_prediction>()}
 		, _m_clock{pb->lookup_impl<RelativeClock>()}
-		, _m_vsync{sb->get_reader<switchboard::event_wrapper<time_point>>("vsync_estimate")}
-		, _m_eyebuffer{sb->get_writer<rendered_frame>("eyebuffer")}	
+		, _m_vsync{sb->get_reader(topics::vsync_estimate)}
+		, _m_eyebuffer{sb->get_writer(topics::eyebuffer)}	
 	{ }
 
 	// Essentially, a crude equivalent of XRWaitFrame.
@@ -14,8 +14,8 @@ public:
 	ground_truth_slam(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
-		, _m_true_pose{sb->get_writer<pose_type>("true_pose")}
-		, _m_ground_truth_offset{sb->get_writer<switchboard::event_wrapper<Eigen::Vector3f>>("ground_truth_offset")}
+		, _m_true_pose{sb->get_writer(topics::true_pose)}
+		, _m_ground_truth_offset{sb->get_writer(topics::ground_truth_offset)}
 		, _m_sensor_data{load_data()}
 		, _m_dataset_first_time{_m_sensor_data.cbegin()->first}
 		, _m_first_time{true}
@@ -23,9 +23,12 @@ public:
 
 	virtual void start() override {
 		plugin::start();
-		sb->schedule<imu_cam_type>(id, "imu_cam", [this](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
+		// Only a map lookup per IMU sample, so run it in the publisher's thread.
+		switchboard::qos imu_qos;
+		imu_qos.dispatch_mode = switchboard::dispatch::inline_publisher;
+		sb->schedule(id, topics::imu_cam, [this](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
 			this->feed_ground_truth(datum);
-		});
+		}, imu_qos);
 	}
 
 	void feed_ground_truth(switchboard::ptr<const imu_cam_type> datum) {
@@ -26,7 +26,7 @@ public:
 		, _m_sensor_data_it{_m_sensor_data.cbegin()}
 		, _m_sb{pb->lookup_impl<switchboard>()}
 		, _m_clock{pb->lookup_impl<RelativeClock>()}
-		, _m_imu_cam{_m_sb->get_writer<imu_cam_type>("imu_cam")}
+		, _m_imu_cam{_m_sb->get_writer(topics::imu_cam)}
 		, dataset_first_time{_m_sensor_data_it->first}
 		, imu_cam_log{record_logger_}
 		, camera_cvtfmt_log{record_logger_}
@@ -38,9 +38,7 @@ protected:
 		if (_m_sensor_data_it != _m_sensor_data.end()) {
 			dataset_now = _m_sensor_data_it->first;
 
-			std::this_thread::sleep_for(
-				time_point{std::chrono::nanoseconds{dataset_now - dataset_first_time}} - _m_clock->now()
-			);
+			_m_clock->sleep_until(time_point{std::chrono::nanoseconds{dataset_now - dataset_first_time}});
 			if (_m_sensor_data_it->second.imu0) {
 				return skip_option::run;
 			} else {
@@ -30,7 +30,7 @@ public:
 		/// TODO: Set with #198
 		, obj_dir{ILLIXR::getenv_or("ILLIXR_OFFLOAD_PATH", "metrics/offloaded_data/")}
 	{
-		sb->schedule<texture_pose>(id, "texture_pose", [&](switchboard::ptr<const texture_pose> datum, size_t) {
+		sb->schedule(id, topics::texture_pose, [&](switchboard::ptr<const texture_pose> datum, size_t) {
 			callback(datum);
 		});
     }
@@ -15,8 +15,8 @@ public:
     offload_reader(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
-		, _m_pose{sb->get_writer<pose_type>("slow_pose")}
-		, _m_imu_integrator_input{sb->get_writer<imu_integrator_input>("imu_integrator_input")}
+		, _m_pose{sb->get_writer(topics::slow_pose)}
+		, _m_imu_integrator_input{sb->get_writer(topics::imu_integrator_input)}
     { 
 		pose_type datum_pose_tmp{
             time_point{},
@@ -25,17 +25,31 @@ public:
     virtual void start() override {
         plugin::start();
 
-        sb->schedule<imu_cam_type>(id, "imu_cam", [this](switchboard::ptr<const imu_cam_type> datum, std::size_t) {
-			this->send_imu_cam_data(datum);
-		});
+        // Takes whatever has queued up (no window, so no added latency), appends all of it to one
+        // message, and sends that once if the batch completed a camera frame.
+        sb->schedule_batch<imu_cam_type>(id, "imu_cam", [this](std::vector<switchboard::ptr<const imu_cam_type>>&& batch, std::size_t) {
+			bool has_frame = false;
+			for (const switchboard::ptr<const imu_cam_type>& datum : batch) {
+				has_frame |= this->append_imu_cam_data(datum);
+			}
+			if (has_frame) {
+				publisher.Send(*data_buffer);
+				data_buffer->Clear();
+			}
+		}, 64);
 	}
 
 
-    void send_imu_cam_data(switchboard::ptr<const imu_cam_type> datum) {
+	/**
+	 * @brief Appends @p datum to the message being built.
+	 *
+	 * @returns whether it carries a camera frame, after which the message should be sent.
+	 */
+    bool append_imu_cam_data(switchboard::ptr<const imu_cam_type> datum) {
 		// Ensures that slam doesnt start before valid IMU readings come in
         if (datum == nullptr) {
             assert(previous_timestamp == 0);
-            return;
+            return false;
         }
 
 		assert(datum->time.time_since_epoch().count() > previous_timestamp);
@@ -59,6 +73,7 @@ public:
       	if (!datum->img0.has_value() && !datum->img1.has_value()) {
 			imu_cam_data->set_rows(-1);
 			imu_cam_data->set_cols(-1);
+			return false;
 
 		} else {
 			cv::Mat img0{(datum->img0.value()).clone()};
@@ -69,16 +84,14 @@ public:
 
 			imu_cam_data->set_img0_data((void*) img0.data, img0.rows * img0.cols);
 			imu_cam_data->set_img1_data((void*) img1.data, img1.rows * img1.cols);
-
-			publisher.Send(*data_buffer);
-			delete data_buffer;
-			data_buffer = new vio_input_proto::IMUCamVec();
+			return true;
 		}
     }
 
 private:
 	long previous_timestamp = 0;
-	vio_input_proto::IMUCamVec* data_buffer = new vio_input_proto::IMUCamVec();
+	// IMU samples (and frames) appended since the last send; cleared, not reallocated, after each
+	const std::unique_ptr<vio_input_proto::IMUCamVec> data_buffer = std::make_unique<vio_input_proto::IMUCamVec>();
 
     const std::shared_ptr<switchboard> sb;
 	eCAL::protobuf::CPublisher<vio_input_proto::IMUCamVec> publisher;
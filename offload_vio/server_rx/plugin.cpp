@@ -15,7 +15,7 @@ public:
 	server_reader(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
-		, _m_imu_cam{sb->get_writer<imu_cam_type>("imu_cam")}
+		, _m_imu_cam{sb->get_writer(topics::imu_cam)}
     { 
 		eCAL::Initialize(0, NULL, "VIO Server Reader");
 		subscriber = eCAL::protobuf::CSubscriber<vio_input_proto::IMUCamVec>("vio_input");
@@ -15,7 +15,7 @@ public:
     server_writer(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
-		, _m_imu_int_input{sb->get_reader<imu_integrator_input>("imu_integrator_input")}
+		, _m_imu_int_input{sb->get_reader(topics::imu_integrator_input)}
     { 
 		eCAL::Initialize(0, NULL, "VIO Server Writer");
 		publisher = eCAL::protobuf::CPublisher<vio_output_proto::VIOOutput>("vio_output");
@@ -27,7 +27,7 @@ public:
     virtual void start() override {
         plugin::start();
 
-        sb->schedule<pose_type>(id, "slow_pose", [this](switchboard::ptr<const pose_type> datum, std::size_t) {
+        sb->schedule(id, topics::slow_pose, [this](switchboard::ptr<const pose_type> datum, std::size_t) {
 			this->send_vio_output(datum);
 		});
 	}
@@ -10,12 +10,15 @@ public:
 	passthrough_integrator(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
-		, _m_imu_integrator_input{sb->get_reader<imu_integrator_input>("imu_integrator_input")}
-		, _m_imu_raw{sb->get_writer<imu_raw_type>("imu_raw")}
+		, _m_imu_integrator_input{sb->get_reader(topics::imu_integrator_input)}
+		, _m_imu_raw{sb->get_writer(topics::imu_raw)}
 	{
-		sb->schedule<imu_cam_type>(id, "imu_cam", [&](switchboard::ptr<const imu_cam_type> datum, size_t) {
+		// A few microseconds of arithmetic; not worth waking a thread for.
+		switchboard::qos imu_qos;
+		imu_qos.dispatch_mode = switchboard::dispatch::inline_publisher;
+		sb->schedule(id, topics::imu_cam, [&](switchboard::ptr<const imu_cam_type> datum, size_t) {
 			callback(datum);
-		});
+		}, imu_qos);
 	}
 
 	void callback(switchboard::ptr<const imu_cam_type> datum) {
@@ -21,7 +21,7 @@ public:
         , _m_sensor_data{load_data()}
         , _m_sensor_data_it{_m_sensor_data.cbegin()}
         , dataset_first_time{_m_sensor_data_it->first}
-        , _m_vsync_estimate{sb->get_reader<switchboard::event_wrapper<time_point>>("vsync_estimate")}
+        , _m_vsync_estimate{sb->get_reader(topics::vsync_estimate)}
         /// TODO: Set with #198
         , enable_alignment{ILLIXR::str_to_bool(getenv_or("ILLIXR_ALIGNMENT_ENABLE", "False"))}
         , init_pos_offset{Eigen::Vector3f::Zero()}
@@ -12,11 +12,11 @@ public:
     pose_prediction_impl(const phonebook* const pb)
         : sb{pb->lookup_impl<switchboard>()}
         , _m_clock{pb->lookup_impl<RelativeClock>()}
-        , _m_slow_pose{sb->get_reader<pose_type>("slow_pose")}
-        , _m_imu_raw{sb->get_reader<imu_raw_type>("imu_raw")}
-        , _m_true_pose{sb->get_reader<pose_type>("true_pose")}
-        , _m_ground_truth_offset{sb->get_reader<switchboard::event_wrapper<Eigen::Vector3f>>("ground_truth_offset")}
-		, _m_vsync_estimate{sb->get_reader<switchboard::event_wrapper<time_point>>("vsync_estimate")}
+        , _m_slow_pose{sb->get_reader(topics::slow_pose)}
+        , _m_imu_raw{sb->get_reader(topics::imu_raw)}
+        , _m_true_pose{sb->get_reader(topics::true_pose)}
+        , _m_ground_truth_offset{sb->get_reader(topics::ground_truth_offset)}
+		, _m_vsync_estimate{sb->get_reader(topics::vsync_estimate)}
     { }
 
     // No parameter get_fast_pose() should just predict to the next vsync
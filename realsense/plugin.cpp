@@ -24,8 +24,8 @@ public:
         : plugin{name_, pb_}
         , sb{pb->lookup_impl<switchboard>()}
         , _m_clock{pb->lookup_impl<RelativeClock>()}
-        , _m_imu_cam{sb->get_writer<imu_cam_type>("imu_cam")}
-        , _m_rgb_depth{sb->get_writer<rgb_depth_type>("rgb_depth")}
+        , _m_imu_cam{sb->get_writer(topics::imu_cam)}
+        , _m_rgb_depth{sb->get_writer(topics::rgb_depth)}
         , realsense_cam{ILLIXR::getenv_or("REALSENSE_CAM", "auto")}
         {
             cam_data.iteration = -1;
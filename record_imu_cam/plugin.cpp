@@ -41,9 +41,15 @@ public:
 		cam1_wt_file.open(cam1_file, std::ofstream::out);
 		cam1_wt_file << "#timestamp [ns],filename" << std::endl;
 
-		sb->schedule<imu_cam_type>(id, "imu_cam", [this](switchboard::ptr<const imu_cam_type> datum, std::size_t){
-			this->dump_data(datum);
-		});
+		// Recording is not latency-sensitive, so collect events for a while and flush the files once per batch.
+		sb->schedule_batch<imu_cam_type>(id, "imu_cam", [this](std::vector<switchboard::ptr<const imu_cam_type>>&& batch, std::size_t){
+			for (const switchboard::ptr<const imu_cam_type>& datum : batch) {
+				this->dump_data(datum);
+			}
+			imu_wt_file.flush();
+			cam0_wt_file.flush();
+			cam1_wt_file.flush();
+		}, 64, std::chrono::milliseconds{20});
 	}
 
 	void dump_data(switchboard::ptr<const imu_cam_type> datum) {
@@ -52,13 +58,13 @@ public:
 		Eigen::Vector3f linear_a = datum->linear_a;
 
 		// write imu0
-		imu_wt_file << timestamp << "," << std::setprecision(17) << angular_v[0] << "," << angular_v[1] << "," << angular_v[2] << "," << linear_a[0] << "," << linear_a[1] << "," << linear_a[2] << std::endl;
+		imu_wt_file << timestamp << "," << std::setprecision(17) << angular_v[0] << "," << angular_v[1] << "," << angular_v[2] << "," << linear_a[0] << "," << linear_a[1] << "," << linear_a[2] << "\n";
 		
 		// write cam0
 		std::optional<cv::Mat> cam0_data = datum->img0;
 		std::string cam0_img = cam0_data_dir.string() + "/" + std::to_string(timestamp) + ".png";
 		if (cam0_data != std::nullopt) {
-			cam0_wt_file << timestamp << "," << timestamp <<".png "<< std::endl;
+			cam0_wt_file << timestamp << "," << timestamp << ".png \n";
 			cv::imwrite(cam0_img, cam0_data.value());
 		}
 
@@ -66,7 +72,7 @@ public:
 		std::optional<cv::Mat> cam1_data = datum->img1;
         	std::string cam1_img = cam1_data_dir.string() + "/" +std::to_string(timestamp) + ".png";
 		if (cam1_data != std::nullopt) {
-			cam1_wt_file << timestamp << "," << timestamp << ".png " << std::endl;
+			cam1_wt_file << timestamp << "," << timestamp << ".png \n";
 			cv::imwrite(cam1_img, cam1_data.value());
 		}
 	}
@@ -13,28 +13,37 @@
 
 using namespace ILLIXR;
 
-constexpr duration IMU_SAMPLE_LIFETIME{std::chrono::seconds{5}}; 
+// IMU samples remembered by the imu_cam topic (about 5 s at 200 Hz). Only their IMU fields are
+// kept (see remember_imu), so this holds no camera frames.
+constexpr std::size_t IMU_HISTORY_LENGTH = 1024;
+// One IMU period at 200 Hz
+constexpr std::chrono::milliseconds IMU_DEADLINE {5};
+
+// A copy of an imu_cam event without its images, so that the history pins neither camera frames
+// nor the memory they live in (shared-memory slots, replay chunks).
+static switchboard::ptr<const imu_cam_type> remember_imu(const imu_cam_type& datum) {
+	return switchboard::make_ptr<imu_cam_type>(datum.time, datum.angular_v, datum.linear_a, std::nullopt, std::nullopt);
+}
+
 class rk4_integrator : public plugin {
 public:
 	rk4_integrator(std::string name_, phonebook* pb_)
 		: plugin{name_, pb_}
 		, sb{pb->lookup_impl<switchboard>()}
-		, _m_imu_integrator_input{sb->get_reader<imu_integrator_input>("imu_integrator_input")}
-		, _m_imu_raw{sb->get_writer<imu_raw_type>("imu_raw")}
+		, _m_imu_cam{sb->get_reader(topics::imu_cam)}
+		, _m_imu_integrator_input{sb->get_reader(topics::imu_integrator_input)}
+		, _m_imu_raw{sb->get_writer(topics::imu_raw)}
 	{
-		sb->schedule<imu_cam_type>(id, "imu_cam", [&](switchboard::ptr<const imu_cam_type> datum, size_t) {
+		_m_imu_cam.keep_history(IMU_HISTORY_LENGTH, [](const imu_cam_type& datum) { return datum.time; }, remember_imu);
+		// imu_raw feeds pose prediction for timewarp, so run ahead of best-effort callbacks.
+		switchboard::qos imu_qos;
+		imu_qos.deadline = IMU_DEADLINE;
+		sb->schedule(id, topics::imu_cam, [&](switchboard::ptr<const imu_cam_type> datum, size_t) {
 			callback(datum);
-		});
+		}, imu_qos);
 	}
 
 	void callback(switchboard::ptr<const imu_cam_type> datum) {
-		_imu_vec.emplace_back(
-			datum->time,
-			datum->angular_v.cast<double>(),
-			datum->linear_a.cast<double>()
-		);
-
-		clean_imu_vec(datum->time);
         propagate_imu_values(datum->time);
 
         RAC_ERRNO_MSG("rk4_integrator");
@@ -44,11 +53,11 @@ private:
 	const std::shared_ptr<switchboard> sb;
 
 	// IMU Data, Sequence Flag, and State Vars Needed
+	switchboard::reader<imu_cam_type> _m_imu_cam;
 	switchboard::reader<imu_integrator_input> _m_imu_integrator_input;
 
 	// IMU Biases
 	switchboard::writer<imu_raw_type> _m_imu_raw;
-	std::vector<imu_type> _imu_vec;
 	duration last_imu_offset;
 	bool has_last_offset = false;
 
@@ -57,15 +66,27 @@ private:
 	[[maybe_unused]] int total_imu = 0;
 	[[maybe_unused]] double last_cam_time = 0;
 
-	// Clean IMU values older than IMU_SAMPLE_LIFETIME seconds
-	void clean_imu_vec(time_point timestamp) {
-		auto it0 = _imu_vec.begin();
-        while (it0 != _imu_vec.end()) {
-            if (timestamp - it0->timestamp < IMU_SAMPLE_LIFETIME) {
-               break;
-            }
-           it0 = _imu_vec.erase(it0);
-         }
+	// The IMU samples needed to integrate from time_begin to time_end: those in between, plus the
+	// ones just outside for interpolation. Samples newer than `newest` have not been handled yet.
+	std::vector<imu_type> get_imu_window(time_point time_begin, time_point time_end, time_point newest) const {
+		std::vector<imu_type> imu_data;
+		auto push = [&imu_data](const switchboard::ptr<const imu_cam_type>& datum) {
+			imu_data.emplace_back(datum->time, datum->angular_v.cast<double>(), datum->linear_a.cast<double>());
+		};
+
+		if (switchboard::ptr<const imu_cam_type> before = _m_imu_cam.get_latest_before(time_begin)) {
+			push(before);
+		}
+		for (const switchboard::ptr<const imu_cam_type>& datum : _m_imu_cam.get_range(time_begin, std::min(time_end, newest))) {
+			push(datum);
+		}
+		if (time_end < newest) {
+			switchboard::ptr<const imu_cam_type> after = _m_imu_cam.get_earliest_after(time_end);
+			if (after != nullptr && after->time <= newest) {
+				push(after);
+			}
+		}
+		return imu_data;
 	}
 
 	// Timestamp we are propagating the biases to (new IMU reading time)
@@ -104,7 +125,7 @@ private:
 		time_point time0 = input_values->last_cam_integration_time + last_imu_offset;
 		time_point time1 = real_time + t_off_new;
 
-		std::vector<imu_type> prop_data = select_imu_readings(_imu_vec, time0, time1);
+		std::vector<imu_type> prop_data = select_imu_readings(get_imu_window(time0, time1, real_time), time0, time1);
 		Eigen::Matrix<double,3,1> w_hat;
 		Eigen::Matrix<double,3,1> a_hat;
 		Eigen::Matrix<double,3,1> w_hat2;
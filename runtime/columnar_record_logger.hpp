@@ -0,0 +1,64 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <experimental/filesystem>
+#include "common/columnar_log.hpp"
+#include "common/record_logger.hpp"
+
+namespace ILLIXR {
+
+/**
+ * @brief Appends each record type to `metrics/<type>.cols`, a columnar log (see `common/columnar_log.hpp`).
+ *
+ * Logging a record stores its values into a memory-mapped chunk on the caller's thread; there is no
+ * queue and no writer thread. Batches from `typed_record_coalescer` are stored without unboxing.
+ * `columnar_export` turns the logs into CSV or SQLite after the run.
+ */
+class columnar_record_logger : public record_logger {
+private:
+	columnar_log_writer& get_writer(const record_header& rh) {
+		{
+			const std::shared_lock<std::shared_mutex> lock {_m_registry_lock};
+			auto result = _m_writers.find(rh.get_id());
+			if (result != _m_writers.cend()) {
+				return *result->second;
+			}
+		}
+		const std::unique_lock<std::shared_mutex> lock {_m_registry_lock};
+		auto& writer = _m_writers[rh.get_id()];
+		if (!writer) {
+			if (!std::experimental::filesystem::exists(dir)) {
+				std::experimental::filesystem::create_directory(dir);
+			}
+			writer = std::make_unique<columnar_log_writer>(dir / (rh.get_name() + ".cols"), rh);
+		}
+		return *writer;
+	}
+
+protected:
+	virtual void log(const std::vector<record>& r) override {
+		if (!r.empty()) {
+			get_writer(r[0].get_record_header()).append(r);
+		}
+	}
+
+	virtual void log(const record& r) override {
+		get_writer(r.get_record_header()).append(r);
+	}
+
+	virtual void log(const record_batch& batch) override {
+		get_writer(batch.header).append(batch);
+	}
+
+private:
+	static const std::experimental::filesystem::path dir;
+	std::unordered_map<std::size_t, std::unique_ptr<columnar_log_writer>> _m_writers;
+	std::shared_mutex _m_registry_lock;
+};
+
+const std::experimental::filesystem::path columnar_record_logger::dir {"metrics"};
+
+}
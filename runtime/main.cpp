@@ -47,37 +47,20 @@ static void sigint_handler([[maybe_unused]] int sig) {
 }
 
 
-class cancellable_sleep {
-public:
-	template <typename T, typename R>
-	bool sleep(std::chrono::duration<T, R> duration) {
-		auto wake_up_time = std::chrono::system_clock::now() + duration;
-		while (!_m_terminate.load() && std::chrono::system_clock::now() < wake_up_time) {
-			std::this_thread::sleep_for(std::chrono::milliseconds{100});
-		}
-		return _m_terminate.load();
-	}
-	void cancel() {
-		_m_terminate.store(true);
-	}
-private:
-	std::atomic<bool> _m_terminate {false};
-};
-
-
 int main(int argc, char* const* argv) {
+#ifndef NDEBUG
+    /// When debugging, register the SIGILL and SIGABRT handlers for capturing more info.
+    /// This comes before the runtime, so that its flight recorder hands these signals on to them.
+    std::signal(SIGILL, sigill_handler);
+    std::signal(SIGABRT, sigabrt_handler);
+#endif /// NDEBUG
+
 #ifdef ILLIXR_MONADO_MAINLINE
 	r = ILLIXR::runtime_factory();
 #else
 	r = ILLIXR::runtime_factory(nullptr);
 #endif /// ILLIXR_MONADO_MAINLINE
 
-#ifndef NDEBUG
-    /// When debugging, register the SIGILL and SIGABRT handlers for capturing more info
-    std::signal(SIGILL, sigill_handler);
-    std::signal(SIGABRT, sigabrt_handler);
-#endif /// NDEBUG
-
 	/// Shutting down method 1: Ctrl+C
     std::signal(SIGINT, sigint_handler);
 
@@ -95,7 +78,7 @@ int main(int argc, char* const* argv) {
     }
 #endif /// NDEBUG
 
-	/// Shutting down method 2: Run timer
+	/// Shutting down method 2: Run timer, on the runtime's clock (see ILLIXR_CLOCK)
 	std::chrono::seconds run_duration = 
 		getenv("ILLIXR_RUN_DURATION")
 		? std::chrono::seconds{std::stol(std::string{getenv("ILLIXR_RUN_DURATION")})}
@@ -110,16 +93,14 @@ int main(int argc, char* const* argv) {
 	RAC_ERRNO_MSG("main before loading dynamic libraries");
 	r->load_so(lib_paths);
 
-	cancellable_sleep cs;
 	std::thread th{[&]{
-		cs.sleep(run_duration);
+		// Returns early if something else stops the runtime
+		r->wait_for(run_duration);
 		r->stop();
 	}};
 
 	r->wait(); // blocks until shutdown is r->stop()
 
-	// cancel our sleep, so we can join the other thread
-	cs.cancel();
 	th.join();
 
 	delete r;
@@ -8,5 +8,12 @@ namespace ILLIXR {
 		virtual void log(const record& r) override {
 			r.mark_used();
 		}
+
+		virtual void log(const record_batch&) override { }
+
+	public:
+		virtual bool enabled() const override {
+			return false;
+		}
 	};
 }
@@ -11,9 +11,12 @@
 #include "noop_record_logger.hpp"
 #include "common/relative_clock.hpp"
 #include "sqlite_record_logger.hpp"
+#include "columnar_record_logger.hpp"
 #include "common/global_module_defs.hpp"
 #include "common/error_util.hpp"
 #include "common/stoplight.hpp"
+#include "common/thread_placement.hpp"
+#include "common/flight_recorder.hpp"
 
 using namespace ILLIXR;
 
@@ -24,14 +27,53 @@ public:
         GLXContext appGLCtx
 #endif /// ILLIXR_MONADO_MAINLINE
 	) {
-		pb.register_impl<record_logger>(std::make_shared<sqlite_record_logger>());
+		const std::string record_logger_name = getenv_or("ILLIXR_RECORD_LOGGER", "sqlite");
+		std::shared_ptr<record_logger> logger;
+		std::shared_ptr<sqlite_record_logger> sqlite_logger;
+		if (record_logger_name == "sqlite") {
+			logger = sqlite_logger = std::make_shared<sqlite_record_logger>();
+		} else if (record_logger_name == "columnar") {
+			logger = std::make_shared<columnar_record_logger>();
+		} else if (record_logger_name == "none") {
+			logger = std::make_shared<noop_record_logger>();
+		} else {
+			throw std::runtime_error{"ILLIXR_RECORD_LOGGER must be sqlite, columnar or none, not " + record_logger_name};
+		}
+		// Registered before anything which starts threads, which look it up.
+		auto placement = std::make_shared<thread_placement>(logger, getenv_or("ILLIXR_THREAD_PLACEMENT", ""));
+		pb.register_impl<thread_placement>(placement);
+		if (sqlite_logger) {
+			sqlite_logger->set_thread_placement(placement.get());
+		}
+		// Drains the records of hot threads; `drop` (the default) or `block` when a thread's ring is full.
+		const std::string log_overflow_name = getenv_or("ILLIXR_LOG_OVERFLOW", "drop");
+		if (log_overflow_name != "drop" && log_overflow_name != "block") {
+			throw std::runtime_error{"ILLIXR_LOG_OVERFLOW must be drop or block, not " + log_overflow_name};
+		}
+		auto flusher = std::make_shared<record_flusher>(
+			std::stoul(getenv_or("ILLIXR_LOG_RING_CAPACITY", "1024")),
+			log_overflow_name == "drop" ? log_overflow::drop : log_overflow::block,
+			[placement] { placement->apply("log_flusher"); }
+		);
+		pb.register_impl<record_flusher>(flusher);
+		// Keeps the last seconds of the hot-path records whatever the logger, to dump on anomalies.
+		const flight_recorder::config recorder_config = flight_recorder::config::from_env();
+		if (recorder_config.active()) {
+			auto recorder = std::make_shared<flight_recorder>(logger, recorder_config, flusher, [placement] { placement->apply("flight_recorder"); });
+			pb.register_impl<flight_recorder>(recorder);
+			logger = recorder;
+		}
+		pb.register_impl<record_logger>(logger);
 		pb.register_impl<gen_guid>(std::make_shared<gen_guid>());
-		pb.register_impl<switchboard>(std::make_shared<switchboard>(&pb));
+		// Registered before switchboard, which tells a virtual clock about pending events.
+		pb.register_impl<RelativeClock>(std::make_shared<RelativeClock>(make_clock_backend(getenv_or("ILLIXR_CLOCK", "real"))));
+		// 0 (the default) gives every switchboard subscription its own thread.
+		const std::size_t switchboard_threads = std::stoul(getenv_or("ILLIXR_SWITCHBOARD_THREADS", "0"));
+		pb.register_impl<switchboard>(std::make_shared<switchboard>(&pb, switchboard_threads));
 #ifndef ILLIXR_MONADO_MAINLINE
         pb.register_impl<xlib_gl_extended_window>(std::make_shared<xlib_gl_extended_window>(ILLIXR::FB_WIDTH, ILLIXR::FB_HEIGHT, appGLCtx));
 #endif /// ILLIXR_MONADO_MAINLINE
 		pb.register_impl<Stoplight>(std::make_shared<Stoplight>());
-		pb.register_impl<RelativeClock>(std::make_shared<RelativeClock>());
 	}
 
 	virtual void load_so(const std::vector<std::string>& so_paths) override {
@@ -84,11 +126,22 @@ public:
 		pb.lookup_impl<Stoplight>()->wait_for_shutdown_complete();
 	}
 
+	virtual void wait_for(std::chrono::nanoseconds run_duration) override {
+		pb.lookup_impl<RelativeClock>()->sleep_until(time_point{run_duration});
+	}
+
 	virtual void stop() override {
+		// Both the run timer and a signal may ask.
+		if (_m_stopping.exchange(true)) {
+			return;
+		}
 		pb.lookup_impl<Stoplight>()->signal_should_stop();
 		// After this point, threads may exit their main loops
 		// They still have destructors and still have to be joined.
 
+		pb.lookup_impl<RelativeClock>()->interrupt();
+		// After this point, threads sleeping on the clock wake up.
+
 		pb.lookup_impl<switchboard>()->stop();
 		// After this point, Switchboard's internal thread-workers which power synchronous callbacks are stopped and joined.
 
@@ -125,6 +178,7 @@ private:
 	std::vector<dynamic_lib> libs;
 	phonebook pb;
 	std::vector<std::unique_ptr<plugin>> plugins;
+	std::atomic<bool> _m_stopping {false};
 };
 
 #ifdef ILLIXR_MONADO_MAINLINE
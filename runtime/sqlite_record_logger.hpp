@@ -14,6 +14,7 @@
 #include "common/record_logger.hpp"
 #include "common/global_module_defs.hpp"
 #include "common/error_util.hpp"
+#include "common/thread_placement.hpp"
 
 /**
  * There are many SQLite3 wrapper libraries.
@@ -23,24 +24,48 @@
 
 namespace ILLIXR {
 
-class sqlite_thread {
-public:
-	sqlite3pp::database prep_db() {
-        RAC_ERRNO_MSG("sqlite_record_logger at start of prep_db");
+/**
+ * @brief How `sqlite_record_logger` writes its tables.
+ *
+ * Read from the environment:
+ *
+ * - `ILLIXR_SQLITE_MODE`: `stream` (the default) writes records in batched transactions while the
+ *   run goes on. `post_run` only queues them, and writes everything once the run is over, so the
+ *   disk stays quiet during the run but the queue grows without bound.
+ * - `ILLIXR_SQLITE_QUEUE_CAPACITY`: when streaming, the most records queued per writer (default
+ *   65536). A logger which finds the queue full waits for the writer to catch up.
+ * - `ILLIXR_SQLITE_WRITERS`: 0 (the default) gives every table a database and a writer thread of
+ *   its own. Otherwise, that many writer threads share the tables, which are dealt out to them in
+ *   the order they are first logged; each writer has a database of its own, since SQLite lets one
+ *   connection write to a database at a time. With one writer, every table is in
+ *   `metrics/records.sqlite`; with more, writer `i` writes `metrics/records_<i>.sqlite`.
+ */
+struct sqlite_config {
+	bool streaming;
+	std::size_t queue_capacity;
+	std::size_t writers;
 
-		if (!std::experimental::filesystem::exists(dir)) {
-			std::experimental::filesystem::create_directory(dir);
+	static sqlite_config from_env() {
+		const std::string mode = getenv_or("ILLIXR_SQLITE_MODE", "stream");
+		if (mode != "stream" && mode != "post_run") {
+			throw std::runtime_error{"ILLIXR_SQLITE_MODE must be stream or post_run, not " + mode};
 		}
-
-		const std::string path = dir / (table_name + std::string{".sqlite"});
-
-		RAC_ERRNO_MSG("sqlite_record_logger before sqlite3pp::database");
-        sqlite3pp::database db{path.c_str()};
-        RAC_ERRNO_MSG("sqlite_record_logger after sqlite3pp::database");
-
-		return db;
+		const std::size_t queue_capacity = std::stoul(getenv_or("ILLIXR_SQLITE_QUEUE_CAPACITY", "65536"));
+		if (queue_capacity == 0) {
+			throw std::runtime_error{"ILLIXR_SQLITE_QUEUE_CAPACITY must be positive"};
+		}
+		const std::size_t writers = std::stoul(getenv_or("ILLIXR_SQLITE_WRITERS", "0"));
+		return sqlite_config{mode == "stream", queue_capacity, writers};
 	}
+};
 
+/**
+ * @brief A table of records of one `record_header`, and the statement which inserts into it.
+ *
+ * Replaces any table of the same name in @p db.
+ */
+class sqlite_table {
+public:
 	std::string prep_insert_str() {
 		RAC_ERRNO_MSG("sqlite_record_logger at start of prep_insert_str");
 
@@ -89,34 +114,150 @@ public:
 		return insert_string;
 	}
 
-	sqlite_thread(const record_header& rh_)
-		: rh{rh_}
+	sqlite_table(sqlite3pp::database& db_, const record_header& rh_)
+		: db{db_}
+		, rh{rh_}
 		, table_name{rh.get_name()}
-		, db{prep_db()}
 		, insert_str{prep_insert_str()}
 		, insert_cmd{db, insert_str.c_str()}
+	{ }
+
+	/**
+	 * @brief Inserts @p r, within the caller's transaction.
+	 */
+	void insert(const record& r) {
+		sqlite3pp::command& cmd = insert_cmd;
+		for (unsigned int j = 0; j < rh.get_columns(); ++j) {
+			/*
+			  If you get a `std::bad_any_cast` here, make sure the user didn't lie about record.get_record_header().
+			  The types there should be the same as those in record.get_values().
+			*/
+			if (false) {
+			} else if (rh.get_column_type(j) == typeid(std::size_t)) {
+				cmd.bind(j+1, static_cast<long long>(r.get_value<std::size_t>(j)));
+			} else if (rh.get_column_type(j) == typeid(bool)) {
+				cmd.bind(j+1, static_cast<long long>(r.get_value<bool>(j)));
+			} else if (rh.get_column_type(j) == typeid(double)) {
+				cmd.bind(j+1, r.get_value<double>(j));
+			} else if (rh.get_column_type(j) == typeid(std::chrono::nanoseconds)) {
+				auto val = r.get_value<duration>(j);
+				cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
+			} else if (rh.get_column_type(j) == typeid(std::chrono::high_resolution_clock::time_point)) {
+				auto val = r.get_value<std::chrono::high_resolution_clock::time_point>(j).time_since_epoch();
+				cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
+			} else if (rh.get_column_type(j) == typeid(duration)) {
+				auto val = r.get_value<duration>(j);
+				cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
+			} else if (rh.get_column_type(j) == typeid(time_point)) {
+				auto val = r.get_value<time_point>(j).time_since_epoch();
+				cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
+			} else if (rh.get_column_type(j) == typeid(std::string)) {
+				// r.get_value<std::string>(j) returns a std::string temporary
+				// c_str() returns a pointer into that std::string temporary
+				// Therefore, need to copy.
+				cmd.bind(j+1, r.get_value<std::string>(j).c_str(), sqlite3pp::copy);
+			} else {
+				throw std::runtime_error{std::string{"type "} + std::string{rh.get_column_type(j).name()} + std::string{" not implemented"}};
+			}
+		}
+		RAC_ERRNO_MSG("sqlite_record_logger set errno before process cmd execute");
+
+		cmd.execute();
+		cmd.reset();
+		RAC_ERRNO_MSG("sqlite_record_logger after process cmd execute");
+		rows++;
+	}
+
+	const record_header& get_record_header() const {
+		return rh;
+	}
+
+	const std::string& get_name() const {
+		return table_name;
+	}
+
+	std::size_t get_rows() const {
+		return rows;
+	}
+
+private:
+	sqlite3pp::database& db;
+	const record_header& rh;
+	std::string table_name;
+	std::string insert_str;
+	sqlite3pp::command insert_cmd;
+	std::size_t rows {0};
+};
+
+/**
+ * @brief A database, and the thread which writes records of any number of tables into it.
+ *
+ * Each table is created the first time one of its records is written. Records are dequeued in
+ * bulk, and each bulk is written in one transaction, whichever tables its records are for.
+ */
+class sqlite_thread {
+public:
+	sqlite3pp::database prep_db() {
+        RAC_ERRNO_MSG("sqlite_record_logger at start of prep_db");
+
+		if (!std::experimental::filesystem::exists(dir)) {
+			std::experimental::filesystem::create_directory(dir);
+		}
+
+		const std::string path = dir / (db_name + std::string{".sqlite"});
+
+		RAC_ERRNO_MSG("sqlite_record_logger before sqlite3pp::database");
+        sqlite3pp::database db{path.c_str()};
+        RAC_ERRNO_MSG("sqlite_record_logger after sqlite3pp::database");
+
+		// These are metrics: losing the last records in a crash is acceptable, while stalling
+		// the writer on fsync is not.
+		db.execute("PRAGMA journal_mode=WAL;");
+		db.execute("PRAGMA synchronous=OFF;");
+		RAC_ERRNO_MSG("sqlite_record_logger after pragmas");
+
+		return db;
+	}
+
+	/**
+	 * @brief Writes `metrics/<db_name_>.sqlite` from a thread named `sqlite:<thread_name_>`.
+	 */
+	sqlite_thread(std::string thread_name_, std::string db_name_, const thread_placement* placement_, sqlite_config config_)
+		: thread_name{std::move(thread_name_)}
+		, db_name{std::move(db_name_)}
+		, db{prep_db()}
+		, config{config_}
+		, space{static_cast<moodycamel::LightweightSemaphore::ssize_t>(config.queue_capacity)}
+		, placement{placement_}
 		, thread{std::bind(&sqlite_thread::pull_queue, this)}
 	{ }
 
 	void pull_queue() {
-		const std::size_t max_record_batch_size = 1024 * 256;
+		// One transaction per batch
+		const std::size_t max_record_batch_size = 1024 * 16;
 		std::vector<record> record_batch {max_record_batch_size};
 		std::size_t actual_batch_size;
 
-		std::cout << "thread," << std::this_thread::get_id() << ",sqlite thread," << table_name << std::endl;
+		std::cout << "thread," << std::this_thread::get_id() << ",sqlite thread," << thread_name << std::endl;
+		if (placement) {
+			placement->apply("sqlite:" + thread_name);
+		}
 
+		const auto start = std::chrono::steady_clock::now();
 		std::size_t processed = 0;
 		while (!terminate.load()) {
-			std::this_thread::sleep_for(std::chrono::seconds{1});
-			// Uncomment this block to log in "real time";
-			// Otherwise, everything gets loged "post real time".
-			/*
-			const std::chrono::seconds max_record_match_wait_time {10};
-			actual_batch_size = queue.wait_dequeue_bulk_timed(record_batch.begin(), record_batch.size(), max_record_match_wait_time);
-			process(record_batch, actual_batch_size);
-			processed += actual_batch_size;
-			*/
+			if (config.streaming) {
+				// Wakes up now and then to check for termination
+				actual_batch_size = queue.wait_dequeue_bulk_timed(record_batch.begin(), record_batch.size(), std::chrono::milliseconds{100});
+				if (actual_batch_size) {
+					process(record_batch, actual_batch_size);
+					processed += actual_batch_size;
+				}
+			} else {
+				std::this_thread::sleep_for(std::chrono::milliseconds{100});
+			}
 		}
+		const auto terminated = std::chrono::steady_clock::now();
 
 		// We got the terminate commnad,
 		// So drain whatever is left in the queue.
@@ -126,63 +267,50 @@ public:
 			process(record_batch, actual_batch_size);
 			post_processed += actual_batch_size;
 		}
-		std::cerr << "Drained " << table_name << " (sqlite); " << post_processed << " / " << (processed + post_processed) << " done post real time" << std::endl;
+		// Nobody waits for space from now on (see reserve()); let go of anyone who already was.
+		space.signal(static_cast<moodycamel::LightweightSemaphore::ssize_t>(config.queue_capacity));
+
+		const std::chrono::duration<double> running = terminated - start;
+		const std::chrono::duration<double> draining = std::chrono::steady_clock::now() - terminated;
+		std::cerr << "Drained " << thread_name << " (sqlite); " << post_processed << " / " << (processed + post_processed) << " done post real time"
+				  << " in " << draining.count() << "s; " << static_cast<std::size_t>(processed / running.count()) << " records/s while running"
+				  << "; peak queue " << peak_queued.load() << " records, " << stalls.load() << " waits for space" << std::endl;
+		if (config.writers) {
+			for (const auto& pair : tables) {
+				std::cerr << "  " << pair.second.get_name() << ": " << pair.second.get_rows() << " records" << std::endl;
+			}
+		}
 	}
 
 	void process(const std::vector<record>& record_batch, std::size_t batch_size) {
 		sqlite3pp::transaction xct{db};
+		// Bulks mostly come from one coalescer, so consecutive records are mostly of one table.
+		sqlite_table* table = nullptr;
 		for (std::size_t i = 0; i < batch_size; ++i) {
-			// TODO(performance): reuse the sqlite3pp statement
-			// This currently has to be 'reinterpreted' for every iteration.
-			sqlite3pp::command cmd{db, insert_str.c_str()};
 			const record& r = record_batch[i];
-			for (unsigned int j = 0; j < rh.get_columns(); ++j) {
-				/*
-				  If you get a `std::bad_any_cast` here, make sure the user didn't lie about record.get_record_header().
-				  The types there should be the same as those in record.get_values().
-				*/
-				if (false) {
-				} else if (rh.get_column_type(j) == typeid(std::size_t)) {
-					cmd.bind(j+1, static_cast<long long>(r.get_value<std::size_t>(j)));
-				} else if (rh.get_column_type(j) == typeid(bool)) {
-					cmd.bind(j+1, static_cast<long long>(r.get_value<bool>(j)));
-				} else if (rh.get_column_type(j) == typeid(double)) {
-					cmd.bind(j+1, r.get_value<double>(j));
-				} else if (rh.get_column_type(j) == typeid(std::chrono::nanoseconds)) {
-					auto val = r.get_value<duration>(j);
-					cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
-				} else if (rh.get_column_type(j) == typeid(std::chrono::high_resolution_clock::time_point)) {
-					auto val = r.get_value<std::chrono::high_resolution_clock::time_point>(j).time_since_epoch();
-					cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
-				} else if (rh.get_column_type(j) == typeid(duration)) {
-					auto val = r.get_value<duration>(j);
-					cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
-				} else if (rh.get_column_type(j) == typeid(time_point)) {
-					auto val = r.get_value<time_point>(j).time_since_epoch();
-					cmd.bind(j+1, static_cast<long long>(std::chrono::nanoseconds{val}.count()));
-				} else if (rh.get_column_type(j) == typeid(std::string)) {
-					// r.get_value<std::string>(j) returns a std::string temporary
-					// c_str() returns a pointer into that std::string temporary
-					// Therefore, need to copy.
-					cmd.bind(j+1, r.get_value<std::string>(j).c_str(), sqlite3pp::copy);
-				} else {
-					throw std::runtime_error{std::string{"type "} + std::string{rh.get_column_type(j).name()} + std::string{" not implemented"}};
-				}
+			if (!table || &table->get_record_header() != &r.get_record_header()) {
+				table = &get_table(r.get_record_header());
 			}
-			RAC_ERRNO_MSG("sqlite_record_logger set errno before process cmd execute");
-
-			cmd.execute();
-			RAC_ERRNO_MSG("sqlite_record_logger after process cmd execute");
+			table->insert(r);
 		}
 		xct.commit();
+		dequeued(batch_size);
 	}
 
 	void put_queue(const std::vector<record>& buffer_in) {
-		queue.enqueue_bulk(buffer_in.begin(), buffer_in.size());
+		auto next = buffer_in.begin();
+		while (next != buffer_in.end()) {
+			const std::size_t count = reserve(static_cast<std::size_t>(buffer_in.end() - next));
+			queue.enqueue_bulk(next, count);
+			enqueued(count);
+			next += static_cast<std::ptrdiff_t>(count);
+		}
 	}
 
 	void put_queue(const record& record_in) {
+		reserve(1);
 		queue.enqueue(record_in);
+		enqueued(1);
 	}
 
 	~sqlite_thread() {
@@ -191,14 +319,63 @@ public:
 	}
 
 private:
+	/**
+	 * @brief The table for records of @p rh, created on first use. Only for the writer thread.
+	 */
+	sqlite_table& get_table(const record_header& rh) {
+		auto result = tables.find(rh.get_id());
+		if (result == tables.end()) {
+			result = tables.try_emplace(rh.get_id(), db, rh).first;
+		}
+		return result->second;
+	}
+
+	/**
+	 * @brief Waits until there is room in the queue for at least one of @p wanted records; returns how many fit.
+	 *
+	 * Only a streaming queue is bounded, and only until the writer terminates.
+	 */
+	std::size_t reserve(std::size_t wanted) {
+		if (!config.streaming || terminate.load()) {
+			return wanted;
+		}
+		const auto max = static_cast<moodycamel::LightweightSemaphore::ssize_t>(wanted);
+		moodycamel::LightweightSemaphore::ssize_t reserved = space.tryWaitMany(max);
+		if (reserved == 0) {
+			stalls++;
+			reserved = space.waitMany(max);
+		}
+		return static_cast<std::size_t>(reserved);
+	}
+
+	void enqueued(std::size_t count) {
+		const std::size_t now_queued = queued.fetch_add(count) + count;
+		std::size_t peak = peak_queued.load(std::memory_order_relaxed);
+		while (now_queued > peak && !peak_queued.compare_exchange_weak(peak, now_queued, std::memory_order_relaxed)) { }
+	}
+
+	void dequeued(std::size_t count) {
+		queued.fetch_sub(count);
+		if (config.streaming) {
+			space.signal(static_cast<moodycamel::LightweightSemaphore::ssize_t>(count));
+		}
+	}
+
 	static const std::experimental::filesystem::path dir;
-	const record_header& rh;
-	std::string table_name;
+	const std::string thread_name;
+	const std::string db_name;
 	sqlite3pp::database db;
-	std::string insert_str;
-	sqlite3pp::command insert_cmd;
+	// By record_header id; only the writer thread touches these.
+	std::unordered_map<std::size_t, sqlite_table> tables;
+	const sqlite_config config;
 	moodycamel::BlockingConcurrentQueue<record> queue;
+	// Free places in a streaming queue
+	moodycamel::LightweightSemaphore space;
+	std::atomic<std::size_t> queued {0};
+	std::atomic<std::size_t> peak_queued {0};
+	std::atomic<std::size_t> stalls {0};
 	std::atomic<bool> terminate {false};
+	const thread_placement* placement;
 	std::thread thread;
 };
 
@@ -212,12 +389,43 @@ private:
 			const std::shared_lock<std::shared_mutex> lock {_m_registry_lock};
 			auto result = registered_tables.find(rh.get_id());
 			if (result != registered_tables.cend()) {
-				return result->second;
+				return *result->second;
 			}
 		}
 		const std::unique_lock<std::shared_mutex> lock{_m_registry_lock};
-		auto pair = registered_tables.try_emplace(rh.get_id(), rh);
-		return pair.first->second;
+		auto pair = registered_tables.try_emplace(rh.get_id(), nullptr);
+		if (pair.second) {
+			pair.first->second = &make_sqlite_thread(rh);
+		}
+		return *pair.first->second;
+	}
+
+	/**
+	 * @brief The writer for the first records of @p rh. Requires unique state on _m_registry_lock.
+	 */
+	sqlite_thread& make_sqlite_thread(const record_header& rh) {
+		if (_m_config.writers == 0) {
+			return *_m_threads.emplace_back(std::make_unique<sqlite_thread>(rh.get_name(), rh.get_name(), _m_placement.load(), _m_config));
+		}
+		// Started with the first table, so that they are placed.
+		if (_m_threads.empty()) {
+			for (std::size_t i = 0; i < _m_config.writers; ++i) {
+				const std::string db_name = _m_config.writers == 1 ? "records" : "records_" + std::to_string(i);
+				_m_threads.push_back(std::make_unique<sqlite_thread>("writer_" + std::to_string(i), db_name, _m_placement.load(), _m_config));
+			}
+		}
+		// rh is already registered, so this deals the first table to writer 0.
+		return *_m_threads[(registered_tables.size() - 1) % _m_config.writers];
+	}
+
+public:
+	/**
+	 * @brief Names and places the threads of tables created from now on.
+	 *
+	 * Not owned, because @p placement logs to this logger.
+	 */
+	void set_thread_placement(const thread_placement* placement) {
+		_m_placement.store(placement);
 	}
 
 protected:
@@ -232,8 +440,12 @@ protected:
 	}
 
 private:
-	std::unordered_map<std::size_t, sqlite_thread> registered_tables;
+	const sqlite_config _m_config = sqlite_config::from_env();
+	std::vector<std::unique_ptr<sqlite_thread>> _m_threads;
+	// By record_header id
+	std::unordered_map<std::size_t, sqlite_thread*> registered_tables;
 	std::shared_mutex _m_registry_lock;
+	std::atomic<const thread_placement*> _m_placement {nullptr};
 };
 
 }
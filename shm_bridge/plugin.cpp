@@ -0,0 +1,95 @@
+#include <sstream>
+#include "common/plugin.hpp"
+#include "common/switchboard.hpp"
+#include "common/relative_clock.hpp"
+#include "common/global_module_defs.hpp"
+#include "common/shm_data_format.hpp"
+
+using namespace ILLIXR;
+
+/**
+ * @brief Shares topics with ILLIXR processes on the same host, through shared memory.
+ *
+ * - `ILLIXR_SHM_EXPORT_TOPICS`: comma-separated topics to mirror into shared memory (see `shm_export`).
+ * - `ILLIXR_SHM_IMPORT_TOPICS`: comma-separated topics to republish from another process's export
+ *   (see `shm_importer`). Nothing else in this process should publish them.
+ * - `ILLIXR_SHM_SLOTS` (default 16) and `ILLIXR_SHM_SLOT_SIZE` (default 1 MiB, enough for a pair of
+ *   752x480 camera images): the ring of each exported topic.
+ *
+ * Both sides find a topic's type from the plugins which use it, so each topic needs a reader or a
+ * writer in the process.
+ */
+class shm_bridge : public plugin {
+public:
+	shm_bridge(std::string name_, phonebook* pb_)
+		: plugin{name_, pb_}
+		, _m_sb{pb->lookup_impl<switchboard>()}
+		, _m_clock{pb->lookup_impl<RelativeClock>()}
+		, _m_types{data_format_shm_types()}
+	{ }
+
+	virtual void start() override {
+		plugin::start();
+
+		// Readers and writers are made in plugin constructors, so every topic has its type by now.
+		const std::size_t slots = std::stoul(ILLIXR::getenv_or("ILLIXR_SHM_SLOTS", "16"));
+		const std::size_t slot_size = std::stoul(ILLIXR::getenv_or("ILLIXR_SHM_SLOT_SIZE", "1048576"));
+		for (const std::string& topic_name : split(ILLIXR::getenv_or("ILLIXR_SHM_EXPORT_TOPICS", ""))) {
+			if (const std::type_info* type = find_type(topic_name)) {
+				_m_exports.emplace_back(topic_name, _m_types.export_topic(*type, *_m_sb, _m_clock, id, topic_name, slots, slot_size));
+			}
+		}
+		for (const std::string& topic_name : split(ILLIXR::getenv_or("ILLIXR_SHM_IMPORT_TOPICS", ""))) {
+			if (const std::type_info* type = find_type(topic_name)) {
+				_m_imports.emplace_back(topic_name, _m_types.import_topic(*type, _m_sb, _m_clock, topic_name));
+			}
+		}
+	}
+
+	virtual void stop() override {
+		for (const auto& [topic_name, ring] : _m_exports) {
+			if (ring->dropped() != 0) {
+				std::cerr << "shm_bridge: dropped " << ring->dropped() << " events exporting " << topic_name << std::endl;
+			}
+		}
+		for (const auto& [topic_name, importer] : _m_imports) {
+			if (importer->lost() != 0) {
+				std::cerr << "shm_bridge: lost " << importer->lost() << " events importing " << topic_name << std::endl;
+			}
+		}
+		// Stop publishing before the switchboard goes away.
+		_m_imports.clear();
+	}
+
+private:
+	const std::shared_ptr<switchboard> _m_sb;
+	const std::shared_ptr<RelativeClock> _m_clock;
+	const shm_topic_types _m_types;
+	std::vector<std::pair<std::string, std::shared_ptr<const shm_ring>>> _m_exports;
+	std::vector<std::pair<std::string, std::unique_ptr<shm_import>>> _m_imports;
+
+	static std::vector<std::string> split(const std::string& names) {
+		std::vector<std::string> result;
+		std::istringstream stream {names};
+		std::string name;
+		while (std::getline(stream, name, ',')) {
+			if (!name.empty()) {
+				result.push_back(name);
+			}
+		}
+		return result;
+	}
+
+	const std::type_info* find_type(const std::string& topic_name) const {
+		const std::type_info* type = _m_sb->topic_type(topic_name);
+		if (!type) {
+			std::cerr << "shm_bridge: no plugin uses topic " << topic_name << "; not sharing it" << std::endl;
+		} else if (!_m_types.has(type->name())) {
+			std::cerr << "shm_bridge: no shm_codec for " << type->name() << " on " << topic_name << "; not sharing it" << std::endl;
+			type = nullptr;
+		}
+		return type;
+	}
+};
+
+PLUGIN_MAIN(shm_bridge)
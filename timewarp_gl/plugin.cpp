@@ -21,19 +21,39 @@ using namespace ILLIXR;
 
 typedef void (*glXSwapIntervalEXTProc)(Display *dpy, GLXDrawable drawable, int interval);
 
-const record_header timewarp_gpu_record {"timewarp_gpu", {
-	{"iteration_no", typeid(std::size_t)},
-	{"wall_time_start", typeid(time_point)},
-	{"wall_time_stop" , typeid(time_point)},
-	{"gpu_time_duration", typeid(std::chrono::nanoseconds)},
+const typed_record_header<
+	std::size_t,
+	time_point,
+	time_point,
+	std::chrono::nanoseconds
+> timewarp_gpu_record {"timewarp_gpu", {
+	"iteration_no",
+	"wall_time_start",
+	"wall_time_stop",
+	"gpu_time_duration",
 }};
 
-const record_header mtp_record {"mtp_record", {
-	{"iteration_no", typeid(std::size_t)},
-	{"vsync", typeid(time_point)},
-	{"imu_to_display", typeid(std::chrono::nanoseconds)},
-	{"predict_to_display", typeid(std::chrono::nanoseconds)},
-	{"render_to_display", typeid(std::chrono::nanoseconds)},
+const typed_record_header<
+	std::size_t,
+	time_point,
+	std::chrono::nanoseconds,
+	std::chrono::nanoseconds,
+	std::chrono::nanoseconds
+> mtp_record {"mtp_record", {
+	"iteration_no",
+	"vsync",
+	"imu_to_display",
+	"predict_to_display",
+	"render_to_display",
+}};
+
+/// Logged when a frame is warped more than a vsync period after it was rendered
+const typed_record_header<
+	std::size_t,
+	std::chrono::nanoseconds
+> timewarp_stale_frame_record {"timewarp_stale_frame", {
+	"iteration_no",
+	"time_since_render",
 }};
 
 
@@ -51,12 +71,12 @@ public:
 		, pp{pb->lookup_impl<pose_prediction>()}
 		, xwin{pb->lookup_impl<xlib_gl_extended_window>()}
 		, _m_clock{pb->lookup_impl<RelativeClock>()}
-		, _m_eyebuffer{sb->get_reader<rendered_frame>("eyebuffer")}
-		, _m_hologram{sb->get_writer<hologram_input>("hologram_in")}
-		, _m_vsync_estimate{sb->get_writer<switchboard::event_wrapper<time_point>>("vsync_estimate")}
-		, _m_offload_data{sb->get_writer<texture_pose>("texture_pose")}
-		, timewarp_gpu_logger{record_logger_}
-		, mtp_logger{record_logger_}
+		, _m_eyebuffer{sb->get_reader(topics::eyebuffer)}
+		, _m_hologram{sb->get_writer(topics::hologram_in)}
+		, _m_vsync_estimate{sb->get_writer(topics::vsync_estimate)}
+		, _m_offload_data{sb->get_writer(topics::texture_pose)}
+		, timewarp_gpu_logger{record_logger_, timewarp_gpu_record, record_flusher_}
+		, mtp_logger{record_logger_, mtp_record, record_flusher_}
 		  // TODO: Use #198 to configure this. Delete getenv_or.
 		  // This is useful for experiments which seek to evaluate the end-effect of timewarp vs no-timewarp.
 		  // Timewarp poses a "second channel" by which pose data can correct the video stream,
@@ -97,8 +117,8 @@ private:
 	// Switchboard plug for publishing offloaded data
     switchboard::writer<texture_pose> _m_offload_data;
 
-	record_coalescer timewarp_gpu_logger;
-	record_coalescer mtp_logger;
+	decltype(timewarp_gpu_record)::coalescer timewarp_gpu_logger;
+	decltype(mtp_record)::coalescer mtp_logger;
 
 	GLuint timewarpShaderProgram;
 
@@ -645,9 +665,13 @@ public:
 
 		glEndQuery(GL_TIME_ELAPSED);
 
-#ifndef NDEBUG
 		const duration time_since_render = _m_clock->now() - most_recent_frame->render_time;
+		if (time_since_render > vsync_period) {
+			// Rare, so logged straight away; the flight recorder dumps on it.
+			record_logger_->log(typed_record{timewarp_stale_frame_record, iteration_no, std::chrono::nanoseconds{time_since_render}});
+		}
 
+#ifndef NDEBUG
 		if (log_count > LOG_PERIOD) {
             const double time_since_render_ms_d = duration2double<std::milli>(time_since_render);
             std::cout << "\033[1;36m[TIMEWARP]\033[0m Time since render: " << time_since_render_ms_d << "ms" << std::endl;
@@ -684,13 +708,13 @@ public:
 		std::chrono::nanoseconds predict_to_display = time_last_swap - latest_pose.predict_computed_time;
 		std::chrono::nanoseconds render_to_display = time_last_swap - most_recent_frame->render_time;
 
-		mtp_logger.log(record{mtp_record, {
-			{iteration_no},
-			{time_last_swap},
-			{imu_to_display},
-			{predict_to_display},
-			{render_to_display},
-		}});
+		mtp_logger.log(
+			iteration_no,
+			time_last_swap,
+			imu_to_display,
+			predict_to_display,
+			render_to_display
+		);
 
 		if (enable_offload) {
 			// Read texture image from texture buffer
@@ -740,12 +764,12 @@ public:
 		// get the query result
 		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
 
-		timewarp_gpu_logger.log(record{timewarp_gpu_record, {
-			{iteration_no},
-			{gpu_start_wall_time},
-			{_m_clock->now()},
-			{std::chrono::nanoseconds(elapsed_time)},
-		}});
+		timewarp_gpu_logger.log(
+			iteration_no,
+			gpu_start_wall_time,
+			_m_clock->now(),
+			std::chrono::nanoseconds(elapsed_time)
+		);
 
 #ifndef NDEBUG
 		if (log_count > LOG_PERIOD) {
@@ -0,0 +1,50 @@
+#include <sstream>
+#include "common/plugin.hpp"
+#include "common/switchboard.hpp"
+#include "common/relative_clock.hpp"
+#include "common/global_module_defs.hpp"
+#include "common/shm_data_format.hpp"
+
+using namespace ILLIXR;
+
+/**
+ * @brief Appends every event on the topics in `ILLIXR_RECORD_TOPICS` to the topic log at `ILLIXR_TOPIC_LOG`.
+ *
+ * `topic_replay` plays the log back.
+ */
+class topic_recorder : public plugin {
+public:
+	topic_recorder(std::string name_, phonebook* pb_)
+		: plugin{name_, pb_}
+		, _m_sb{pb->lookup_impl<switchboard>()}
+		, _m_clock{pb->lookup_impl<RelativeClock>()}
+		, _m_log{ILLIXR::getenv_or("ILLIXR_TOPIC_LOG", "metrics/topics.log")}
+		, _m_types{data_format_log_types()}
+	{ }
+
+	virtual void start() override {
+		plugin::start();
+
+		// Writers are made in plugin constructors, so every topic has its type by now.
+		std::istringstream topic_names {ILLIXR::getenv_or("ILLIXR_RECORD_TOPICS", "slow_pose,imu_integrator_input,eyebuffer")};
+		std::string topic_name;
+		while (std::getline(topic_names, topic_name, ',')) {
+			const std::type_info* type = _m_sb->topic_type(topic_name);
+			if (!type) {
+				std::cerr << "topic_recorder: no plugin uses topic " << topic_name << "; not recording it" << std::endl;
+			} else if (!_m_types.has(type->name())) {
+				std::cerr << "topic_recorder: no serializer for " << type->name() << " on " << topic_name << "; not recording it" << std::endl;
+			} else {
+				_m_types.record(*type, _m_log, *_m_sb, *_m_clock, id, topic_name);
+			}
+		}
+	}
+
+private:
+	const std::shared_ptr<switchboard> _m_sb;
+	const std::shared_ptr<const RelativeClock> _m_clock;
+	topic_log_writer _m_log;
+	const topic_log_types _m_types;
+};
+
+PLUGIN_MAIN(topic_recorder)
@@ -0,0 +1,83 @@
+#include <set>
+#include <sstream>
+#include "common/threadloop.hpp"
+#include "common/switchboard.hpp"
+#include "common/relative_clock.hpp"
+#include "common/global_module_defs.hpp"
+#include "common/shm_data_format.hpp"
+
+using namespace ILLIXR;
+
+/**
+ * @brief Republishes a log from `topic_recorder`.
+ *
+ * - `ILLIXR_TOPIC_LOG`: the log to play.
+ * - `ILLIXR_REPLAY_TOPICS`: a comma-separated subset of its topics (default: all of them).
+ * - `ILLIXR_REPLAY_SPEED`: 1 plays at the recorded times, 2 twice as fast, and so on; 0 plays as
+ *   fast as the subscribers allow.
+ */
+class topic_replay : public threadloop {
+public:
+	topic_replay(std::string name_, phonebook* pb_)
+		: threadloop{name_, pb_}
+		, _m_sb{pb->lookup_impl<switchboard>()}
+		, _m_clock{pb->lookup_impl<RelativeClock>()}
+		, _m_path{ILLIXR::getenv_or("ILLIXR_TOPIC_LOG", "metrics/topics.log")}
+		, _m_speed{std::stod(ILLIXR::getenv_or("ILLIXR_REPLAY_SPEED", "1"))}
+		, _m_log{topic_log_reader::open(_m_path)}
+	{
+		std::set<std::string> only;
+		std::istringstream topic_names {ILLIXR::getenv_or("ILLIXR_REPLAY_TOPICS", "")};
+		std::string topic_name;
+		while (std::getline(topic_names, topic_name, ',')) {
+			only.insert(topic_name);
+		}
+
+		// Declarations are spread through the log, so skim it once to make the writers up front,
+		// before other plugins look for the topics.
+		std::shared_ptr<topic_log_reader> skim = topic_log_reader::open(_m_path);
+		topic_log_reader::entry entry;
+		while (skim->next(entry)) { }
+
+		const topic_log_types types = data_format_log_types();
+		for (const topic_log_reader::topic_info& topic : skim->topics()) {
+			if (!only.empty() && only.count(topic.name) == 0) {
+				_m_publishers.emplace_back();
+			} else if (!types.has(topic.type_name)) {
+				std::cerr << "topic_replay: no deserializer for " << topic.type_name << " on " << topic.name << "; skipping it" << std::endl;
+				_m_publishers.emplace_back();
+			} else {
+				_m_publishers.push_back(types.make_publisher(topic.type_name, *_m_sb, topic.name));
+			}
+		}
+	}
+
+protected:
+	virtual skip_option _p_should_skip() override {
+		if (!_m_log->next(_m_entry)) {
+			return skip_option::stop;
+		}
+		if (_m_speed > 0) {
+			_m_clock->sleep_until(time_point{std::chrono::duration_cast<duration>(_m_entry.time.time_since_epoch() / _m_speed)});
+		}
+		return skip_option::run;
+	}
+
+	virtual void _p_one_iteration() override {
+		const topic_log_types::publisher& publish = _m_publishers[_m_entry.topic];
+		if (publish) {
+			publish(_m_entry.data, _m_entry.size, _m_log->pin());
+		}
+	}
+
+private:
+	const std::shared_ptr<switchboard> _m_sb;
+	const std::shared_ptr<const RelativeClock> _m_clock;
+	const std::string _m_path;
+	const double _m_speed;
+	const std::shared_ptr<topic_log_reader> _m_log;
+	std::vector<topic_log_types::publisher> _m_publishers;
+	topic_log_reader::entry _m_entry;
+};
+
+PLUGIN_MAIN(topic_replay)